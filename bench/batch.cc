@@ -0,0 +1,69 @@
+#include "../src/batch.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief row at a time run() against the columnar batch run()
+/// usage: bench_batch [rows]
+int main(int argc, char *argv[])
+{
+    typedef std::chrono::steady_clock Clock;
+    const std::size_t n = argc > 1 ? std::atol(argv[1]) : 1000000;
+    const char *corpus[] = {
+        "x * 3 + y", "(x - y) / (y + 1)", "x * x + y * y < 2500",
+        "x > 10 && y < 20 || x == y", "(x*3-1)^2 + (x*3-1)*y",
+        "name == \"abc\" && x > 3",
+    };
+    std::vector<double> x(n), y(n);
+    std::vector<Span> name(n);
+    const std::string names[] = {"abc", "abd", "a much longer name"};
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<double>(i % 97);
+        y[i] = static_cast<double>(i % 89) + 0.5;
+        name[i] = Span(names[i % 3]);
+    }
+    const std::vector<std::string> slots = {"name", "x", "y"};
+    const Column columns[] = {
+        Column(name.data()), Column(x.data()), Column(y.data())
+    };
+    double sink = 0;
+    std::cout << std::left << std::setw(32) << "expression"
+        << std::right << std::setw(12) << "row ns" << std::setw(12)
+        << "batch ns" << std::setw(10) << "speedup" << std::endl;
+    for (const auto str : corpus) {
+        std::istringstream s(str);
+        auto p = compile(Parser(s).parseExpr());
+        bindSlots(p, slots);
+        std::vector<Value> args(3);
+        std::string msg;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            args[0] = Value(name[i]);
+            args[1] = Value(x[i]);
+            args[2] = Value(y[i]);
+            const auto v = run(p, args.data(), msg);
+            sink += v.t() == Ast::T::NUMBER ? v.num() : v.b();
+        }
+        const double row = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count() / n;
+        ResultColumn out;
+        start = Clock::now();
+        run(p, columns, n, out);
+        const double batch = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count() / n;
+        sink += out.real[n / 2];
+        std::cout << std::left << std::setw(32) << str << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << row << std::setw(12) << batch
+            << std::setw(10) << row / batch << std::endl;
+    }
+    return sink == 0;
+}
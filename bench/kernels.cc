@@ -0,0 +1,79 @@
+#include "../src/kernels.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/// @brief every kernel of every supported Table against the scalar one
+/// usage: bench_kernels [rows]
+int main(int argc, char *argv[])
+{
+    typedef std::chrono::steady_clock Clock;
+    const std::size_t n = argc > 1 ? std::atol(argv[1]) : 1024;
+    const std::size_t total = 50000000;
+    const std::size_t repeat = total / n + 1;
+    const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+    std::vector<const kernels::Table *> tables;
+    for (const auto name : names) {
+        if (const auto t = kernels::find(name)) {
+            tables.push_back(t);
+        }
+    }
+    std::vector<double> l(n), r(n), out(n);
+    std::vector<unsigned char> bl(n), br(n), bout(n), zero(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        l[i] = static_cast<double>(i % 97) * 1.5 - 20;
+        r[i] = static_cast<double>(i % 89) + 0.5;
+        bl[i] = i & 1;
+        br[i] = (i >> 2) & 1;
+    }
+    std::cout << std::left << std::setw(8) << "kernel" << std::right;
+    for (const auto t : tables) {
+        std::cout << std::setw(10) << t->name;
+    }
+    std::cout << "   (ns per row)" << std::endl;
+    double sink = 0;
+#define BENCH(OP, CALL, SINK) \
+    std::cout << std::left << std::setw(8) << #OP << std::right\
+        << std::fixed << std::setprecision(3);\
+    for (const auto t : tables) {\
+        const auto start = Clock::now();\
+        for (std::size_t k = 0; k < repeat; ++k) {\
+            t->OP CALL;\
+        }\
+        const double ns = std::chrono::duration<double, std::nano>(\
+            Clock::now() - start).count() / (repeat * n);\
+        sink += SINK;\
+        std::cout << std::setw(10) << ns;\
+    }\
+    std::cout << std::endl;
+#define ARITHMETIC(OP) \
+    BENCH(OP, (l.data(), r.data(), out.data(), n), out[n / 2])
+#define CHECKED(OP) \
+    BENCH(OP, (l.data(), r.data(), out.data(), zero.data(), n), out[n / 2])
+#define COMPARE(OP) \
+    BENCH(OP, (l.data(), r.data(), bout.data(), n), bout[n / 2])
+#define LOGIC(OP) \
+    BENCH(OP, (bl.data(), br.data(), bout.data(), n), bout[n / 2])
+    ARITHMETIC(add)
+    ARITHMETIC(sub)
+    ARITHMETIC(mul)
+    CHECKED(div)
+    CHECKED(mod)
+    ARITHMETIC(pow)
+    BENCH(neg, (l.data(), out.data(), n), out[n / 2])
+    COMPARE(eq)
+    COMPARE(ne)
+    COMPARE(gt)
+    COMPARE(ge)
+    COMPARE(lt)
+    COMPARE(le)
+    LOGIC(land)
+    LOGIC(lor)
+    LOGIC(beq)
+    LOGIC(bne)
+    BENCH(lnot, (bl.data(), bout.data(), n), bout[n / 2])
+    return sink == 0;
+}
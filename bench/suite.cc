@@ -0,0 +1,530 @@
+#include "../src/interface.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <parameter.h> // ariadne code
+
+/// @brief parse, startup, eval and threading benchmarks over synthetic
+/// corpora, written as JSON and/or CSV to compare runs of different commits
+/// usage: bench_suite [--size n] [--depth d] [--threads t] [--seed s]
+///     [--min-ms ms] [--label text] [--json file] [--csv file]
+/// without --json and --csv the JSON goes to stdout
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+    std::size_t size = 256;   ///< expressions per corpus
+    unsigned depth = 10;      ///< depth of the long expressions
+    unsigned threads = 0;     ///< most threads to scale to, 0 for all cores
+    unsigned seed = 1;
+    double minMs = 200;       ///< least time to measure each case for
+    std::string label;
+    std::string json;
+    std::string csv;
+};
+
+struct Result
+{
+    std::string group;
+    std::string name;
+    std::size_t ops;          ///< operations per measured round
+    double ns;                ///< per operation
+    double bytes;             ///< per operation, 0 if not applicable
+};
+
+// keeps the compiler from dropping the measured code
+volatile double sink;
+
+/// @brief runs f, which performs ops operations, until at least minMs
+/// passed and returns the ns per operation
+template <class F>
+double measure(const Options &o, std::size_t ops, F f)
+{
+    f();
+    std::size_t rounds = 1;
+    for (;;) {
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < rounds; ++i) {
+            f();
+        }
+        const double ns = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        if (ns >= o.minMs * 1e6 || rounds >= (std::size_t(1) << 30)) {
+            return ns / (rounds * ops);
+        }
+        rounds *= 2;
+    }
+}
+
+/// @brief random expressions of x0 .. x7, s0 .. s1 and literals
+class Generator
+{
+public:
+    explicit Generator(unsigned seed) : rng_(seed) {}
+
+    std::string number(unsigned depth)
+    {
+        if (depth == 0 || pick(4) == 0) {
+            return pick(2) ? "x" + std::to_string(pick(8))
+                : std::to_string(pick(100) + 1);
+        }
+        static const char *const ops[] = {" + ", " - ", " * ", " / "};
+        return "(" + number(depth - 1) + ops[pick(4)] + number(depth - 1)
+            + ")";
+    }
+
+    std::string boolean(unsigned depth)
+    {
+        if (depth <= 1 || pick(4) == 0) {
+            static const char *const cmp[] = {" < ", " <= ", " > ", " >= "};
+            if (pick(4) == 0) {
+                return "s" + std::to_string(pick(2)) + " == \"v"
+                    + std::to_string(pick(4)) + "\"";
+            }
+            return number(depth ? depth - 1 : 0) + cmp[pick(4)]
+                + number(depth ? depth - 1 : 0);
+        }
+        return "(" + boolean(depth - 1) + (pick(2) ? " && " : " || ")
+            + boolean(depth - 1) + ")";
+    }
+
+    std::vector<std::string> corpus(std::size_t n, unsigned depth)
+    {
+        std::vector<std::string> c(n);
+        for (auto &s : c) {
+            s = pick(2) ? number(depth) : boolean(depth);
+        }
+        return c;
+    }
+
+private:
+    unsigned pick(unsigned n)
+    {
+        return std::uniform_int_distribution<unsigned>(0, n - 1)(rng_);
+    }
+
+    std::mt19937 rng_;
+};
+
+std::shared_ptr<parameter> real(double v)
+{
+    auto p = std::make_shared<parameter>(PT_REAL);
+    p->setValueReal(v);
+    return p;
+}
+
+std::shared_ptr<parameter> string(const std::string &v)
+{
+    auto p = std::make_shared<parameter>(PT_STRING);
+    p->setValueString(v);
+    return p;
+}
+
+Expression::Dict event()
+{
+    Expression::Dict dict;
+    for (int i = 0; i < 8; ++i) {
+        dict["x" + std::to_string(i)] = real(i * 1.5 + 1);
+    }
+    dict["s0"] = string("v1");
+    dict["s1"] = string("a value too long to be kept inline");
+    return dict;
+}
+
+Value::Dict values(const Expression::Dict &dict)
+{
+    Value::Dict v;
+    for (const auto &d : dict) {
+        if (d.second->getType() == PT_REAL) {
+            v[d.first] = Value(d.second->getValueReal());
+        } else {
+            v[d.first] = Value(d.second->getValueString());
+        }
+    }
+    return v;
+}
+
+// parsing alone and parsing with everything Expression does after it
+void parse(const Options &o, std::vector<Result> &results)
+{
+    Generator g(o.seed);
+    const struct {
+        const char *name;
+        unsigned depth;
+    } corpora[] = {{"short", 2}, {"long", o.depth}};
+    for (const auto &c : corpora) {
+        const auto corpus = g.corpus(o.size, c.depth);
+        double bytes = 0;
+        for (const auto &s : corpus) {
+            bytes += s.size();
+        }
+        bytes /= corpus.size();
+        const double parse = measure(o, corpus.size(), [&] {
+            for (const auto &s : corpus) {
+                sink = sink + static_cast<bool>(
+                    Parser(s.data(), s.size()).parseExpr());
+            }
+        });
+        results.push_back({"parse", c.name, corpus.size(), parse, bytes});
+        const double build = measure(o, corpus.size(), [&] {
+            for (const auto &s : corpus) {
+                sink = sink + static_cast<bool>(Expression(s));
+            }
+        });
+        results.push_back({"build", c.name, corpus.size(), build, bytes});
+    }
+}
+
+// making the Expressions of a corpus from their text against loading the
+// binary form Expression::save() gave, bytes are the ones read per one
+void startup(const Options &o, std::vector<Result> &results)
+{
+    Generator g(o.seed);
+    const struct {
+        const char *name;
+        unsigned depth;
+    } corpora[] = {{"short", 2}, {"long", o.depth}};
+    for (const auto &c : corpora) {
+        const auto corpus = g.corpus(o.size, c.depth);
+        double bytes = 0;
+        for (const auto &s : corpus) {
+            bytes += s.size();
+        }
+        const std::size_t n = corpus.size();
+        const double text = measure(o, n, [&] {
+            std::vector<Expression> expressions;
+            expressions.reserve(n);
+            for (const auto &s : corpus) {
+                expressions.emplace_back(s);
+            }
+            sink = sink + expressions.size();
+        });
+        results.push_back({"startup", std::string("text ") + c.name, n, text,
+            bytes / n});
+        std::vector<Expression> parsed(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            parsed[i].keepSource(true);
+            parsed[i].parse(corpus[i]);
+        }
+        for (const bool source : {true, false}) {
+            const std::string data = Expression::save(parsed, source);
+            const double load = measure(o, n, [&] {
+                std::vector<Expression> expressions;
+                sink = sink + Expression::load(data.data(), data.size(),
+                    expressions);
+            });
+            results.push_back({"startup", std::string(source ? "binary "
+                : "binary bare ") + c.name, n, load,
+                static_cast<double>(data.size()) / n});
+        }
+    }
+}
+
+// one operator on bound symbols, run on values in slot order
+void operators(const Options &o, std::vector<Result> &results)
+{
+    const char *const exprs[] = {
+        "x + y", "x - y", "x * y", "x / y", "x % y", "x ^ y", "-x",
+        "x == y", "x != y", "x < y", "x <= y", "x > y", "x >= y",
+        "b && c", "b || c", "!b", "b == c", "s + t", "s < t", "s == t",
+        "s * x",
+    };
+    Value::Dict dict;
+    dict["x"] = Value(7.5);
+    dict["y"] = Value(2.0);
+    dict["b"] = Value(true);
+    dict["c"] = Value(false);
+    dict["s"] = Value(std::string("abc"));
+    dict["t"] = Value(std::string("abd"));
+    const std::size_t ops = 1000;
+    for (const auto str : exprs) {
+        const Program p = compile(Parser(str, std::strlen(str)).parseExpr());
+        std::vector<Value> args(p.symbols.size());
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            args[i] = dict[p.symbols[i]];
+        }
+        std::string msg;
+        const double ns = measure(o, ops, [&] {
+            for (std::size_t i = 0; i < ops; ++i) {
+                sink = sink + static_cast<bool>(run(p, args.data(), msg));
+            }
+        });
+        results.push_back({"operator", str, ops, ns, 0});
+    }
+}
+
+// text made of numbers and strings, and parsing of number literals
+void strings(const Options &o, std::vector<Result> &results)
+{
+    const char *const exprs[] = {
+        "s + x", "x + s", "\"id-\" + x + \"-\" + y", "s + t + s + t",
+        "s * 4", "s * 16",
+    };
+    Value::Dict dict;
+    dict["x"] = Value(0.1);
+    dict["y"] = Value(12345.0);
+    dict["s"] = Value(std::string("abc"));
+    dict["t"] = Value(std::string("def"));
+    const std::size_t ops = 1000;
+    for (const auto str : exprs) {
+        const Program p = compile(Parser(str, std::strlen(str)).parseExpr());
+        std::vector<Value> args(p.symbols.size());
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            args[i] = dict[p.symbols[i]];
+        }
+        std::string msg;
+        const double ns = measure(o, ops, [&] {
+            for (std::size_t i = 0; i < ops; ++i) {
+                sink = sink + static_cast<bool>(run(p, args.data(), msg));
+            }
+        });
+        results.push_back({"strings", str, ops, ns, 0});
+    }
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<double> d(-1e6, 1e6);
+    std::string text = "0";
+    for (std::size_t i = 0; i < o.size; ++i) {
+        std::ostringstream os;
+        os.precision(17);
+        os << " + " << std::abs(d(rng)) << " * x";
+        text += os.str();
+    }
+    const double parse = measure(o, 1, [&] {
+        sink = sink + static_cast<bool>(
+            Parser(text.data(), text.size()).parseExpr());
+    });
+    results.push_back({"strings", "parse numbers", 1, parse,
+        static_cast<double>(text.size())});
+}
+
+// the vm on Values against eval() converting from and to parameters
+void interface(const Options &o, std::vector<Result> &results)
+{
+    Generator g(o.seed + 1);
+    const auto corpus = g.corpus(o.size, 3);
+    const auto dict = event();
+    const auto vdict = values(dict);
+    std::vector<Program> programs;
+    std::vector<Expression> expressions;
+    std::vector<std::vector<Value> > vargs;
+    std::vector<Expression::Args> pargs;
+    for (const auto &s : corpus) {
+        programs.push_back(compile(Parser(s.data(), s.size()).parseExpr()));
+        expressions.emplace_back(s);
+        const auto &p = programs.back();
+        vargs.emplace_back(p.symbols.size());
+        for (std::size_t i = 0; i < p.symbols.size(); ++i) {
+            vargs.back()[i] = vdict.at(p.symbols[i]);
+        }
+        pargs.emplace_back();
+        for (const auto &slot : expressions.back().slots()) {
+            pargs.back().push_back(dict.at(slot));
+        }
+    }
+    const std::size_t n = corpus.size();
+    std::string msg;
+    results.push_back({"interface", "vm", n, measure(o, n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            sink = sink + static_cast<bool>(
+                run(programs[i], vargs[i].data(), msg));
+        }
+    }), 0});
+    results.push_back({"interface", "eval args", n, measure(o, n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            sink = sink + static_cast<bool>(
+                expressions[i].eval(pargs[i]).first);
+        }
+    }), 0});
+    results.push_back({"interface", "eval dict", n, measure(o, n, [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            sink = sink + static_cast<bool>(expressions[i].eval(dict).first);
+        }
+    }), 0});
+}
+
+// eval() of shared Expressions on 1, 2, 4 ... threads, ns of wall time
+void threads(const Options &o, std::vector<Result> &results)
+{
+    Generator g(o.seed + 2);
+    const auto corpus = g.corpus(o.size, 4);
+    std::vector<Expression> expressions(corpus.begin(), corpus.end());
+    const auto dict = event();
+    const unsigned most = o.threads ? o.threads
+        : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; ; t = t * 2 > most && t < most ? most : t * 2) {
+        const std::size_t rounds = 16;
+        const std::size_t ops = t * rounds * expressions.size();
+        const double ns = measure(o, ops, [&] {
+            std::vector<std::thread> pool;
+            std::vector<double> found(t);
+            for (unsigned k = 0; k < t; ++k) {
+                pool.emplace_back([&, k] {
+                    for (std::size_t r = 0; r < rounds; ++r) {
+                        for (const auto &e : expressions) {
+                            found[k] += static_cast<bool>(e.eval(dict).first);
+                        }
+                    }
+                });
+            }
+            for (unsigned k = 0; k < t; ++k) {
+                pool[k].join();
+                sink = sink + found[k];
+            }
+        });
+        results.push_back({"threads", std::to_string(t), ops, ns, 0});
+        if (t >= most) {
+            break;
+        }
+    }
+}
+
+std::string quote(const std::string &s)
+{
+    std::string q = "\"";
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            q += '\\';
+        }
+        q += c;
+    }
+    return q + '"';
+}
+
+// a CSV field, " is doubled
+std::string csvQuote(const std::string &s)
+{
+    std::string q = "\"";
+    for (const char c : s) {
+        if (c == '"') {
+            q += '"';
+        }
+        q += c;
+    }
+    return q + '"';
+}
+
+void json(std::ostream &os, const Options &o, const std::vector<Result> &r)
+{
+    os << "{\n  \"label\": " << quote(o.label)
+        << ",\n  \"size\": " << o.size << ",\n  \"depth\": " << o.depth
+        << ",\n  \"seed\": " << o.seed << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < r.size(); ++i) {
+        os << "    {\"group\": " << quote(r[i].group)
+            << ", \"name\": " << quote(r[i].name)
+            << ", \"ops\": " << r[i].ops
+            << ", \"ns_per_op\": " << r[i].ns
+            << ", \"ops_per_s\": " << 1e9 / r[i].ns;
+        if (r[i].bytes) {
+            os << ", \"mb_per_s\": " << r[i].bytes * 1e3 / r[i].ns;
+        }
+        os << (i + 1 < r.size() ? "},\n" : "}\n");
+    }
+    os << "  ]\n}\n";
+}
+
+void csv(std::ostream &os, const Options &o, const std::vector<Result> &r)
+{
+    os << "label,group,name,ops,ns_per_op,ops_per_s,mb_per_s\n";
+    for (const auto &i : r) {
+        os << csvQuote(o.label) << ',' << i.group << ','
+            << csvQuote(i.name)
+            << ',' << i.ops << ',' << i.ns << ',' << 1e9 / i.ns << ',';
+        if (i.bytes) {
+            os << i.bytes * 1e3 / i.ns;
+        }
+        os << '\n';
+    }
+}
+
+bool options(int argc, char *argv[], Options &o)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string key = argv[i];
+        const char *v = argv[i + 1];
+        if (key == "--size") {
+            o.size = std::max(1l, std::atol(v));
+        } else if (key == "--depth") {
+            o.depth = std::atoi(v);
+        } else if (key == "--threads") {
+            o.threads = std::atoi(v);
+        } else if (key == "--seed") {
+            o.seed = std::atoi(v);
+        } else if (key == "--min-ms") {
+            o.minMs = std::atof(v);
+        } else if (key == "--label") {
+            o.label = v;
+        } else if (key == "--json") {
+            o.json = v;
+        } else if (key == "--csv") {
+            o.csv = v;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+bool write(
+    const std::string &file,
+    void (*f)(std::ostream &, const Options &, const std::vector<Result> &),
+    const Options &o,
+    const std::vector<Result> &r
+)
+{
+    std::ofstream os(file);
+    f(os, o, r);
+    if (!os) {
+        std::cerr << "Error: cannot write " << file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options o;
+    if (!options(argc, argv, o)) {
+        std::cerr << "usage: " << argv[0] << " [--size n] [--depth d]"
+            " [--threads t] [--seed s] [--min-ms ms] [--label text]"
+            " [--json file] [--csv file]" << std::endl;
+        return 1;
+    }
+    std::vector<Result> results;
+    parse(o, results);
+    startup(o, results);
+    operators(o, results);
+    strings(o, results);
+    interface(o, results);
+    threads(o, results);
+    if (o.json.empty() && o.csv.empty()) {
+        json(std::cout, o, results);
+    }
+    bool ok = true;
+    if (!o.json.empty()) {
+        ok &= write(o.json, json, o, results);
+    }
+    if (!o.csv.empty()) {
+        ok &= write(o.csv, csv, o, results);
+    }
+    return ok ? 0 : 2;
+}
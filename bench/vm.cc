@@ -0,0 +1,83 @@
+#include "../src/ast.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+#include "../t/corpus.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief tree walking eval() against the bytecode vm on the test corpus,
+/// the vm once with a dictionary and once with values in slot order
+/// usage: bench_vm [iterations]
+int main(int argc, char *argv[])
+{
+    typedef std::chrono::steady_clock Clock;
+    const long n = argc > 1 ? std::atol(argv[1]) : 100000;
+    Ast::Dict dict;
+    dict["a"] = Ast::make(2.0);
+    dict["a.f()"] = Ast::make(1.0);
+    Value::Dict values;
+    values["a"] = Value(2.0);
+    values["a.f()"] = Value(1.0);
+    double treeTotal = 0;
+    double vmTotal = 0;
+    double slotTotal = 0;
+    std::size_t sink = 0;
+    std::cout << std::left << std::setw(48) << "expression"
+        << std::right << std::setw(12) << "tree ns" << std::setw(12) << "vm ns"
+        << std::setw(12) << "slot ns" << std::setw(10) << "speedup"
+        << std::endl;
+    for (const auto str : evalCorpus) {
+        std::istringstream s(str);
+        const auto t = Parser(s).parseExpr();
+        const auto p = compile(t);
+        std::string msg;
+        auto start = Clock::now();
+        for (long i = 0; i < n; ++i) {
+            sink += static_cast<bool>(eval(t, dict, msg));
+        }
+        const double tree = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count() / n;
+        start = Clock::now();
+        for (long i = 0; i < n; ++i) {
+            sink += static_cast<bool>(run(p, values, msg));
+        }
+        const double vm = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count() / n;
+        std::vector<Value> args(p.symbols.size());
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            const auto v = values.find(p.symbols[i]);
+            if (v != values.end()) {
+                args[i] = v->second;
+            }
+        }
+        start = Clock::now();
+        for (long i = 0; i < n; ++i) {
+            sink += static_cast<bool>(run(p, args.data(), msg));
+        }
+        const double slot = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count() / n;
+        treeTotal += tree;
+        vmTotal += vm;
+        slotTotal += slot;
+        std::cout << std::left << std::setw(48) << str << std::right
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << tree << std::setw(12) << vm
+            << std::setw(12) << slot
+            << std::setprecision(2) << std::setw(10) << tree / slot
+            << std::endl;
+    }
+    std::cout << std::left << std::setw(48) << "total" << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << treeTotal << std::setw(12) << vmTotal
+        << std::setw(12) << slotTotal
+        << std::setprecision(2) << std::setw(10) << treeTotal / slotTotal
+        << std::endl;
+    return sink == 0;
+}
@@ -0,0 +1,22 @@
+#ifndef HEADER_87CD8B7A0C6C4E55B813221158F945FA
+#define HEADER_87CD8B7A0C6C4E55B813221158F945FA
+
+#include <climits>
+
+/// @brief static_cast<int> with a defined result for every double
+/// @note NaN and values outside of the int range give INT_MIN, which is
+/// what the x86 conversion instructions return for them.
+inline int truncate(double v)
+{
+    return v > -2147483649.0 && v < 2147483648.0
+        ? static_cast<int>(v) : INT_MIN;
+}
+
+/// @brief a % d as double, d must not be 0
+/// @note INT_MIN % -1 overflows, any value % -1 is 0.
+inline double modulo(int a, int d)
+{
+    return d == -1 ? 0 : static_cast<double>(a % d);
+}
+
+#endif
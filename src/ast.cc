@@ -1,29 +1,38 @@
 #include "ast.h"
+#include "arith.h"
+#include "instrument.h"
+#include "number.h"
+#include "value.h"
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <cassert>
-#include <sstream>
 #include <cmath>
-#include <limits>
 
 Ast::Ast() : t(Ast::T::UNKNOWN)
 {
+    INSTRUMENT_COUNT(NODES);
 }
 
 Ast::Ast(double v) : t(Ast::T::NUMBER), num(v)
 {
+    INSTRUMENT_COUNT(NODES);
 }
 
-Ast::Ast(const std::string &s) : t(Ast::T::UNKNOWN), str(s)
+Ast::Ast(Atom s) : t(Ast::T::UNKNOWN), str(s)
 {
+    INSTRUMENT_COUNT(NODES);
 }
 
 Ast::Ast(Ast::O o) : t(Ast::T::OPERATOR), op(o)
 {
+    INSTRUMENT_COUNT(NODES);
 }
 
 Ast::Ast(bool b) : t(Ast::T::BOOLEAN), b(b)
 {
+    INSTRUMENT_COUNT(NODES);
 }
 
 std::unique_ptr<Ast> Ast::make(Ast::O o)
@@ -36,20 +45,30 @@ std::unique_ptr<Ast> Ast::make(double v)
     return std::unique_ptr<Ast>(new Ast(v));
 }
 
-std::unique_ptr<Ast> Ast::makeString(const std::string &s)
+std::unique_ptr<Ast> Ast::makeString(Span s)
 {
-    auto r = std::unique_ptr<Ast>(new Ast(s));
+    auto r = std::unique_ptr<Ast>(new Ast(Atom(s)));
     r->t =Ast::T::STRING;
     return std::unique_ptr<Ast>(std::move(r));
 }
 
-std::unique_ptr<Ast> Ast::makeSymbol(const std::string &s)
+std::unique_ptr<Ast> Ast::makeString(const std::string &s)
+{
+    return makeString(Span(s));
+}
+
+std::unique_ptr<Ast> Ast::makeSymbol(Span s)
 {
-    auto r = std::unique_ptr<Ast>(new Ast(s));
+    auto r = std::unique_ptr<Ast>(new Ast(Atom(s)));
     r->t =Ast::T::SYMBOL;
     return std::unique_ptr<Ast>(std::move(r));
 }
 
+std::unique_ptr<Ast> Ast::makeSymbol(const std::string &s)
+{
+    return makeSymbol(Span(s));
+}
+
 std::unique_ptr<Ast> Ast::make(bool b)
 {
     return std::unique_ptr<Ast>(new Ast(b));
@@ -74,6 +93,27 @@ std::set<std::string> symbols(const Ast::Ptr &p)
     return s;
 }
 
+static void atomsImpl(const Ast::Ptr &p, std::vector<Atom> &s)
+{
+    if (!p) {
+        return;
+    }
+    if (p->t == Ast::T::SYMBOL) {
+        s.push_back(p->str);
+    }
+    atomsImpl(p->left, s);
+    atomsImpl(p->right, s);
+}
+
+std::vector<Atom> atoms(const Ast::Ptr &p)
+{
+    std::vector<Atom> s;
+    atomsImpl(p, s);
+    std::sort(s.begin(), s.end(), before);
+    s.erase(std::unique(s.begin(), s.end()), s.end());
+    return s;
+}
+
 static const char *toString(Ast::T t)
 {
     switch (t) {
@@ -93,351 +133,351 @@ static const char *toString(Ast::T t)
 }
 
 static std::string opError(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+    const Value &l,
+    const Value &r,
     const char *opDesc
 )
 {
+    INSTRUMENT_COUNT(TYPE_ERRORS);
     std::string msg = "cannot ";
     msg += opDesc;
     msg += " ";
-    msg += toString(l->t);
+    msg += toString(l.t());
     msg += " and ";
-    msg += toString(r->t);
+    msg += toString(r.t());
     return msg;
 }
 
-static Ast::Ptr aadd(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+// the joined strings, built in place if the result is kept inline
+static Value concat(Span a, Span b)
+{
+    if (a.n + b.n <= Value::SMALL) {
+        char buf[Value::SMALL];
+        std::copy(a.p, a.p + a.n, buf);
+        std::copy(b.p, b.p + b.n, buf + a.n);
+        return Value(Span(buf, a.n + b.n));
+    }
+    std::string s;
+    s.reserve(a.n + b.n);
+    s.append(a.p, a.n);
+    s.append(b.p, b.n);
+    return Value(std::move(s));
+}
+
+// s written n times, empty if n is not positive
+static Value repeat(Span s, int n)
+{
+    const std::size_t size = n > 0 ? static_cast<std::size_t>(n) * s.n : 0;
+    if (size <= Value::SMALL) {
+        char buf[Value::SMALL];
+        for (std::size_t i = 0; i < size; i += s.n) {
+            std::copy(s.p, s.p + s.n, buf + i);
+        }
+        return Value(Span(buf, size));
+    }
+    std::string r;
+    r.reserve(size);
+    for (int i = 0; i < n; ++i) {
+        r.append(s.p, s.n);
+    }
+    return Value(std::move(r));
+}
+
+static Value aadd(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "add";
-    std::ostringstream os;
-    os.precision(std::numeric_limits<double>::max_digits10);
-    switch (l->t) {
+    char buf[NUMBER_CHARS];
+    switch (l.t()) {
         case Ast::T::NUMBER:
-            switch (r->t) {
+            switch (r.t()) {
                 case Ast::T::NUMBER:
-                    return Ast::make(l->num + r->num);
+                    return Value(l.num() + r.num());
                 case Ast::T::STRING:
-                    os << l->num;
-                    os << r->str;
-                    return Ast::makeString(os.str());
+                    return concat(formatNumber(l.num(), buf), r.span());
                 default:
                     break;
             }
         case Ast::T::STRING:
-            os << l->str;
-            switch (r->t) {
+            switch (r.t()) {
                 case Ast::T::NUMBER:
-                    os << r->num;
-                    return Ast::makeString(os.str());
+                    return concat(l.span(), formatNumber(r.num(), buf));
                 case Ast::T::STRING:
-                    os << r->str;
-                    return Ast::makeString(os.str());
+                    return concat(l.span(), r.span());
                 default:
                     break;
             }
         default:
             msg = opError(l,r, opDesc);
-            return nullptr;
+            return Value();
     }
 }
 
-static Ast::Ptr asub(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value asub(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "subtract";
-    std::ostringstream os;
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        return Ast::make(l->num - r->num);
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        return Value(l.num() - r.num());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr amul(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value amul(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "add";
-    std::ostringstream os;
-    switch (l->t) {
+    switch (l.t()) {
         case Ast::T::NUMBER:
-            switch (r->t) {
+            switch (r.t()) {
                 case Ast::T::NUMBER:
-                    return Ast::make(l->num * r->num);
+                    return Value(l.num() * r.num());
                 case Ast::T::STRING:
-                    for (int i = 0; i < static_cast<int>(l->num); ++i) {
-                        os << r->str;
-                    }
-                    return Ast::makeString(os.str());
+                    return repeat(r.span(), static_cast<int>(l.num()));
                 default:
                     break;
             }
         case Ast::T::STRING:
-            switch (r->t) {
+            switch (r.t()) {
                 case Ast::T::NUMBER:
-                    for (int i = 0; i < static_cast<int>(r->num); ++i) {
-                        os << l->str;
-                    }
-                    return Ast::makeString(os.str());
+                    return repeat(l.span(), static_cast<int>(r.num()));
                 default:
                     break;
             }
         default:
             msg = opError(l,r, opDesc);
-            return nullptr;
+            return Value();
     }
 }
 
-static Ast::Ptr adiv(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value adiv(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "divide";
-    std::ostringstream os;
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        if (r->num == 0) {
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        if (r.num() == 0) {
             msg = "divide by 0";
-            return nullptr;
+            return Value();
         }
-        return Ast::make(l->num / r->num);
+        return Value(l.num() / r.num());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr amod(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value amod(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "modulo";
-    std::ostringstream os;
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        int n = static_cast<int>(r->num);
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        const int n = truncate(r.num());
         if (n == 0) {
             msg = "modulo by 0";
-            return nullptr;
+            return Value();
         }
-        return Ast::make(static_cast<double>(static_cast<int>(l->num) % n));
+        return Value(modulo(truncate(l.num()), n));
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr apow(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value apow(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "apply ^ on";
-    std::ostringstream os;
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        return Ast::make(std::pow(l->num, r->num));
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        return Value(std::pow(l.num(), r.num()));
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr land(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value land(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "apply && on";
-    std::ostringstream os;
-    if (l->t == Ast::T::BOOLEAN && r->t == Ast::T::BOOLEAN) {
-        return Ast::make(l->b && r->b);
+    if (l.t() == Ast::T::BOOLEAN && r.t() == Ast::T::BOOLEAN) {
+        return Value(l.b() && r.b());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr lor(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value lor(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "apply || on";
-    std::ostringstream os;
-    if (l->t == Ast::T::BOOLEAN && r->t == Ast::T::BOOLEAN) {
-        return Ast::make(l->b || r->b);
+    if (l.t() == Ast::T::BOOLEAN && r.t() == Ast::T::BOOLEAN) {
+        return Value(l.b() || r.b());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr ceq(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value ceq(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "apply == on";
-    std::ostringstream os;
-    if (l->t == Ast::T::BOOLEAN && r->t == Ast::T::BOOLEAN) {
-        return Ast::make(l->b == r->b);
+    if (l.t() == Ast::T::BOOLEAN && r.t() == Ast::T::BOOLEAN) {
+        return Value(l.b() == r.b());
     }
-    if (l->t == Ast::T::STRING && r->t == Ast::T::STRING) {
-        return Ast::make(l->str == r->str);
+    if (l.t() == Ast::T::STRING && r.t() == Ast::T::STRING) {
+        return Value(l.compare(r) == 0);
     }
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        return Ast::make(l->num == r->num);
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        return Value(l.num() == r.num());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
-static Ast::Ptr cne(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value cne(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     assert(l && r);
     const char *opDesc = "apply != on";
-    std::ostringstream os;
-    if (l->t == Ast::T::BOOLEAN && r->t == Ast::T::BOOLEAN) {
-        return Ast::make(l->b != r->b);
+    if (l.t() == Ast::T::BOOLEAN && r.t() == Ast::T::BOOLEAN) {
+        return Value(l.b() != r.b());
     }
-    if (l->t == Ast::T::STRING && r->t == Ast::T::STRING) {
-        return Ast::make(l->str != r->str);
+    if (l.t() == Ast::T::STRING && r.t() == Ast::T::STRING) {
+        return Value(l.compare(r) != 0);
     }
-    if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {
-        return Ast::make(l->num != r->num);
+    if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {
+        return Value(l.num() != r.num());
     }
     msg = opError(l,r, opDesc);
-    return nullptr;
+    return Value();
 }
 
 #define CMP_COMMON(X) do {\
         assert(l && r);\
         const char *opDesc = "apply " #X "on";\
-        std::ostringstream os;\
-        if (l->t == Ast::T::STRING && r->t == Ast::T::STRING) {\
-        return Ast::make(l->str X r->str);\
+        if (l.t() == Ast::T::STRING && r.t() == Ast::T::STRING) {\
+        return Value(l.compare(r) X 0);\
         }\
-        if (l->t == Ast::T::NUMBER && r->t == Ast::T::NUMBER) {\
-        return Ast::make(l->num X r->num);\
+        if (l.t() == Ast::T::NUMBER && r.t() == Ast::T::NUMBER) {\
+        return Value(l.num() X r.num());\
         }\
         msg = opError(l,r, opDesc);\
-        return nullptr;\
+        return Value();\
     } while(false);
 
-static Ast::Ptr cgt(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value cgt(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     CMP_COMMON(>);
 }
 
-static Ast::Ptr cge(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value cge(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     CMP_COMMON(>=);
 }
 
-static Ast::Ptr clt(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value clt(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     CMP_COMMON(<);
 }
 
-static Ast::Ptr cle(
-    const Ast::Ptr &l,
-    const Ast::Ptr &r,
+static Value cle(
+    const Value &l,
+    const Value &r,
     std::string &msg
 )
 {
     CMP_COMMON(<=);
 }
 
-static std::string uniError(const Ast::Ptr &root)
+static std::string uniError(const Value &operand)
 {
+    INSTRUMENT_COUNT(TYPE_ERRORS);
     std::string msg = "cannot apply uni-operand operator ";
-    msg += toString(root->t);
+    msg += toString(Ast::T::OPERATOR);
     msg += " on ";
-    msg += toString(root->right->t);
+    msg += toString(operand.t());
     return msg;
 }
 
-static Ast::Ptr
-uniOperand(const Ast::Ptr &root, std::string &msg)
+Value apply(Ast::O op, const Value &operand, std::string &msg)
 {
-    switch (root->op)  {
+    assert(operand);
+    switch (op)  {
         case Ast::O::PLUS:
-            if (root->right->t == Ast::T::NUMBER) {
-                return root->right->clone();
+            if (operand.t() == Ast::T::NUMBER) {
+                return operand;
             }
             break;
         case Ast::O::MINUS:
-            if (root->right->t == Ast::T::NUMBER) {
-                return Ast::make(-root->right->num);
+            if (operand.t() == Ast::T::NUMBER) {
+                return Value(-operand.num());
             }
             break;
         case Ast::O::LOGICAL_NOT:
-            if (root->right->t == Ast::T::BOOLEAN) {
-                return Ast::make(!root->right->b);
+            if (operand.t() == Ast::T::BOOLEAN) {
+                return Value(!operand.b());
             }
             break;
         default:
             break;
     }
-    msg = uniError(root);
-    return nullptr;
+    msg = uniError(operand);
+    return Value();
 
 }
 
-static Ast::Ptr
-opEval(const Ast::Ptr &root, const Ast::Dict &dict,  std::string &msg)
+Value apply(Ast::O op, const Value &l, const Value &r, std::string &msg)
 {
-    assert(root->t == Ast::T::OPERATOR);
-    auto r = eval(root->right, dict, msg);
-    if (!r) {
-        return nullptr;
-    }
-    if (!root->left) {
-        auto rt = Ast::make(root->op);
-        rt->right = std::move(r);
-        return uniOperand(rt, msg);
-    }
-    auto l = eval(root->left, dict, msg);
-    if (!l) {
-        return nullptr;
-    }
-    switch (root->op) {
+    switch (op) {
         case Ast::O::PLUS:
             return aadd(l,r,msg);
         case Ast::O::MINUS:
@@ -451,10 +491,8 @@ opEval(const Ast::Ptr &root, const Ast::Dict &dict,  std::string &msg)
         case Ast::O::POWER:
             return apow(l,r,msg);
         case Ast::O::LOGICAL_AND:
-            // no short circuit
             return land(l,r,msg);
         case Ast::O::LOGICAL_OR:
-            // no short circuit
             return lor(l,r,msg);
         case Ast::O::CMP_EQ:
             return ceq(l,r,msg);
@@ -471,33 +509,195 @@ opEval(const Ast::Ptr &root, const Ast::Dict &dict,  std::string &msg)
         default:
             break;
     }
-    return nullptr;
+    return Value();
 }
 
-Ast::Ptr eval(const Ast::Ptr &root, const Ast::Dict &dict, std::string &msg)
+static Value lookup(const Ast::Dict &dict, const std::string &name)
 {
-    if (!root) {
-        return nullptr;
+    const auto i = dict.find(name);
+    return i == dict.cend() ? Value() : Value::fromAst(*i->second);
+}
+
+static Value lookup(const Value::Dict &dict, const std::string &name)
+{
+    const auto i = dict.find(name);
+    return i == dict.cend() ? Value() : i->second;
+}
+
+bool decides(Ast::O op, const Value &l)
+{
+    if (l.t() != Ast::T::BOOLEAN) {
+        return false;
+    }
+    switch (op) {
+        case Ast::O::LOGICAL_AND:
+            return !l.b();
+        case Ast::O::LOGICAL_OR:
+            return l.b();
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+// the recorder of the plain walk(), which records nothing
+struct Unrecorded
+{
+    int start() const { return 0; }
+    void stop(const Ast &, int, const Value &) const {}
+};
+
+struct Timed
+{
+    typedef std::chrono::steady_clock Clock;
+    Recorder &recorder;
+    Clock::time_point start() const { return Clock::now(); }
+    void stop(const Ast &node, Clock::time_point start, const Value &v) const
+    {
+        recorder.record(node, std::chrono::duration_cast<
+            std::chrono::nanoseconds>(Clock::now() - start).count(), v);
+    }
+};
+
+} // namespace
+
+template <class D, class R>
+static Value walk(
+    const Ast::Ptr &root,
+    const D &dict,
+    std::string &msg,
+    EvalMode mode,
+    const R &recorder
+);
+
+template <class D, class R>
+static Value shortCircuit(
+    const Ast::Ptr &root,
+    const D &dict,
+    std::string &msg,
+    const R &recorder
+)
+{
+    auto l = walk(root->left, dict, msg, EvalMode::SHORT_CIRCUIT, recorder);
+    if (!l || decides(root->op, l)) {
+        return l;
+    }
+    const auto r = walk(
+        root->right, dict, msg, EvalMode::SHORT_CIRCUIT, recorder
+    );
+    if (!r) {
+        return Value();
+    }
+    return apply(root->op, l, r, msg);
+}
+
+template <class D, class R>
+static Value opEval(
+    const Ast::Ptr &root,
+    const D &dict,
+    std::string &msg,
+    EvalMode mode,
+    const R &recorder
+)
+{
+    assert(root->t == Ast::T::OPERATOR);
+    INSTRUMENT_OPERATOR(root->op, 1);
+    if (mode == EvalMode::SHORT_CIRCUIT && root->left
+        && (root->op == Ast::O::LOGICAL_AND || root->op == Ast::O::LOGICAL_OR)
+    ) {
+        return shortCircuit(root, dict, msg, recorder);
+    }
+    const auto r = walk(root->right, dict, msg, mode, recorder);
+    if (!r) {
+        return Value();
+    }
+    if (!root->left) {
+        return apply(root->op, r, msg);
     }
+    const auto l = walk(root->left, dict, msg, mode, recorder);
+    if (!l) {
+        return Value();
+    }
+    return apply(root->op, l, r, msg);
+}
+
+template <class D, class R>
+static Value node(
+    const Ast::Ptr &root,
+    const D &dict,
+    std::string &msg,
+    EvalMode mode,
+    const R &recorder
+)
+{
     switch (root->t) {
         case Ast::T::BOOLEAN:
         case Ast::T::NUMBER:
         case Ast::T::STRING:
-            return root->clone();
+            return Value::fromAst(*root);
         case Ast::T::SYMBOL: {
-            const auto i = dict.find(root->str);
-            if (i == dict.cend()) {
+            auto v = lookup(dict, root->str);
+            if (!v) {
                 msg = "unsolvable symbol ";
                 msg += root->str;
-                return nullptr;
             }
-            return i->second->clone();
+            return v;
         }
         case Ast::T::OPERATOR:
-            return opEval(root, dict, msg);
+            return opEval(root, dict, msg, mode, recorder);
         default:
-            return nullptr;
+            return Value();
+    }
+}
+
+template <class D, class R>
+static Value walk(
+    const Ast::Ptr &root,
+    const D &dict,
+    std::string &msg,
+    EvalMode mode,
+    const R &recorder
+)
+{
+    if (!root) {
+        return Value();
     }
+    const auto start = recorder.start();
+    Value v = node(root, dict, msg, mode, recorder);
+    recorder.stop(*root, start, v);
+    return v;
+}
+
+Value evaluate(
+    const Ast::Ptr &root,
+    const Value::Dict &dict,
+    std::string &msg,
+    EvalMode mode
+)
+{
+    return walk(root, dict, msg, mode, Unrecorded());
+}
+
+Value evaluate(
+    const Ast::Ptr &root,
+    const Value::Dict &dict,
+    std::string &msg,
+    EvalMode mode,
+    Recorder &recorder
+)
+{
+    return walk(root, dict, msg, mode, Timed{recorder});
+}
+
+Ast::Ptr eval(
+    const Ast::Ptr &root,
+    const Ast::Dict &dict,
+    std::string &msg,
+    EvalMode mode
+)
+{
+    return walk(root, dict, msg, mode, Unrecorded()).toAst();
 }
 
 Ast::Ptr Ast::clone() const
@@ -507,7 +707,10 @@ Ast::Ptr Ast::clone() const
 
 Ast::Ast(const Ast &root)
 {
+    INSTRUMENT_COUNT(NODES);
     t = root.t;
+    at = root.at;
+    n = root.n;
     switch (t) {
         case T::STRING:
         case T::SYMBOL:
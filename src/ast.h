@@ -1,10 +1,15 @@
 #ifndef HEADER_82DEFF939A154BFA8787C84C8BB5CD66
 #define HEADER_82DEFF939A154BFA8787C84C8BB5CD66
 
+#include "intern.h"
+#include "span.h"
+
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 
 struct Ast
 {
@@ -20,13 +25,15 @@ struct Ast
     Ast(const Ast &);
     explicit Ast(bool b);
     explicit Ast(double v);
-    explicit Ast(const std::string &s);
+    explicit Ast(Atom s);
     Ast(O o);
     std::unique_ptr<Ast> clone() const;
     static std::unique_ptr<Ast> make(double v);
     static std::unique_ptr<Ast> make(O o);
     static std::unique_ptr<Ast> make(bool b);
+    static std::unique_ptr<Ast> makeString(Span s);
     static std::unique_ptr<Ast> makeString(const std::string &s);
+    static std::unique_ptr<Ast> makeSymbol(Span s);
     static std::unique_ptr<Ast> makeSymbol(const std::string &s);
     T t;
     union {
@@ -34,16 +41,26 @@ struct Ast
         double num;
         bool b;
     };
-    std::string str;
+    Atom str;
     std::unique_ptr<Ast> left;
     std::unique_ptr<Ast> right;
+    /// @brief the text the Parser made the node of, n is 0 for others
+    std::size_t at = 0;
+    std::size_t n = 0;
 };
 
+/// @brief STRICT evaluates both operands of && and || before combining
+/// them, SHORT_CIRCUIT skips the right one when the left decides the result
+enum class EvalMode { STRICT, SHORT_CIRCUIT };
+
 std::set<std::string> symbols(const Ast::Ptr &p);
+/// @brief the distinct symbols of p, ordered by their strings
+std::vector<Atom> atoms(const Ast::Ptr &p);
 Ast::Ptr eval(
     const Ast::Ptr &,
     const Ast::Dict &dict,
-    std::string &msg
+    std::string &msg,
+    EvalMode mode = EvalMode::STRICT
 );
 
 #endif
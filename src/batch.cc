@@ -0,0 +1,717 @@
+#include "batch.h"
+#include "instrument.h"
+#include "kernels.h"
+#include "value.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const std::size_t CHUNK = 1024;
+
+// one stack entry or slot for the rows of a chunk, NUMBER and BOOLEAN
+// lanes are arrays which may point into a column, a lane of any other
+// type keeps one Value per row
+struct Lane
+{
+    Ast::T t;
+    const double *num;
+    const unsigned char *b;
+    std::vector<double> nbuf;
+    std::vector<unsigned char> bbuf;
+    std::vector<Value> val;
+
+    Lane() : t(Ast::T::UNKNOWN), num(nullptr), b(nullptr) {}
+
+    double *numbers()
+    {
+        nbuf.resize(CHUNK);
+        t = Ast::T::NUMBER;
+        num = nbuf.data();
+        return nbuf.data();
+    }
+
+    unsigned char *booleans()
+    {
+        bbuf.resize(CHUNK);
+        t = Ast::T::BOOLEAN;
+        b = bbuf.data();
+        return bbuf.data();
+    }
+
+    Value at(std::size_t i) const
+    {
+        switch (t) {
+            case Ast::T::NUMBER:
+                return Value(num[i]);
+            case Ast::T::BOOLEAN:
+                return Value(b[i] != 0);
+            default:
+                return val[i];
+        }
+    }
+};
+
+// rows set aside by a jump or a CACHED, they are active again at target
+struct Pending
+{
+    std::size_t target;
+    bool cached;
+    std::vector<unsigned char> off;
+};
+
+struct Machine
+{
+    const Program &p;
+    const Column *args;
+    const std::uint32_t *sel;
+    std::vector<Lane> stack;
+    std::vector<Lane> slots;
+    std::vector<unsigned char> filled;
+    std::vector<Pending> pending;
+    std::size_t npending;
+    std::vector<Value> tmp;
+    std::vector<std::string> msg;
+    std::vector<unsigned char> act;
+    std::vector<unsigned char> err;
+    std::vector<unsigned char> flag;
+    std::size_t base;
+    std::size_t m;
+
+    Machine(
+        const Program &program,
+        const Column *columns,
+        const std::uint32_t *rows
+    )
+        : p(program), args(columns), sel(rows),
+        stack(program.depth), slots(program.slots),
+        filled(program.slots * CHUNK), npending(0),
+        tmp(CHUNK), msg(CHUNK), act(CHUNK), err(CHUNK), flag(CHUNK),
+        base(0), m(0)
+    {
+    }
+
+    // the row of the columns behind row i of the chunk
+    std::size_t row(std::size_t i) const
+    {
+        return sel ? sel[base + i] : base + i;
+    }
+
+    void fail(std::size_t i, const std::string &s)
+    {
+        err[i] = 1;
+        act[i] = 0;
+        msg[i] = s;
+    }
+
+    // the Values in tmp become the content of l
+    void generic(Lane &l)
+    {
+        l.val.swap(tmp);
+        tmp.resize(CHUNK);
+        l.t = Ast::T::UNKNOWN;
+        narrow(l);
+    }
+
+    // turns a lane of Values into an array if all rows with a value allow
+    // it, rows without one are failed or not computed
+    void narrow(Lane &l)
+    {
+        Ast::T t = Ast::T::UNKNOWN;
+        for (std::size_t i = 0; i < m; ++i) {
+            const Ast::T vt = l.val[i].t();
+            if (vt == Ast::T::UNKNOWN) {
+                continue;
+            }
+            if (vt != Ast::T::NUMBER && vt != Ast::T::BOOLEAN) {
+                return;
+            }
+            if (t != Ast::T::UNKNOWN && t != vt) {
+                return;
+            }
+            t = vt;
+        }
+        if (t == Ast::T::NUMBER) {
+            double *o = l.numbers();
+            for (std::size_t i = 0; i < m; ++i) {
+                o[i] = l.val[i] ? l.val[i].num() : 0;
+            }
+        } else if (t == Ast::T::BOOLEAN) {
+            unsigned char *o = l.booleans();
+            for (std::size_t i = 0; i < m; ++i) {
+                o[i] = l.val[i] && l.val[i].b();
+            }
+        }
+    }
+
+    // rows of src selected by mask are copied to dst
+    void merge(Lane &dst, const Lane &src, const unsigned char *mask)
+    {
+        if (dst.t == src.t && dst.t == Ast::T::NUMBER) {
+            if (dst.num != dst.nbuf.data()) {
+                const double *v = dst.num;
+                std::copy(v, v + m, dst.numbers());
+            }
+            for (std::size_t i = 0; i < m; ++i) {
+                if (mask[i]) {
+                    dst.nbuf[i] = src.num[i];
+                }
+            }
+            return;
+        }
+        if (dst.t == src.t && dst.t == Ast::T::BOOLEAN) {
+            if (dst.b != dst.bbuf.data()) {
+                const unsigned char *v = dst.b;
+                std::copy(v, v + m, dst.booleans());
+            }
+            for (std::size_t i = 0; i < m; ++i) {
+                if (mask[i]) {
+                    dst.bbuf[i] = src.b[i];
+                }
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            tmp[i] = mask[i] ? src.at(i) : dst.at(i);
+        }
+        dst.val.swap(tmp);
+        tmp.resize(CHUNK);
+        dst.t = Ast::T::UNKNOWN;
+    }
+
+    void copy(Lane &dst, const Lane &src)
+    {
+        dst.t = src.t;
+        switch (src.t) {
+            case Ast::T::NUMBER:
+                if (src.num == src.nbuf.data()) {
+                    std::copy(src.num, src.num + m, dst.numbers());
+                } else {
+                    dst.num = src.num;
+                }
+                break;
+            case Ast::T::BOOLEAN:
+                if (src.b == src.bbuf.data()) {
+                    std::copy(src.b, src.b + m, dst.booleans());
+                } else {
+                    dst.b = src.b;
+                }
+                break;
+            default:
+                dst.val.resize(CHUNK);
+                std::copy(src.val.begin(), src.val.begin() + m,
+                    dst.val.begin());
+                break;
+        }
+    }
+
+    std::vector<unsigned char> &push(std::size_t target, bool cached)
+    {
+        if (npending == pending.size()) {
+            pending.push_back(Pending());
+            pending.back().off.resize(CHUNK);
+        }
+        pending[npending].target = target;
+        pending[npending].cached = cached;
+        return pending[npending++].off;
+    }
+
+    void resume(std::size_t at)
+    {
+        while (npending && pending[npending - 1].target == at) {
+            const auto &off = pending[--npending].off;
+            for (std::size_t i = 0; i < m; ++i) {
+                act[i] |= off[i];
+            }
+        }
+    }
+
+    void constant(Lane &l, const Value &c)
+    {
+        switch (c.t()) {
+            case Ast::T::NUMBER: {
+                double *o = l.numbers();
+                std::fill(o, o + m, c.num());
+                break;
+            }
+            case Ast::T::BOOLEAN: {
+                unsigned char *o = l.booleans();
+                std::fill(o, o + m, c.b());
+                break;
+            }
+            default:
+                l.t = Ast::T::UNKNOWN;
+                l.val.resize(CHUNK);
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (act[i]) {
+                        l.val[i] = c;
+                    }
+                }
+                break;
+        }
+    }
+
+    void load(Lane &l, std::uint32_t slot)
+    {
+        const Column &c = args[slot];
+        switch (c.type) {
+            case Column::Type::REAL: {
+                if (!sel) {
+                    l.t = Ast::T::NUMBER;
+                    l.num = c.real + base;
+                    break;
+                }
+                // the rows of a selection are gathered
+                double *o = l.numbers();
+                for (std::size_t i = 0; i < m; ++i) {
+                    o[i] = c.real[row(i)];
+                }
+                break;
+            }
+            case Column::Type::BOOL: {
+                unsigned char *o = l.booleans();
+                for (std::size_t i = 0; i < m; ++i) {
+                    o[i] = c.boolean[row(i)];
+                }
+                break;
+            }
+            case Column::Type::STRING:
+                l.t = Ast::T::UNKNOWN;
+                l.val.resize(CHUNK);
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (act[i]) {
+                        l.val[i] = Value(c.str[row(i)]);
+                    }
+                }
+                break;
+            default: {
+                const std::string s = "unsolvable symbol "
+                    + p.symbols[slot].str();
+                for (std::size_t i = 0; i < m; ++i) {
+                    if (act[i]) {
+                        fail(i, s);
+                    }
+                }
+                l.t = Ast::T::UNKNOWN;
+                l.val.resize(CHUNK);
+                break;
+            }
+        }
+    }
+
+    // the rows of a column of another type than a LOAD_* expects fail
+    void check(Program::Code load, std::uint32_t slot)
+    {
+        const Column::Type c = args[slot].type;
+        Ast::T t = Ast::T::BOOLEAN;
+        if (load == Program::Code::LOAD_NUM) {
+            t = Ast::T::NUMBER;
+        } else if (load == Program::Code::LOAD_STR) {
+            t = Ast::T::STRING;
+        }
+        if (c == Column::Type::NONE
+            || (c == Column::Type::REAL && t == Ast::T::NUMBER)
+            || (c == Column::Type::STRING && t == Ast::T::STRING)
+            || (c == Column::Type::BOOL && t == Ast::T::BOOLEAN)
+        ) {
+            return;
+        }
+        const std::string s = mistyped(p.symbols[slot], t);
+        for (std::size_t i = 0; i < m; ++i) {
+            if (act[i]) {
+                fail(i, s);
+            }
+        }
+    }
+
+    void unary(Ast::O op, Lane &l)
+    {
+        if (op == Ast::O::PLUS && l.t == Ast::T::NUMBER) {
+            return;
+        }
+        if (op == Ast::O::MINUS && l.t == Ast::T::NUMBER) {
+            const double *v = l.num;
+            kernels::neg(v, l.numbers(), m);
+            return;
+        }
+        if (op == Ast::O::LOGICAL_NOT && l.t == Ast::T::BOOLEAN) {
+            const unsigned char *v = l.b;
+            kernels::lnot(v, l.booleans(), m);
+            return;
+        }
+        std::string s;
+        for (std::size_t i = 0; i < m; ++i) {
+            if (act[i]) {
+                tmp[i] = apply(op, l.at(i), s);
+                if (!tmp[i]) {
+                    fail(i, s);
+                }
+            } else {
+                tmp[i] = Value();
+            }
+        }
+        generic(l);
+    }
+
+    // rows where the division or modulo failed
+    void zero(const char *s)
+    {
+        for (std::size_t i = 0; i < m; ++i) {
+            if (act[i] && flag[i]) {
+                fail(i, s);
+            }
+        }
+    }
+
+    bool numbers(Ast::O op, const Lane &l, const Lane &r, Lane &dst)
+    {
+        const double *a = l.num;
+        const double *b = r.num;
+        switch (op) {
+            case Ast::O::PLUS:
+                kernels::add(a, b, dst.numbers(), m);
+                return true;
+            case Ast::O::MINUS:
+                kernels::sub(a, b, dst.numbers(), m);
+                return true;
+            case Ast::O::MULTIPLY:
+                kernels::mul(a, b, dst.numbers(), m);
+                return true;
+            case Ast::O::DIVISION:
+                kernels::div(a, b, dst.numbers(), flag.data(), m);
+                zero("divide by 0");
+                return true;
+            case Ast::O::MODULO:
+                kernels::mod(a, b, dst.numbers(), flag.data(), m);
+                zero("modulo by 0");
+                return true;
+            case Ast::O::POWER:
+                kernels::pow(a, b, dst.numbers(), m);
+                return true;
+            case Ast::O::CMP_EQ:
+                kernels::eq(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_NE:
+                kernels::ne(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_GT:
+                kernels::gt(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_GE:
+                kernels::ge(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_LT:
+                kernels::lt(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_LE:
+                kernels::le(a, b, dst.booleans(), m);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool booleans(Ast::O op, const Lane &l, const Lane &r, Lane &dst)
+    {
+        const unsigned char *a = l.b;
+        const unsigned char *b = r.b;
+        switch (op) {
+            case Ast::O::LOGICAL_AND:
+                kernels::land(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::LOGICAL_OR:
+                kernels::lor(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_EQ:
+                kernels::beq(a, b, dst.booleans(), m);
+                return true;
+            case Ast::O::CMP_NE:
+                kernels::bne(a, b, dst.booleans(), m);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // dst is l or r, inactive rows keep the value of l when keep is set
+    void binary(Ast::O op, const Lane &l, const Lane &r, Lane &dst, bool keep)
+    {
+        if (l.t == Ast::T::NUMBER && r.t == Ast::T::NUMBER
+            && numbers(op, l, r, dst)
+        ) {
+            return;
+        }
+        if (l.t == Ast::T::BOOLEAN && r.t == Ast::T::BOOLEAN
+            && booleans(op, l, r, dst)
+        ) {
+            return;
+        }
+        std::string s;
+        for (std::size_t i = 0; i < m; ++i) {
+            if (act[i]) {
+                tmp[i] = apply(op, l.at(i), r.at(i), s);
+                if (!tmp[i]) {
+                    fail(i, s);
+                }
+            } else if (keep && !err[i]) {
+                tmp[i] = l.at(i);
+            } else {
+                tmp[i] = Value();
+            }
+        }
+        generic(dst);
+    }
+
+    void jump(Ast::O op, const Lane &l, std::size_t target)
+    {
+        auto &off = push(target, false);
+        for (std::size_t i = 0; i < m; ++i) {
+            off[i] = act[i] && (l.t == Ast::T::BOOLEAN
+                ? (op == Ast::O::LOGICAL_AND) != (l.b[i] != 0)
+                : decides(op, l.at(i)));
+            act[i] &= !off[i];
+        }
+    }
+
+    void cached(std::size_t target)
+    {
+        const std::uint32_t slot = p.code[target - 1].arg;
+        const unsigned char *f = filled.data() + slot * CHUNK;
+        auto &off = push(target, true);
+        for (std::size_t i = 0; i < m; ++i) {
+            off[i] = act[i] && f[i];
+            act[i] &= !off[i];
+        }
+    }
+
+    void store(std::size_t at, Lane &top, std::uint32_t slot)
+    {
+        unsigned char *f = filled.data() + slot * CHUNK;
+        Lane &s = slots[slot];
+        if (std::find(f, f + m, 1) == f + m) {
+            copy(s, top);
+        } else {
+            merge(s, top, act.data());
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            f[i] |= act[i];
+        }
+        // rows for which the CACHED in front of the code found the slot
+        // filled take the stored value
+        if (npending && pending[npending - 1].cached
+            && pending[npending - 1].target == at + 1
+        ) {
+            merge(top, s, pending[npending - 1].off.data());
+        }
+    }
+
+    // runs the code over the current chunk, the result is the only lane
+    // left on the stack
+    const Lane &execute()
+    {
+        std::fill(act.begin(), act.begin() + m, 1);
+        std::fill(err.begin(), err.begin() + m, 0);
+        std::fill(filled.begin(), filled.end(), 0);
+        npending = 0;
+        Lane *sp = stack.data();
+        for (std::size_t k = 0; k < p.code.size(); ++k) {
+            resume(k);
+            const Program::Instr &i = p.code[k];
+            const Program::Code code = untyped(i.code);
+            INSTRUMENT_CODE(i.code, m);
+            switch (code) {
+                case Program::Code::CONST:
+                    constant(*sp++, p.consts[i.arg]);
+                    break;
+                case Program::Code::LOAD:
+                    load(*sp++, i.arg);
+                    if (code != i.code) {
+                        check(i.code, i.arg);
+                    }
+                    break;
+                case Program::Code::STORE:
+                    store(k, sp[-1], i.arg);
+                    break;
+                case Program::Code::FETCH:
+                    copy(*sp++, slots[i.arg]);
+                    break;
+                case Program::Code::CACHED:
+                    cached(i.arg);
+                    break;
+                case Program::Code::POS:
+                    unary(Ast::O::PLUS, sp[-1]);
+                    break;
+                case Program::Code::NEG:
+                    unary(Ast::O::MINUS, sp[-1]);
+                    break;
+                case Program::Code::NOT:
+                    unary(Ast::O::LOGICAL_NOT, sp[-1]);
+                    break;
+                case Program::Code::JUMP_FALSE:
+                    jump(Ast::O::LOGICAL_AND, sp[-1], i.arg);
+                    break;
+                case Program::Code::JUMP_TRUE:
+                    jump(Ast::O::LOGICAL_OR, sp[-1], i.arg);
+                    break;
+                case Program::Code::LAND:
+                    --sp;
+                    binary(Ast::O::LOGICAL_AND, sp[-1], sp[0], sp[-1], true);
+                    break;
+                case Program::Code::LOR:
+                    --sp;
+                    binary(Ast::O::LOGICAL_OR, sp[-1], sp[0], sp[-1], true);
+                    break;
+                default:
+                    // the left operand is on top of the right one
+                    --sp;
+                    binary(op(code), sp[0], sp[-1], sp[-1], false);
+                    break;
+            }
+        }
+        resume(p.code.size());
+        assert(sp == stack.data() + 1);
+        (void)sp;
+        return stack[0];
+    }
+
+    void chunk(ResultColumn &out)
+    {
+        const Lane &r = execute();
+        for (std::size_t i = 0; i < m; ++i) {
+            const std::size_t row = base + i;
+            if (err[i]) {
+                out.type[row] = ResultColumn::Type::ERROR;
+                out.str[row] = msg[i];
+                continue;
+            }
+            if (r.t == Ast::T::NUMBER) {
+                out.type[row] = ResultColumn::Type::REAL;
+                out.real[row] = r.num[i];
+                continue;
+            }
+            if (r.t == Ast::T::BOOLEAN) {
+                out.type[row] = ResultColumn::Type::BOOL;
+                out.real[row] = r.b[i];
+                continue;
+            }
+            const Value &v = r.val[i];
+            switch (v.t()) {
+                case Ast::T::NUMBER:
+                    out.type[row] = ResultColumn::Type::REAL;
+                    out.real[row] = v.num();
+                    break;
+                case Ast::T::BOOLEAN:
+                    out.type[row] = ResultColumn::Type::BOOL;
+                    out.real[row] = v.b();
+                    break;
+                default:
+                    out.type[row] = ResultColumn::Type::STRING;
+                    out.str[row] = v.str();
+                    break;
+            }
+        }
+    }
+
+    // rows giving true go to yes, rows giving false to no
+    void chunk(std::vector<std::uint32_t> &yes, std::vector<std::uint32_t> *no)
+    {
+        const Lane &r = execute();
+        for (std::size_t i = 0; i < m; ++i) {
+            if (err[i]) {
+                continue;
+            }
+            const Value v = r.at(i);
+            if (v.t() != Ast::T::BOOLEAN) {
+                continue;
+            }
+            if (v.b()) {
+                yes.push_back(static_cast<std::uint32_t>(row(i)));
+            } else if (no) {
+                no->push_back(static_cast<std::uint32_t>(row(i)));
+            }
+        }
+    }
+
+    static Ast::O op(Program::Code c)
+    {
+        switch (c) {
+            case Program::Code::ADD:
+                return Ast::O::PLUS;
+            case Program::Code::SUB:
+                return Ast::O::MINUS;
+            case Program::Code::MUL:
+                return Ast::O::MULTIPLY;
+            case Program::Code::DIV:
+                return Ast::O::DIVISION;
+            case Program::Code::MOD:
+                return Ast::O::MODULO;
+            case Program::Code::POW:
+                return Ast::O::POWER;
+            case Program::Code::AND:
+                return Ast::O::LOGICAL_AND;
+            case Program::Code::OR:
+                return Ast::O::LOGICAL_OR;
+            case Program::Code::EQ:
+                return Ast::O::CMP_EQ;
+            case Program::Code::NE:
+                return Ast::O::CMP_NE;
+            case Program::Code::GT:
+                return Ast::O::CMP_GT;
+            case Program::Code::GE:
+                return Ast::O::CMP_GE;
+            case Program::Code::LT:
+                return Ast::O::CMP_LT;
+            default:
+                return Ast::O::CMP_LE;
+        }
+    }
+};
+
+} // namespace
+
+void run(
+    const Program &p,
+    const Column *args,
+    std::size_t rows,
+    ResultColumn &out
+)
+{
+    out.type.assign(rows, ResultColumn::Type::ERROR);
+    out.real.assign(rows, 0);
+    out.str.assign(rows, std::string());
+    if (p.code.empty()) {
+        return;
+    }
+    Machine vm(p, args, nullptr);
+    for (vm.base = 0; vm.base < rows; vm.base += CHUNK) {
+        vm.m = std::min(CHUNK, rows - vm.base);
+        vm.chunk(out);
+    }
+}
+
+void run(
+    const Program &p,
+    const Column *args,
+    const std::uint32_t *rows,
+    std::size_t n,
+    std::vector<std::uint32_t> &yes,
+    std::vector<std::uint32_t> *no
+)
+{
+    yes.clear();
+    if (no) {
+        no->clear();
+    }
+    if (p.code.empty()) {
+        return;
+    }
+    Machine vm(p, args, rows);
+    for (vm.base = 0; vm.base < n; vm.base += CHUNK) {
+        vm.m = std::min(CHUNK, n - vm.base);
+        vm.chunk(yes, no);
+    }
+}
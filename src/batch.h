@@ -0,0 +1,36 @@
+#ifndef HEADER_D3E1CA9825E0462BB543B6DD414E5243
+#define HEADER_D3E1CA9825E0462BB543B6DD414E5243
+
+#include "column.h"
+#include "vm.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief evaluates p for the rows [0, rows) of args
+/// @param args one column per symbol of p
+/// @note the code is run one instruction at a time over chunks of rows,
+/// numbers and booleans go through the loops in kernels.h, everything
+/// else through apply(). Every row gets the value or the error run()
+/// gives for it. In SHORT_CIRCUIT mode the rows a jump skips are masked
+/// out, so errors of a skipped operand are never reported.
+void run(
+    const Program &p,
+    const Column *args,
+    std::size_t rows,
+    ResultColumn &out
+);
+/// @brief splits the rows [rows, rows + n) of args by the result of p
+/// @param rows ascending row numbers, they keep their order in yes and no
+/// @param no may be null, rows giving an error or no boolean go nowhere
+void run(
+    const Program &p,
+    const Column *args,
+    const std::uint32_t *rows,
+    std::size_t n,
+    std::vector<std::uint32_t> &yes,
+    std::vector<std::uint32_t> *no
+);
+
+#endif
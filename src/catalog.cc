@@ -0,0 +1,165 @@
+#include "catalog.h"
+#include "mapping.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace {
+
+// "AEXC", the version, 2 bytes unused and the number of expressions, then
+// count + 1 offsets of the records from the start of the file
+const char MAGIC[] = {'A', 'E', 'X', 'C'};
+const std::uint16_t VERSION = 1;
+const std::size_t HEADER = 16;
+
+std::uint64_t u64(const char *p)
+{
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i]))
+            << (8 * i);
+    }
+    return v;
+}
+
+void u64(std::uint64_t v, std::string &out)
+{
+    for (int i = 0; i < 8; ++i) {
+        out += static_cast<char>(v >> (8 * i));
+    }
+}
+
+} // namespace
+
+struct CatalogImpl
+{
+    CatalogImpl() : msg("no catalog is opened"), count(0), materialized(0) {}
+    Mapping map;
+    std::string msg;
+    std::size_t count;
+    std::unique_ptr<std::once_flag[]> once;
+    std::unique_ptr<std::unique_ptr<Expression>[]> expressions;
+    std::atomic<std::size_t> materialized;
+};
+
+Catalog::Catalog()
+    : impl_(new CatalogImpl())
+{
+}
+
+Catalog::~Catalog()
+{
+}
+
+bool Catalog::save(
+    const std::string &path,
+    const std::vector<Expression> &expressions,
+    bool source
+)
+{
+    std::string records;
+    std::string out(MAGIC, sizeof(MAGIC));
+    out += static_cast<char>(VERSION & 0xff);
+    out += static_cast<char>(VERSION >> 8);
+    out.append(2, '\0');
+    u64(expressions.size(), out);
+    const std::size_t begin = HEADER + 8 * (expressions.size() + 1);
+    for (const auto &e : expressions) {
+        u64(begin + records.size(), out);
+        const std::string record =
+            Expression::save(std::vector<Expression>(1, e), source);
+        if (record.empty()) {
+            return false;
+        }
+        records += record;
+    }
+    u64(begin + records.size(), out);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), out.size());
+    file.write(records.data(), records.size());
+    return static_cast<bool>(file.flush());
+}
+
+bool Catalog::open(const std::string &path)
+{
+    CatalogImpl &impl = *impl_;
+    impl.map.close();
+    impl.count = 0;
+    impl.once.reset();
+    impl.expressions.reset();
+    impl.materialized = 0;
+    // records are read by id, reading ahead would fetch unused ones
+    if (!impl.map.open(path, true, impl.msg)) {
+        return false;
+    }
+    const char *p = impl.map.data();
+    const std::size_t size = impl.map.size();
+    const std::uint64_t count = size < HEADER ? 0 : u64(p + 8);
+    if (size < HEADER || std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0
+        || (static_cast<unsigned char>(p[4])
+            | static_cast<unsigned char>(p[5]) << 8) != VERSION
+        || count >= (size - HEADER) / 8
+        || u64(p + HEADER + 8 * count) != size) {
+        impl.map.close();
+        impl.msg = path + " is no catalog of version "
+            + std::to_string(VERSION);
+        return false;
+    }
+    impl.count = count;
+    impl.once.reset(new std::once_flag[count]);
+    impl.expressions.reset(new std::unique_ptr<Expression>[count]);
+    impl.msg = "no error";
+    return true;
+}
+
+Catalog::operator bool() const
+{
+    return impl_->map.data() != nullptr;
+}
+
+const std::string &Catalog::msg() const
+{
+    return impl_->msg;
+}
+
+std::size_t Catalog::size() const
+{
+    return impl_->count;
+}
+
+const Expression &Catalog::get(Catalog::Id id) const
+{
+    CatalogImpl &impl = *impl_;
+    assert(id < impl.count);
+    std::call_once(impl.once[id], [&impl, id] {
+        const char *p = impl.map.data();
+        const std::uint64_t begin = u64(p + HEADER + 8 * id);
+        const std::uint64_t end = u64(p + HEADER + 8 * (id + 1));
+        std::vector<Expression> e;
+        if (begin <= end && end <= impl.map.size()
+            && Expression::load(p + begin, end - begin, e) && e.size() == 1) {
+            impl.expressions[id].reset(new Expression(e[0]));
+        } else {
+            impl.expressions[id].reset(new Expression());
+        }
+        ++impl.materialized;
+    });
+    return *impl.expressions[id];
+}
+
+std::pair<std::shared_ptr<parameter>, std::string> Catalog::eval(
+    Catalog::Id id,
+    const Expression::Dict &dict
+) const
+{
+    return get(id).eval(dict);
+}
+
+std::size_t Catalog::materialized() const
+{
+    return impl_->materialized;
+}
@@ -0,0 +1,56 @@
+#ifndef ARIADNE_PARSER_CATALOG_H
+#define ARIADNE_PARSER_CATALOG_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "interface.h"
+
+struct CatalogImpl;
+/// @brief Expressions stored in a file that is mapped read-only, each one
+/// made from its bytes on its first use
+/// @note the file is an index of offsets by id followed by one record of
+/// Expression::save() per expression, so open() reads nothing but the
+/// header and an expression never used costs no memory of the process.
+/// Processes mapping the same file share its pages in the page cache.
+/// get() and eval() may run concurrently, open() may not.
+class DLL_EXPORT Catalog {
+public:
+    typedef std::size_t Id;
+    Catalog();
+    ~Catalog();
+    Catalog(const Catalog &) = delete;
+    Catalog &operator=(const Catalog &) = delete;
+    /// @brief writes a catalog of expressions, the id of each is its index
+    /// @param source see Expression::save()
+    /// @return false if it cannot be written or Expression::save() fails
+    /// for an expression, the file is left as it was then
+    static bool save(
+        const std::string &path,
+        const std::vector<Expression> &expressions,
+        bool source = true
+    );
+    /// @brief maps the catalog of path, closing the one before
+    /// @return false if it cannot be mapped or is no catalog of this
+    /// version, msg() tells why
+    bool open(const std::string &path);
+    operator bool() const;
+    const std::string &msg() const;
+    std::size_t size() const;
+    /// @brief the expression id, an Expression without expression if its
+    /// record is damaged
+    const Expression &get(Id id) const;
+    std::pair<std::shared_ptr<parameter>, std::string> eval(
+        Id id,
+        const Expression::Dict &dict
+    ) const;
+    /// @brief the expressions made so far
+    std::size_t materialized() const;
+private:
+    std::unique_ptr<CatalogImpl> impl_;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HEADER_8D2C78DB76E54EE089863921317CCE46
+#define HEADER_8D2C78DB76E54EE089863921317CCE46
+
+#include "span.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief the values of one symbol for consecutive rows of a batch
+/// @note the column does not own the rows. A column of type NONE leaves
+/// its symbol unbound in every row.
+struct Column
+{
+    enum class Type { NONE, REAL, BOOL, STRING };
+    Column() : type(Type::NONE), real(nullptr), boolean(nullptr), str(nullptr)
+    {
+    }
+    explicit Column(const double *v)
+        : type(Type::REAL), real(v), boolean(nullptr), str(nullptr)
+    {
+    }
+    explicit Column(const bool *v)
+        : type(Type::BOOL), real(nullptr), boolean(v), str(nullptr)
+    {
+    }
+    explicit Column(const Span *v)
+        : type(Type::STRING), real(nullptr), boolean(nullptr), str(v)
+    {
+    }
+    Type type;
+    const double *real;
+    const bool *boolean;
+    const Span *str;
+};
+
+/// @brief the outcome of every row of a batch
+/// @note real holds 0 or 1 for BOOL rows, str holds the value of STRING
+/// rows and the error message of ERROR rows.
+struct ResultColumn
+{
+    enum class Type { ERROR, REAL, BOOL, STRING };
+    std::vector<Type> type;
+    std::vector<double> real;
+    std::vector<std::string> str;
+};
+
+#endif
@@ -0,0 +1,925 @@
+#ifndef HEADER_B064C801B037457FB7A23A8B6A8A5401
+#define HEADER_B064C801B037457FB7A23A8B6A8A5401
+
+#include "arith.h"
+#include "ast.h"
+#include "infer.h"
+#include "number.h"
+#include "span.h"
+#include "value.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// @brief an expression given as string literal, parsed by the compiler
+/// @note COMPILED_EXPRESSION("x * 2 > y") is an object whose operator()
+/// runs the expression with the code of every node inlined, operators
+/// whose operand types are known from literals skip the type dispatch of
+/// apply(). It gives what an Expression of the same text gives, a text the
+/// Parser rejects does not compile.
+#define COMPILED_EXPRESSION(str) \
+    COMPILED_EXPRESSION_MODE(str, EvalMode::STRICT)
+#define COMPILED_EXPRESSION_MODE(str, mode) \
+    ([] {\
+        struct Source\
+        {\
+            static constexpr const char *text() { return str; }\
+            static constexpr std::size_t size() { return sizeof(str) - 1; }\
+        };\
+        return compiled::Expression<Source, mode>();\
+    }())
+
+namespace compiled {
+
+/// @brief why the Parser rejects a text
+enum class Error {
+    NONE, UNEXPECTED_END, EXPECT_CLOSE, EXPECT_SOMETHING,
+    UNACCEPTABLE_OPERATOR, INVALID_OPERATOR, INVALID_SYMBOL,
+    UNMATCHED_QUOTE, UNMATCHED_PARENTHESES, TRAILING,
+};
+
+/// @note the texts of symbols, strings and numbers are the n characters
+/// at at in the pool of the Tree, left is -1 for unary operators
+struct Node
+{
+    Ast::T t;
+    Ast::O op;
+    double num;
+    bool exact; ///< num is the value of the number, else parseNumber() it
+    bool b;
+    std::size_t at;
+    std::size_t n;
+    int left;
+    int right;
+    std::size_t slot;
+    TypeSet types;
+};
+
+template <std::size_t N>
+struct Tree
+{
+    Node nodes[N + 1];
+    std::size_t count;
+    char pool[N + 1];
+    std::size_t used;
+    int root;
+    Error error;
+    std::size_t slots; ///< distinct symbols, numbered by their text
+};
+
+constexpr bool isSpace(int c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool isAlpha(int c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool isDigit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// @brief the value of the number s as strtod() gives it
+/// @return false if it is not exactly one rounding away from the digits,
+/// which holds for up to 2^53 in the digits and 10^22 in the exponent
+constexpr bool exact(const char *s, std::size_t n, double &v)
+{
+    std::uint64_t m = 0;
+    int e = 0;
+    std::size_t i = 0;
+    for (bool fraction = false; i < n; ++i) {
+        if (s[i] == '.') {
+            fraction = true;
+            continue;
+        }
+        if (!isDigit(s[i])) {
+            break;
+        }
+        if (m > (std::uint64_t(1) << 53) / 10) {
+            return false;
+        }
+        m = m * 10 + (s[i] - '0');
+        e -= fraction;
+    }
+    if (i < n) {
+        const bool negative = s[++i] == '-';
+        int x = 0;
+        for (i += s[i] == '-' || s[i] == '+'; i < n && x < 1000; ++i) {
+            x = x * 10 + (s[i] - '0');
+        }
+        e += negative ? -x : x;
+    }
+    if (m > std::uint64_t(1) << 53 || e > 22 || e < -22) {
+        return m == 0;
+    }
+    double p = 1;
+    for (int k = 0; k < (e < 0 ? -e : e); ++k) {
+        p *= 10;
+    }
+    v = e < 0 ? m / p : m * p;
+    return true;
+}
+
+/// @brief the recursive descent of Parser and Lexer on a constant string
+template <std::size_t N>
+class Parser
+{
+public:
+    constexpr explicit Parser(const char *s)
+        : s_(s), p_(0), tree_(), tk_(TK::NONE), op_(Ast::O::PLUS), at_(0),
+        n_(0), num_(0), exact_(false), lexError_(Error::NONE)
+    {
+    }
+
+    constexpr Tree<N> parse()
+    {
+        tree_.error = Error::NONE;
+        tree_.root = expr();
+        if (tree_.root >= 0) {
+            pre();
+            if (tk_ != TK::END) {
+                fail(Error::TRAILING);
+            }
+        }
+        if (tree_.error == Error::NONE) {
+            number();
+        }
+        return tree_;
+    }
+
+private:
+    enum class TK {
+        NONE, END, ERROR, OP, SYMBOL, STRING, NUMBER, T, F, OPEN, CLOSE,
+    };
+    const char *s_;
+    std::size_t p_;
+    Tree<N> tree_;
+    TK tk_;
+    Ast::O op_;
+    std::size_t at_;
+    std::size_t n_;
+    double num_;
+    bool exact_;
+    Error lexError_;
+
+    constexpr int peek() const
+    {
+        return p_ < N ? static_cast<unsigned char>(s_[p_]) : -1;
+    }
+
+    constexpr void push(char c)
+    {
+        tree_.pool[tree_.used++] = c;
+    }
+
+    constexpr void skipWs()
+    {
+        while (isSpace(peek())) {
+            ++p_;
+        }
+    }
+
+    constexpr TK lexError(Error e)
+    {
+        lexError_ = e;
+        return TK::ERROR;
+    }
+
+    constexpr TK next()
+    {
+        skipWs();
+        const int c = peek();
+        if (c < 0) {
+            return TK::END;
+        }
+        if (isAlpha(c) || c == '_') {
+            at_ = tree_.used;
+            if (!alpha()) {
+                return TK::ERROR;
+            }
+            n_ = tree_.used - at_;
+            const char *t = tree_.pool + at_;
+            if (n_ == 4 && t[0] == 't' && t[1] == 'r' && t[2] == 'u'
+                && t[3] == 'e'
+            ) {
+                return TK::T;
+            }
+            if (n_ == 5 && t[0] == 'f' && t[1] == 'a' && t[2] == 'l'
+                && t[3] == 's' && t[4] == 'e'
+            ) {
+                return TK::F;
+            }
+            return TK::SYMBOL;
+        }
+        if (isDigit(c)) {
+            return numeral();
+        }
+        switch (c) {
+            case '-':
+                return op(Ast::O::MINUS);
+            case '+':
+                return op(Ast::O::PLUS);
+            case '*':
+                return op(Ast::O::MULTIPLY);
+            case '/':
+                return op(Ast::O::DIVISION);
+            case '%':
+                return op(Ast::O::MODULO);
+            case '^':
+                return op(Ast::O::POWER);
+            case '(':
+                ++p_;
+                return TK::OPEN;
+            case ')':
+                ++p_;
+                return TK::CLOSE;
+            case '&':
+                return twoChars('&', Ast::O::LOGICAL_AND);
+            case '|':
+                return twoChars('|', Ast::O::LOGICAL_OR);
+            case '=':
+                return twoChars('=', Ast::O::CMP_EQ);
+            case '<':
+                return optionalEQ(Ast::O::CMP_LE, Ast::O::CMP_LT);
+            case '>':
+                return optionalEQ(Ast::O::CMP_GE, Ast::O::CMP_GT);
+            case '!':
+                return optionalEQ(Ast::O::CMP_NE, Ast::O::LOGICAL_NOT);
+            case '"': {
+                const std::size_t start = ++p_;
+                while (peek() != '"') {
+                    if (peek() < 0) {
+                        return lexError(Error::UNMATCHED_QUOTE);
+                    }
+                    ++p_;
+                }
+                at_ = tree_.used;
+                n_ = p_ - start;
+                for (std::size_t i = start; i < p_; ++i) {
+                    push(s_[i]);
+                }
+                ++p_;
+                return TK::STRING;
+            }
+            default:
+                return lexError(Error::INVALID_SYMBOL);
+        }
+    }
+
+    constexpr TK op(Ast::O o)
+    {
+        ++p_;
+        op_ = o;
+        return TK::OP;
+    }
+
+    constexpr TK twoChars(char second, Ast::O o)
+    {
+        ++p_;
+        if (peek() == second) {
+            ++p_;
+            op_ = o;
+            return TK::OP;
+        }
+        ++p_;
+        return lexError(Error::INVALID_OPERATOR);
+    }
+
+    constexpr TK optionalEQ(Ast::O withEQ, Ast::O without)
+    {
+        ++p_;
+        if (peek() == '=') {
+            ++p_;
+            op_ = withEQ;
+        } else {
+            op_ = without;
+        }
+        return TK::OP;
+    }
+
+    constexpr TK numeral()
+    {
+        const std::size_t start = p_;
+        while (isDigit(peek())) {
+            ++p_;
+        }
+        if (peek() == '.') {
+            ++p_;
+            while (isDigit(peek())) {
+                ++p_;
+            }
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            std::size_t e = p_ + 1;
+            if (e < N && (s_[e] == '+' || s_[e] == '-')) {
+                ++e;
+            }
+            if (e < N && isDigit(s_[e])) {
+                p_ = e;
+                while (isDigit(peek())) {
+                    ++p_;
+                }
+            }
+        }
+        at_ = tree_.used;
+        n_ = p_ - start;
+        for (std::size_t i = start; i < p_; ++i) {
+            push(s_[i]);
+        }
+        num_ = 0;
+        exact_ = exact(tree_.pool + at_, n_, num_);
+        return TK::NUMBER;
+    }
+
+    // the pieces of a symbol go to the pool, blanks between them do not
+    constexpr bool alpha()
+    {
+        do {
+            if (p_ < N) {
+                push(s_[p_++]);
+            }
+            while (isAlpha(peek()) || isDigit(peek()) || peek() == '_') {
+                push(s_[p_++]);
+            }
+            for (bool consumed = true; consumed; ) {
+                skipWs();
+                switch (peek()) {
+                    case '.':
+                        push(s_[p_++]);
+                        return alpha();
+                    case '(':
+                        consumed = brackets(')');
+                        break;
+                    case '[':
+                        consumed = brackets(']');
+                        break;
+                    case '{':
+                        consumed = brackets('}');
+                        break;
+                    default:
+                        consumed = false;
+                        continue;
+                }
+                if (!consumed) {
+                    return false;
+                }
+            }
+        } while (isAlpha(peek()) || peek() == '.' || peek() == '_');
+        return true;
+    }
+
+    constexpr bool brackets(char close)
+    {
+        push(s_[p_++]);
+        while (peek() != close) {
+            switch (peek()) {
+                case -1:
+                    lexError_ = Error::UNMATCHED_PARENTHESES;
+                    return false;
+                case '"': {
+                    const std::size_t start = p_++;
+                    while (peek() != '"') {
+                        if (peek() < 0) {
+                            lexError_ = Error::UNMATCHED_QUOTE;
+                            return false;
+                        }
+                        ++p_;
+                    }
+                    ++p_;
+                    for (std::size_t i = start; i < p_; ++i) {
+                        push(s_[i]);
+                    }
+                    break;
+                }
+                case '(':
+                    if (!brackets(')')) {
+                        return false;
+                    }
+                    break;
+                case '[':
+                    if (!brackets(']')) {
+                        return false;
+                    }
+                    break;
+                case '{':
+                    if (!brackets('}')) {
+                        return false;
+                    }
+                    break;
+                default:
+                    push(s_[p_++]);
+            }
+        }
+        push(s_[p_++]);
+        return true;
+    }
+
+    constexpr void pre()
+    {
+        if (tk_ == TK::NONE) {
+            tk_ = next();
+        }
+    }
+
+    constexpr void swallow()
+    {
+        tk_ = TK::NONE;
+    }
+
+    constexpr int fail(Error e)
+    {
+        if (tree_.error == Error::NONE) {
+            tree_.error = e;
+        }
+        return -1;
+    }
+
+    constexpr int add(const Node &n)
+    {
+        tree_.nodes[tree_.count] = n;
+        return static_cast<int>(tree_.count++);
+    }
+
+    constexpr int leaf(Ast::T t)
+    {
+        Node n{};
+        n.t = t;
+        n.left = n.right = -1;
+        n.at = at_;
+        n.n = n_;
+        n.num = num_;
+        n.exact = exact_;
+        n.b = t == Ast::T::BOOLEAN && tk_ == TK::T;
+        n.types = t == Ast::T::SYMBOL ? ANY_TYPE : typeSet(t);
+        swallow();
+        return add(n);
+    }
+
+    constexpr int node(Ast::O op, int left, int right)
+    {
+        if (right < 0) {
+            return -1;
+        }
+        Node n{};
+        n.t = Ast::T::OPERATOR;
+        n.op = op;
+        n.left = left;
+        n.right = right;
+        n.types = resultTypes(op, left < 0,
+            left < 0 ? 0 : tree_.nodes[left].types,
+            tree_.nodes[right].types);
+        return add(n);
+    }
+
+    constexpr int atomic()
+    {
+        pre();
+        switch (tk_) {
+            case TK::END:
+                return fail(Error::UNEXPECTED_END);
+            case TK::SYMBOL:
+                return leaf(Ast::T::SYMBOL);
+            case TK::STRING:
+                return leaf(Ast::T::STRING);
+            case TK::NUMBER:
+                return leaf(Ast::T::NUMBER);
+            case TK::T:
+            case TK::F:
+                return leaf(Ast::T::BOOLEAN);
+            case TK::OPEN: {
+                swallow();
+                const int root = expr();
+                if (root < 0) {
+                    return -1;
+                }
+                pre();
+                if (tk_ != TK::CLOSE) {
+                    return fail(Error::EXPECT_CLOSE);
+                }
+                swallow();
+                return root;
+            }
+            case TK::ERROR:
+                return fail(lexError_);
+            default:
+                return fail(Error::EXPECT_SOMETHING);
+        }
+    }
+
+    constexpr int deniable(bool pot)
+    {
+        pre();
+        if (tk_ != TK::OP) {
+            return pot ? potExpr() : atomic();
+        }
+        const Ast::O o = op_;
+        swallow();
+        switch (o) {
+            case Ast::O::PLUS:
+            case Ast::O::MINUS:
+            case Ast::O::LOGICAL_NOT:
+                return node(o, -1, pot ? potExpr() : atomic());
+            default:
+                return fail(Error::UNACCEPTABLE_OPERATOR);
+        }
+    }
+
+    constexpr int potExpr()
+    {
+        const int root = atomic();
+        if (root < 0) {
+            return -1;
+        }
+        pre();
+        if (tk_ == TK::OP && op_ == Ast::O::POWER) {
+            swallow();
+            return node(Ast::O::POWER, root, deniable(false));
+        }
+        return root;
+    }
+
+    constexpr int mulDivModExpr()
+    {
+        int root = deniable(true);
+        while (root >= 0) {
+            pre();
+            if (tk_ != TK::OP || (op_ != Ast::O::MULTIPLY
+                && op_ != Ast::O::DIVISION && op_ != Ast::O::MODULO)
+            ) {
+                break;
+            }
+            const Ast::O o = op_;
+            swallow();
+            root = node(o, root, deniable(true));
+        }
+        return root;
+    }
+
+    constexpr int plusMinusExpr()
+    {
+        int root = mulDivModExpr();
+        while (root >= 0) {
+            pre();
+            if (tk_ != TK::OP
+                || (op_ != Ast::O::PLUS && op_ != Ast::O::MINUS)
+            ) {
+                break;
+            }
+            const Ast::O o = op_;
+            swallow();
+            root = node(o, root, mulDivModExpr());
+        }
+        return root;
+    }
+
+    constexpr int cmpExpr()
+    {
+        const int root = plusMinusExpr();
+        if (root < 0) {
+            return -1;
+        }
+        pre();
+        if (tk_ != TK::OP) {
+            return root;
+        }
+        switch (op_) {
+            case Ast::O::CMP_EQ:
+            case Ast::O::CMP_NE:
+            case Ast::O::CMP_GT:
+            case Ast::O::CMP_GE:
+            case Ast::O::CMP_LT:
+            case Ast::O::CMP_LE: {
+                const Ast::O o = op_;
+                swallow();
+                return node(o, root, plusMinusExpr());
+            }
+            default:
+                return root;
+        }
+    }
+
+    constexpr int expr()
+    {
+        const int root = cmpExpr();
+        if (root < 0) {
+            return -1;
+        }
+        pre();
+        if (tk_ != TK::OP
+            || (op_ != Ast::O::LOGICAL_AND && op_ != Ast::O::LOGICAL_OR)
+        ) {
+            return root;
+        }
+        const Ast::O o = op_;
+        swallow();
+        return node(o, root, expr());
+    }
+
+    constexpr bool same(const Node &a, const Node &b) const
+    {
+        if (a.n != b.n) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.n; ++i) {
+            if (tree_.pool[a.at + i] != tree_.pool[b.at + i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool before(const Node &a, const Node &b) const
+    {
+        for (std::size_t i = 0; i < a.n && i < b.n; ++i) {
+            const unsigned char x = tree_.pool[a.at + i];
+            const unsigned char y = tree_.pool[b.at + i];
+            if (x != y) {
+                return x < y;
+            }
+        }
+        return a.n < b.n;
+    }
+
+    // numbers the symbols in the order of their texts like atoms()
+    constexpr void number()
+    {
+        tree_.slots = 0;
+        for (std::size_t i = 0; i < tree_.count; ++i) {
+            Node &n = tree_.nodes[i];
+            if (n.t != Ast::T::SYMBOL) {
+                continue;
+            }
+            bool first = true;
+            n.slot = 0;
+            for (std::size_t j = 0; j < tree_.count; ++j) {
+                const Node &m = tree_.nodes[j];
+                if (m.t != Ast::T::SYMBOL) {
+                    continue;
+                }
+                first &= j >= i || !same(m, n);
+                // one count per distinct text, at its first node
+                bool counted = true;
+                for (std::size_t k = 0; k < j; ++k) {
+                    const Node &o = tree_.nodes[k];
+                    counted &= o.t != Ast::T::SYMBOL || !same(o, m);
+                }
+                n.slot += counted && before(m, n);
+            }
+            tree_.slots += first;
+        }
+    }
+};
+
+template <std::size_t N>
+constexpr Tree<N> parse(const char *s)
+{
+    return Parser<N>(s).parse();
+}
+
+/// @brief the code of the expression Source::text()
+template <class Source, EvalMode M = EvalMode::STRICT>
+class Expression
+{
+    static constexpr std::size_t N = Source::size();
+    static constexpr Tree<N> tree = parse<N>(Source::text());
+    static_assert(tree.error != Error::UNEXPECTED_END, "unexpected end");
+    static_assert(tree.error != Error::EXPECT_CLOSE, "expect )");
+    static_assert(tree.error != Error::EXPECT_SOMETHING, "expect something");
+    static_assert(tree.error != Error::UNACCEPTABLE_OPERATOR,
+        "unacceptable operator");
+    static_assert(tree.error != Error::INVALID_OPERATOR,
+        "operator not understandable, do you mean '&&', '||' or '==' ?");
+    static_assert(tree.error != Error::INVALID_SYMBOL, "invalid symbol");
+    static_assert(tree.error != Error::UNMATCHED_QUOTE, "unmatched quote");
+    static_assert(tree.error != Error::UNMATCHED_PARENTHESES,
+        "unmatched parethenses");
+    static_assert(tree.error != Error::TRAILING,
+        "unprocessed components on the end, "
+        "maybe there is more than one expression given");
+
+public:
+    /// @brief the symbols in the order operator() expects their values
+    static std::vector<std::string> slots()
+    {
+        std::vector<std::string> s(tree.slots);
+        for (std::size_t i = 0; i < tree.count; ++i) {
+            const Node &n = tree.nodes[i];
+            if (n.t == Ast::T::SYMBOL) {
+                s[n.slot].assign(tree.pool + n.at, n.n);
+            }
+        }
+        return s;
+    }
+
+    /// @param args one value per slot, an UNKNOWN one is unbound
+    Value operator()(const Value *args, std::string &msg) const
+    {
+        // nothing to instantiate once a static_assert above failed
+        if constexpr (tree.error == Error::NONE) {
+            return node<tree.root>(args, msg);
+        } else {
+            return Value();
+        }
+    }
+
+    Value operator()(const Value::Dict &dict, std::string &msg) const
+    {
+        static const std::vector<std::string> names = slots();
+        std::vector<Value> args(names.size());
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            const auto v = dict.find(names[i]);
+            if (v != dict.end()) {
+                args[i] = v->second;
+            }
+        }
+        return (*this)(args.data(), msg);
+    }
+
+private:
+    // a number strtod() may round differently than one multiplication
+    template <int I>
+    static double inexact()
+    {
+        static const double v = parseNumber(
+            tree.pool + tree.nodes[I].at, tree.nodes[I].n);
+        return v;
+    }
+
+    template <int I>
+    static Value node(const Value *args, std::string &msg)
+    {
+        constexpr Node n = tree.nodes[I];
+        if constexpr (n.t == Ast::T::NUMBER) {
+            return Value(n.exact ? n.num : inexact<I>());
+        } else if constexpr (n.t == Ast::T::BOOLEAN) {
+            return Value(n.b);
+        } else if constexpr (n.t == Ast::T::STRING) {
+            return Value(Span(tree.pool + n.at, n.n));
+        } else if constexpr (n.t == Ast::T::SYMBOL) {
+            if (!args[n.slot]) {
+                msg = "unsolvable symbol ";
+                msg.append(tree.pool + n.at, n.n);
+                return Value();
+            }
+            return args[n.slot];
+        } else if constexpr (n.left < 0) {
+            const Value v = node<n.right>(args, msg);
+            if (!v) {
+                return v;
+            }
+            return unary<n.op, tree.nodes[n.right].types>(v, msg);
+        } else if constexpr (M == EvalMode::SHORT_CIRCUIT
+            && (n.op == Ast::O::LOGICAL_AND || n.op == Ast::O::LOGICAL_OR)
+        ) {
+            const Value l = node<n.left>(args, msg);
+            if (!l || decides(n.op, l)) {
+                return l;
+            }
+            const Value r = node<n.right>(args, msg);
+            if (!r) {
+                return r;
+            }
+            return binary<n.op, tree.nodes[n.left].types,
+                tree.nodes[n.right].types>(l, r, msg);
+        } else {
+            // the right operand first, like the Program does
+            const Value r = node<n.right>(args, msg);
+            if (!r) {
+                return r;
+            }
+            const Value l = node<n.left>(args, msg);
+            if (!l) {
+                return l;
+            }
+            return binary<n.op, tree.nodes[n.left].types,
+                tree.nodes[n.right].types>(l, r, msg);
+        }
+    }
+
+    template <Ast::O O, TypeSet T>
+    static Value unary(const Value &v, std::string &msg)
+    {
+        if constexpr (O == Ast::O::PLUS && T == typeSet(Ast::T::NUMBER)) {
+            return v;
+        } else if constexpr (O == Ast::O::MINUS
+            && T == typeSet(Ast::T::NUMBER)
+        ) {
+            return Value(-v.num());
+        } else if constexpr (O == Ast::O::LOGICAL_NOT
+            && T == typeSet(Ast::T::BOOLEAN)
+        ) {
+            return Value(!v.b());
+        } else {
+            return apply(O, v, msg);
+        }
+    }
+
+    template <Ast::O O, TypeSet L, TypeSet R>
+    static Value binary(const Value &l, const Value &r, std::string &msg)
+    {
+        constexpr TypeSet number = typeSet(Ast::T::NUMBER);
+        constexpr TypeSet string = typeSet(Ast::T::STRING);
+        constexpr TypeSet boolean = typeSet(Ast::T::BOOLEAN);
+        if constexpr (L == number && R == number) {
+            return numbers<O>(l, r, msg);
+        } else if constexpr (L == string && R == string
+            && O != Ast::O::PLUS
+        ) {
+            return strings<O>(l, r, msg);
+        } else if constexpr (L == boolean && R == boolean) {
+            return booleans<O>(l, r, msg);
+        } else {
+            return apply(O, l, r, msg);
+        }
+    }
+
+    template <Ast::O O>
+    static Value numbers(const Value &l, const Value &r, std::string &msg)
+    {
+        const double a = l.num();
+        const double b = r.num();
+        if constexpr (O == Ast::O::PLUS) {
+            return Value(a + b);
+        } else if constexpr (O == Ast::O::MINUS) {
+            return Value(a - b);
+        } else if constexpr (O == Ast::O::MULTIPLY) {
+            return Value(a * b);
+        } else if constexpr (O == Ast::O::DIVISION) {
+            if (b == 0) {
+                msg = "divide by 0";
+                return Value();
+            }
+            return Value(a / b);
+        } else if constexpr (O == Ast::O::MODULO) {
+            const int d = truncate(b);
+            if (d == 0) {
+                msg = "modulo by 0";
+                return Value();
+            }
+            return Value(modulo(truncate(a), d));
+        } else if constexpr (O == Ast::O::POWER) {
+            return Value(std::pow(a, b));
+        } else if constexpr (O == Ast::O::CMP_EQ) {
+            return Value(a == b);
+        } else if constexpr (O == Ast::O::CMP_NE) {
+            return Value(a != b);
+        } else if constexpr (O == Ast::O::CMP_GT) {
+            return Value(a > b);
+        } else if constexpr (O == Ast::O::CMP_GE) {
+            return Value(a >= b);
+        } else if constexpr (O == Ast::O::CMP_LT) {
+            return Value(a < b);
+        } else if constexpr (O == Ast::O::CMP_LE) {
+            return Value(a <= b);
+        } else {
+            return apply(O, l, r, msg);
+        }
+    }
+
+    template <Ast::O O>
+    static Value strings(const Value &l, const Value &r, std::string &msg)
+    {
+        if constexpr (O == Ast::O::CMP_EQ) {
+            return Value(l.compare(r) == 0);
+        } else if constexpr (O == Ast::O::CMP_NE) {
+            return Value(l.compare(r) != 0);
+        } else if constexpr (O == Ast::O::CMP_GT) {
+            return Value(l.compare(r) > 0);
+        } else if constexpr (O == Ast::O::CMP_GE) {
+            return Value(l.compare(r) >= 0);
+        } else if constexpr (O == Ast::O::CMP_LT) {
+            return Value(l.compare(r) < 0);
+        } else if constexpr (O == Ast::O::CMP_LE) {
+            return Value(l.compare(r) <= 0);
+        } else {
+            return apply(O, l, r, msg);
+        }
+    }
+
+    template <Ast::O O>
+    static Value booleans(const Value &l, const Value &r, std::string &msg)
+    {
+        if constexpr (O == Ast::O::LOGICAL_AND) {
+            return Value(l.b() && r.b());
+        } else if constexpr (O == Ast::O::LOGICAL_OR) {
+            return Value(l.b() || r.b());
+        } else if constexpr (O == Ast::O::CMP_EQ) {
+            return Value(l.b() == r.b());
+        } else if constexpr (O == Ast::O::CMP_NE) {
+            return Value(l.b() != r.b());
+        } else {
+            return apply(O, l, r, msg);
+        }
+    }
+};
+
+} // namespace compiled
+
+#endif
@@ -0,0 +1,282 @@
+#include "csv.h"
+#include "mapping.h"
+#include "number.h"
+
+#include <cstring>
+#include <deque>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/// @brief calls f(i) for the offset i of every ',', '"' and '\n' of p
+/// until it returns false
+/// @return false if f did
+template <class F>
+bool scan(const char *p, std::size_t n, F f)
+{
+    std::size_t i = 0;
+#ifdef __SSE2__
+    // compares 16 bytes at once, only the few bytes found are looked at
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(p + i));
+        unsigned m = _mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+            _mm_cmpeq_epi8(v, newline)));
+        while (m) {
+            if (!f(i + __builtin_ctz(m))) {
+                return false;
+            }
+            m &= m - 1;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if ((p[i] == ',' || p[i] == '"' || p[i] == '\n') && !f(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Field
+{
+    const char *p;
+    std::size_t n;
+    bool quoted;
+};
+
+/// @brief splits p into rows of fields, calls field(index, Field) for
+/// every field and row() after the fields of each row, empty lines are
+/// skipped and a line break before \n is no part of the last field
+/// @return the offset after the row row() returned false for, else n
+template <class FieldF, class RowF>
+std::size_t split(const char *p, std::size_t n, FieldF field, RowF row)
+{
+    std::size_t start = 0;
+    std::size_t index = 0;
+    bool inQuote = false;
+    bool quoted = false;
+    const auto make = [&](std::size_t end) {
+        if (end > start && p[end - 1] == '\r') {
+            --end;
+        }
+        return Field{p + start, end - start, quoted};
+    };
+    const bool all = scan(p, n, [&](std::size_t i) {
+        if (p[i] == '"') {
+            quoted = quoted || i == start;
+            inQuote = !inQuote;
+            return true;
+        }
+        if (inQuote) {
+            return true;
+        }
+        if (p[i] == ',') {
+            field(index++, Field{p + start, i - start, quoted});
+            start = i + 1;
+            quoted = false;
+            return true;
+        }
+        const Field f = make(i);
+        const bool empty = index == 0 && f.n == 0;
+        start = i + 1;
+        quoted = false;
+        if (empty) {
+            return true;
+        }
+        field(index, f);
+        index = 0;
+        return row();
+    });
+    if (!all) {
+        return start;
+    }
+    const Field f = make(n);
+    if (index > 0 || f.n > 0) {
+        field(index, f);
+        row();
+    }
+    return n;
+}
+
+/// @brief the text of f without the quotes, "" of a quoted field is "
+Span text(const Field &f, std::deque<std::string> &decoded)
+{
+    if (!f.quoted || f.n < 2 || f.p[f.n - 1] != '"') {
+        return Span(f.p, f.n);
+    }
+    const Span inner(f.p + 1, f.n - 2);
+    if (!std::memchr(inner.p, '"', inner.n)) {
+        return inner;
+    }
+    decoded.emplace_back();
+    std::string &s = decoded.back();
+    for (std::size_t i = 0; i < inner.n; ++i) {
+        s += inner.p[i];
+        i += inner.p[i] == '"' && i + 1 < inner.n && inner.p[i + 1] == '"';
+    }
+    return Span(s);
+}
+
+} // namespace
+
+struct CsvFileImpl
+{
+    CsvFileImpl() : msg("no file is opened"), body(0), rows(0) {}
+    /// @brief the values of a column of one of the types
+    struct Storage
+    {
+        std::vector<double> real;
+        std::unique_ptr<bool[]> boolean;
+        std::vector<Span> str;
+    };
+    Column convert(const std::vector<Field> &fields, Storage &s);
+    Mapping map;
+    std::string msg;
+    std::vector<std::string> header;
+    std::size_t body;     ///< the offset of the first row after the header
+    std::size_t rows;
+    Expression::Columns columns;
+    std::vector<Storage> storage;
+    std::deque<std::string> decoded;
+};
+
+Column CsvFileImpl::convert(const std::vector<Field> &fields, Storage &s)
+{
+    const std::size_t n = fields.size();
+    s.real.resize(n);
+    bool numbers = true;
+    for (std::size_t i = 0; i < n && numbers; ++i) {
+        const Field &f = fields[i];
+        numbers = !f.quoted && readNumber(f.p, f.n, s.real[i]);
+    }
+    if (numbers) {
+        return Column(s.real.data());
+    }
+    s.real.clear();
+    s.boolean.reset(new bool[n]);
+    bool booleans = true;
+    for (std::size_t i = 0; i < n && booleans; ++i) {
+        const Span t(fields[i].p, fields[i].n);
+        s.boolean[i] = t == Span("true", 4);
+        booleans = !fields[i].quoted
+            && (s.boolean[i] || t == Span("false", 5));
+    }
+    if (booleans) {
+        return Column(s.boolean.get());
+    }
+    s.boolean.reset();
+    s.str.reserve(n);
+    for (const auto &f : fields) {
+        s.str.push_back(text(f, decoded));
+    }
+    return Column(s.str.data());
+}
+
+CsvFile::CsvFile()
+    : impl_(new CsvFileImpl())
+{
+}
+
+CsvFile::~CsvFile()
+{
+}
+
+bool CsvFile::open(const std::string &path)
+{
+    CsvFileImpl &impl = *impl_;
+    impl.header.clear();
+    impl.columns.clear();
+    impl.storage.clear();
+    impl.decoded.clear();
+    impl.rows = 0;
+    impl.body = 0;
+    if (!impl.map.open(path, false, impl.msg)) {
+        return false;
+    }
+    std::deque<std::string> decoded;
+    impl.body = split(impl.map.data(), impl.map.size(),
+        [&](std::size_t, const Field &f) {
+            impl.header.push_back(text(f, decoded).str());
+        },
+        [] { return false; });
+    impl.msg = "no error";
+    return true;
+}
+
+const std::string &CsvFile::msg() const
+{
+    return impl_->msg;
+}
+
+const std::vector<std::string> &CsvFile::header() const
+{
+    return impl_->header;
+}
+
+std::size_t CsvFile::read(const std::set<std::string> &symbols)
+{
+    CsvFileImpl &impl = *impl_;
+    impl.columns.clear();
+    impl.storage.clear();
+    impl.decoded.clear();
+    impl.rows = 0;
+    if (!impl.map.data()) {
+        return 0;
+    }
+    // the position in fields of each column of the header that is read
+    const std::size_t NONE = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> wanted(impl.header.size(), NONE);
+    std::vector<std::vector<Field> > fields;
+    std::set<std::string> found;
+    for (std::size_t i = 0; i < impl.header.size(); ++i) {
+        const std::string &name = impl.header[i];
+        if (symbols.count(name) && found.insert(name).second) {
+            wanted[i] = fields.size();
+            fields.emplace_back();
+        }
+    }
+    std::size_t rows = 0;
+    split(impl.map.data() + impl.body, impl.map.size() - impl.body,
+        [&](std::size_t index, const Field &f) {
+            if (index < wanted.size() && wanted[index] != NONE) {
+                fields[wanted[index]].push_back(f);
+            }
+        },
+        [&] {
+            // a row missing fields has empty ones
+            ++rows;
+            for (auto &column : fields) {
+                if (column.size() < rows) {
+                    column.push_back(Field{"", 0, false});
+                }
+            }
+            return true;
+        });
+    impl.rows = rows;
+    impl.storage.resize(fields.size());
+    for (std::size_t i = 0; i < impl.header.size(); ++i) {
+        if (wanted[i] != NONE) {
+            impl.columns[impl.header[i]] = impl.convert(
+                fields[wanted[i]], impl.storage[wanted[i]]);
+        }
+    }
+    return rows;
+}
+
+std::size_t CsvFile::rows() const
+{
+    return impl_->rows;
+}
+
+const Expression::Columns &CsvFile::columns() const
+{
+    return impl_->columns;
+}
@@ -0,0 +1,41 @@
+#ifndef ARIADNE_PARSER_CSV_H
+#define ARIADNE_PARSER_CSV_H
+
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "interface.h"
+
+struct CsvFileImpl;
+/// @brief a CSV file mapped read-only and read into the Columns of
+/// Expression::eval() without a parameter per field
+/// @note the first row names the columns. A column is REAL if all of its
+/// fields are numbers, BOOL if all are true or false, else STRING with
+/// the fields as written. Quoted fields are strings, their separators and
+/// line breaks are part of them. String columns point into the mapping,
+/// columns() is valid until the next open() or read().
+class DLL_EXPORT CsvFile {
+public:
+    CsvFile();
+    ~CsvFile();
+    CsvFile(const CsvFile &) = delete;
+    CsvFile &operator=(const CsvFile &) = delete;
+    /// @brief maps path and reads its header
+    /// @return false if it cannot be mapped, msg() tells why
+    bool open(const std::string &path);
+    const std::string &msg() const;
+    const std::vector<std::string> &header() const;
+    /// @brief reads the columns named in symbols, e.g. the symbols() of
+    /// the expressions to evaluate, and skips all others
+    /// @return the number of rows
+    std::size_t read(const std::set<std::string> &symbols);
+    std::size_t rows() const;
+    const Expression::Columns &columns() const;
+private:
+    std::unique_ptr<CsvFileImpl> impl_;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "dag.h"
+
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+const std::uint32_t Dag::NONE;
+
+namespace {
+
+// the payload of a node with its children replaced by their indices,
+// numbers compare by bit pattern so that 0 and -0 stay apart, strings
+// by their Atom
+struct Key
+{
+    Ast::T t;
+    Ast::O op;
+    std::uint64_t bits;
+    Atom str;
+    std::uint32_t left;
+    std::uint32_t right;
+    bool operator==(const Key &k) const
+    {
+        return t == k.t && op == k.op && bits == k.bits && str == k.str
+            && left == k.left && right == k.right;
+    }
+};
+
+struct KeyHash
+{
+    std::size_t operator()(const Key &k) const
+    {
+        std::size_t h = 0;
+        const std::uint64_t parts[] = {
+            static_cast<std::uint64_t>(k.t),
+            static_cast<std::uint64_t>(k.op),
+            k.bits, k.str.id(), k.left, k.right
+        };
+        for (const auto p : parts) {
+            h ^= std::hash<std::uint64_t>()(p) + 0x9E3779B97F4A7C15ULL
+                + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+struct Builder
+{
+    Dag &dag;
+    std::unordered_map<Key, std::uint32_t, KeyHash> index;
+
+    std::uint32_t add(const Ast::Ptr &p)
+    {
+        if (!p) {
+            return Dag::NONE;
+        }
+        Key k;
+        k.t = p->t;
+        k.op = Ast::O::PLUS;
+        k.bits = 0;
+        switch (p->t) {
+            case Ast::T::NUMBER:
+                std::memcpy(&k.bits, &p->num, sizeof(p->num));
+                break;
+            case Ast::T::BOOLEAN:
+                k.bits = p->b;
+                break;
+            case Ast::T::OPERATOR:
+                k.op = p->op;
+                break;
+            default:
+                k.str = p->str;
+                break;
+        }
+        k.right = add(p->right);
+        k.left = add(p->left);
+        const auto r = index.insert(
+            std::make_pair(k, static_cast<std::uint32_t>(dag.nodes.size()))
+        );
+        if (r.second) {
+            Dag::Node n;
+            n.t = p->t;
+            n.op = k.op;
+            n.num = p->t == Ast::T::NUMBER ? p->num : 0;
+            n.b = p->t == Ast::T::BOOLEAN && p->b;
+            n.str = k.str;
+            n.left = k.left;
+            n.right = k.right;
+            n.uses = 0;
+            for (const auto c : {k.left, k.right}) {
+                if (c != Dag::NONE) {
+                    ++dag.nodes[c].uses;
+                }
+            }
+            dag.nodes.push_back(std::move(n));
+        }
+        return r.first->second;
+    }
+};
+
+} // namespace
+
+Dag share(const Ast::Ptr &root)
+{
+    Dag dag;
+    Builder b = {dag, {}};
+    b.add(root);
+    return dag;
+}
@@ -0,0 +1,38 @@
+#ifndef HEADER_114A7C621E5840EFB55FD3A80FDA6338
+#define HEADER_114A7C621E5840EFB55FD3A80FDA6338
+
+#include "ast.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief hash consed Ast, structurally equal subtrees share one node
+/// @note nodes are stored children first, so a node only refers to nodes
+/// with a smaller index and the root is the last one.
+struct Dag
+{
+    static const std::uint32_t NONE = 0xFFFFFFFF;
+    struct Node
+    {
+        Ast::T t;
+        Ast::O op;
+        double num;
+        bool b;
+        Atom str;
+        std::uint32_t left;
+        std::uint32_t right;
+        std::uint32_t uses; ///< number of edges pointing to this node
+    };
+    std::vector<Node> nodes;
+    std::uint32_t root() const
+    {
+        return nodes.empty()
+            ? NONE : static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+};
+
+Dag share(const Ast::Ptr &root);
+
+#endif
@@ -47,7 +47,7 @@ int main()
         dict[s] = p;
     }
     auto v = e.eval(dict);
-    if (!e) { //  or to write if (!v.first)
+    if (!v.first) {
         std::cerr << "Error: " << v.second << std::endl;
         return 3;
     }
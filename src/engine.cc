@@ -0,0 +1,120 @@
+#include "engine.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <unordered_map>
+
+struct EngineImpl
+{
+    EngineImpl() : epoch(0) {}
+    std::vector<std::unique_ptr<Expression::Session> > sessions;
+    std::vector<Engine::Result> results;
+    // the expressions reading each symbol, built from their symbols()
+    std::unordered_map<std::string, std::vector<Engine::Id> > readers;
+    std::map<std::string, std::shared_ptr<parameter> > bound;
+    std::map<std::string, std::shared_ptr<parameter> > pending;
+    std::vector<unsigned> seen;
+    unsigned epoch;
+};
+
+// a parameter of a type Expressions do not support leaves symbol unbound
+static void rebind(
+    Expression::Session &s,
+    const std::string &symbol,
+    const std::shared_ptr<parameter> &v
+)
+{
+    if (!s.set(symbol, v)) {
+        s.set(symbol, std::shared_ptr<parameter>());
+    }
+}
+
+Engine::Engine()
+    : impl_(new EngineImpl())
+{
+}
+
+Engine::~Engine()
+{
+}
+
+Engine::Id Engine::add(const Expression &e)
+{
+    const Id id = impl_->sessions.size();
+    std::unique_ptr<Expression::Session> s(new Expression::Session(e));
+    for (const auto &name : e.symbols()) {
+        impl_->readers[name].push_back(id);
+        const auto b = impl_->bound.find(name);
+        if (b != impl_->bound.end()) {
+            rebind(*s, name, b->second);
+        }
+    }
+    impl_->results.push_back(s->eval());
+    impl_->sessions.push_back(std::move(s));
+    impl_->seen.push_back(0);
+    return id;
+}
+
+std::size_t Engine::size() const
+{
+    return impl_->sessions.size();
+}
+
+void Engine::set(
+    const std::string &symbol,
+    const std::shared_ptr<parameter> &v
+)
+{
+    impl_->pending[symbol] = v;
+}
+
+void Engine::set(const entity_list &params)
+{
+    for (const auto &e : params.getList()) {
+        const auto p = std::dynamic_pointer_cast<parameter>(e);
+        if (p) {
+            set(p->getName(), p);
+        }
+    }
+}
+
+std::vector<Engine::Id> Engine::update()
+{
+    EngineImpl &impl = *impl_;
+    if (++impl.epoch == 0) {
+        std::fill(impl.seen.begin(), impl.seen.end(), 0);
+        impl.epoch = 1;
+    }
+    std::vector<Id> dirty;
+    for (const auto &p : impl.pending) {
+        if (p.second) {
+            impl.bound[p.first] = p.second;
+        } else {
+            impl.bound.erase(p.first);
+        }
+        const auto r = impl.readers.find(p.first);
+        if (r == impl.readers.end()) {
+            continue;
+        }
+        for (const Id id : r->second) {
+            rebind(*impl.sessions[id], p.first, p.second);
+            if (impl.seen[id] != impl.epoch) {
+                impl.seen[id] = impl.epoch;
+                dirty.push_back(id);
+            }
+        }
+    }
+    impl.pending.clear();
+    std::sort(dirty.begin(), dirty.end());
+    for (const Id id : dirty) {
+        impl.results[id] = impl.sessions[id]->eval();
+    }
+    return dirty;
+}
+
+const Engine::Result &Engine::result(Engine::Id id) const
+{
+    assert(id < impl_->results.size());
+    return impl_->results[id];
+}
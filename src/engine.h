@@ -0,0 +1,50 @@
+#ifndef ARIADNE_PARSER_ENGINE_H
+#define ARIADNE_PARSER_ENGINE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <entity.h> // ariadne code
+#include <parameter.h>
+
+#include "interface.h"
+
+struct EngineImpl;
+/// @brief keeps the results of many Expressions over one set of
+/// parameters up to date
+/// @note set() only records a change, update() applies all recorded
+/// changes in one pass and evaluates every Expression depending on any
+/// of them once. The Expressions only recompute the nodes depending on
+/// changed parameters. An Engine must not be used from several threads
+/// at once.
+class DLL_EXPORT Engine {
+public:
+    typedef std::size_t Id;
+    typedef std::pair<std::shared_ptr<parameter>, std::string> Result;
+    Engine();
+    ~Engine();
+    Engine(const Engine &) = delete;
+    Engine &operator=(const Engine &) = delete;
+    /// @brief registers e and evaluates it with the current parameters
+    /// @return the id of e, ids count from 0 in the order of add()
+    Id add(const Expression &e);
+    std::size_t size() const;
+    /// @brief records symbol to be bound to v, a null pointer unbinds it
+    /// @note v is read by update(), the last set() of a symbol wins. A
+    /// parameter of a type Expressions do not support leaves it unbound.
+    void set(const std::string &symbol, const std::shared_ptr<parameter> &v);
+    /// @brief set() for every parameter of params, by name
+    void set(const entity_list &params);
+    /// @brief applies the recorded changes
+    /// @return the ids of the re-evaluated Expressions, ascending
+    std::vector<Id> update();
+    /// @brief the result of the Expression id as of the last update()
+    const Result &result(Id id) const;
+private:
+    std::unique_ptr<EngineImpl> impl_;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef HEADER_06823566B52942E3864EA3F437BFF23E
+#define HEADER_06823566B52942E3864EA3F437BFF23E
+
+#include "interface.h"
+#include "ast.h"
+#include "filter.h"
+#include "infer.h"
+#include "intern.h"
+#include "value.h"
+#include "vm.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <parameter.h> // ariadne code
+
+struct ExpressionImpl
+{
+    ExpressionImpl()
+        : mode_(EvalMode::STRICT), folded_(0), keepSource_(false),
+        parsed_(false), hasError_(true), msg_("no expression is given")
+    {
+        stats_.nodes = 0;
+        stats_.removed = 0;
+        stats_.shared = 0;
+    }
+    std::string source_;
+    std::unique_ptr<Ast> ast_;
+    std::vector<Atom> slots_;
+    Program program_;
+    Filter filter_;
+    Declared declared_;
+    EvalMode mode_;
+    Expression::Stats stats_;
+    std::size_t folded_;
+    bool keepSource_;
+    // the last parse() gave a complete expression, hasError_ may still
+    // be set by the declared types
+    bool parsed_;
+    bool hasError_;
+    std::string msg_;
+};
+
+/// @brief the tree impl evaluates, copy holds it if it differs from ast_
+/// @note ast_ only carries rewrites valid in every mode, the ones that
+/// depend on short circuit evaluation are done on copy
+const Ast::Ptr &tree(
+    const ExpressionImpl &impl,
+    Ast::Ptr &copy,
+    std::size_t &removed
+);
+/// @brief the value of p, false if expressions do not support its type
+bool toValue(const parameter &p, Value &v);
+
+#endif
@@ -0,0 +1,110 @@
+#include "filter.h"
+#include "batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace {
+
+std::uint32_t add(Filter &f, const Ast::Ptr &root)
+{
+    Filter::Node n;
+    n.leaf = !(root->t == Ast::T::OPERATOR && root->left
+        && (root->op == Ast::O::LOGICAL_AND
+            || (root->op == Ast::O::LOGICAL_OR
+                && f.mode == EvalMode::SHORT_CIRCUIT)));
+    n.op = root->op;
+    n.left = n.right = Dag::NONE;
+    if (n.leaf) {
+        n.program = compile(root, f.mode);
+    } else {
+        n.left = add(f, root->left);
+        n.right = add(f, root->right);
+    }
+    f.nodes.push_back(std::move(n));
+    return static_cast<std::uint32_t>(f.nodes.size() - 1);
+}
+
+// dst becomes the ascending union of the disjoint dst and src
+void unite(
+    std::vector<std::uint32_t> &dst,
+    const std::vector<std::uint32_t> &src
+)
+{
+    const std::size_t n = dst.size();
+    dst.insert(dst.end(), src.begin(), src.end());
+    std::inplace_merge(dst.begin(), dst.begin() + n, dst.end());
+}
+
+// splits rows into yes and no like the batch run() of a Program
+void split(
+    const Filter &f,
+    std::uint32_t k,
+    const Column *args,
+    const std::vector<std::uint32_t> &rows,
+    std::vector<std::uint32_t> &yes,
+    std::vector<std::uint32_t> *no
+)
+{
+    const Filter::Node &n = f.nodes[k];
+    if (n.leaf) {
+        run(n.program, args, rows.data(), rows.size(), yes, no);
+        return;
+    }
+    std::vector<std::uint32_t> t, u;
+    if (n.op == Ast::O::LOGICAL_AND) {
+        // in STRICT mode the rows the left operand gives false for might
+        // still fail in the right one, only SHORT_CIRCUIT asks for them
+        assert(!no || f.mode == EvalMode::SHORT_CIRCUIT);
+        split(f, n.left, args, rows, t, no ? &u : nullptr);
+        split(f, n.right, args, t, yes, no);
+        if (no) {
+            unite(*no, u);
+        }
+    } else {
+        split(f, n.left, args, rows, t, &u);
+        split(f, n.right, args, u, yes, no);
+        unite(yes, t);
+    }
+}
+
+} // namespace
+
+Filter plan(const Ast::Ptr &root, EvalMode mode)
+{
+    Filter f;
+    f.mode = mode;
+    if (root) {
+        add(f, root);
+    }
+    return f;
+}
+
+void bindSlots(Filter &f, const std::vector<Atom> &slots)
+{
+    for (auto &n : f.nodes) {
+        if (n.leaf) {
+            bindSlots(n.program, slots);
+        }
+    }
+}
+
+void run(
+    const Filter &f,
+    const Column *args,
+    std::size_t rows,
+    std::vector<std::uint32_t> &selection
+)
+{
+    selection.clear();
+    if (f.nodes.empty()) {
+        return;
+    }
+    std::vector<std::uint32_t> all(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        all[i] = static_cast<std::uint32_t>(i);
+    }
+    split(f, static_cast<std::uint32_t>(f.nodes.size() - 1), args, all,
+        selection, nullptr);
+}
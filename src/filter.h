@@ -0,0 +1,46 @@
+#ifndef HEADER_E6BA2962948140CFBB65446A58A27FF1
+#define HEADER_E6BA2962948140CFBB65446A58A27FF1
+
+#include "ast.h"
+#include "column.h"
+#include "vm.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief a predicate split at its && into parts run one after the other
+/// @note every part only sees the rows the parts before it let through.
+/// In SHORT_CIRCUIT mode || is split as well, its right operand only sees
+/// the rows its left one gives false for. In STRICT mode || keeps both
+/// operands, since an error in either one drops the row. The nodes are
+/// stored children first, the root last.
+struct Filter
+{
+    struct Node
+    {
+        bool leaf;
+        Ast::O op;
+        std::uint32_t left, right;
+        Program program;
+    };
+    std::vector<Node> nodes;
+    EvalMode mode;
+};
+
+Filter plan(const Ast::Ptr &root, EvalMode mode = EvalMode::STRICT);
+/// @brief bindSlots() for the Program of every leaf
+void bindSlots(Filter &f, const std::vector<Atom> &slots);
+/// @brief the rows of [0, rows) for which the predicate gives true
+/// @param args one column per slot the Filter is bound to
+/// @note rows giving false, an error or no boolean are left out,
+/// selection is ascending
+void run(
+    const Filter &f,
+    const Column *args,
+    std::size_t rows,
+    std::vector<std::uint32_t> &selection
+);
+
+#endif
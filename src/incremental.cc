@@ -0,0 +1,159 @@
+#include "incremental.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+Incremental::Incremental(Dag dag, EvalMode mode)
+    : dag_(std::move(dag)), mode_(mode),
+    first_(dag_.nodes.size() + 1, 0),
+    bound_(dag_.nodes.size()), values_(dag_.nodes.size()),
+    msgs_(dag_.nodes.size()), dirty_(dag_.nodes.size(), 1),
+    seen_(dag_.nodes.size(), 0), epoch_(0), recomputed_(0)
+{
+    // a node using the same child twice is listed as its parent once
+    const auto &nodes = dag_.nodes;
+    for (const auto &n : nodes) {
+        if (n.left != Dag::NONE) {
+            ++first_[n.left + 1];
+        }
+        if (n.right != Dag::NONE && n.right != n.left) {
+            ++first_[n.right + 1];
+        }
+    }
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        first_[i + 1] += first_[i];
+    }
+    parents_.resize(first_.back());
+    std::vector<std::uint32_t> fill(first_.begin(), first_.end() - 1);
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        const auto &n = nodes[i];
+        if (n.t == Ast::T::SYMBOL) {
+            symbols_[n.str.id()] = i;
+        }
+        if (n.left != Dag::NONE) {
+            parents_[fill[n.left]++] = i;
+        }
+        if (n.right != Dag::NONE && n.right != n.left) {
+            parents_[fill[n.right]++] = i;
+        }
+    }
+}
+
+bool Incremental::set(Atom symbol, const Value &v)
+{
+    const auto s = symbols_.find(symbol.id());
+    if (s == symbols_.end()) {
+        return false;
+    }
+    bound_[s->second] = v;
+    mark(s->second);
+    return true;
+}
+
+// marks node and everything above it, nodes left marked by an earlier
+// SHORT_CIRCUIT eval() may have clean parents, so marked nodes are not a
+// reason to stop
+void Incremental::mark(std::uint32_t node)
+{
+    if (++epoch_ == 0) {
+        std::fill(seen_.begin(), seen_.end(), 0);
+        epoch_ = 1;
+    }
+    std::vector<std::uint32_t> todo(1, node);
+    seen_[node] = epoch_;
+    while (!todo.empty()) {
+        const std::uint32_t i = todo.back();
+        todo.pop_back();
+        dirty_[i] = 1;
+        for (std::uint32_t k = first_[i]; k < first_[i + 1]; ++k) {
+            const std::uint32_t p = parents_[k];
+            if (seen_[p] != epoch_) {
+                seen_[p] = epoch_;
+                todo.push_back(p);
+            }
+        }
+    }
+}
+
+const Value &Incremental::pull(std::uint32_t node)
+{
+    if (dirty_[node]) {
+        msgs_[node].clear();
+        values_[node] = compute(node, msgs_[node]);
+        dirty_[node] = 0;
+        ++recomputed_;
+    }
+    return values_[node];
+}
+
+// the same steps as the recursive eval(), an error of an operand is
+// passed on with its message
+Value Incremental::compute(std::uint32_t node, std::string &msg)
+{
+    const Dag::Node &n = dag_.nodes[node];
+    switch (n.t) {
+        case Ast::T::NUMBER:
+            return Value(n.num);
+        case Ast::T::BOOLEAN:
+            return Value(n.b);
+        case Ast::T::STRING:
+            return Value(n.str.str());
+        case Ast::T::SYMBOL:
+            if (!bound_[node]) {
+                msg = "unsolvable symbol " + n.str.str();
+            }
+            return bound_[node];
+        case Ast::T::OPERATOR:
+            break;
+        default:
+            assert(false /* unreachable */);
+            return Value();
+    }
+    INSTRUMENT_OPERATOR(n.op, 1);
+    if (mode_ == EvalMode::SHORT_CIRCUIT && n.left != Dag::NONE
+        && (n.op == Ast::O::LOGICAL_AND || n.op == Ast::O::LOGICAL_OR)
+    ) {
+        const Value &l = pull(n.left);
+        if (!l) {
+            msg = msgs_[n.left];
+            return Value();
+        }
+        if (decides(n.op, l)) {
+            return l;
+        }
+        const Value &r = pull(n.right);
+        if (!r) {
+            msg = msgs_[n.right];
+            return Value();
+        }
+        return apply(n.op, l, r, msg);
+    }
+    const Value &r = pull(n.right);
+    if (!r) {
+        msg = msgs_[n.right];
+        return Value();
+    }
+    if (n.left == Dag::NONE) {
+        return apply(n.op, r, msg);
+    }
+    const Value &l = pull(n.left);
+    if (!l) {
+        msg = msgs_[n.left];
+        return Value();
+    }
+    return apply(n.op, l, r, msg);
+}
+
+Value Incremental::eval(std::string &msg)
+{
+    recomputed_ = 0;
+    if (dag_.nodes.empty()) {
+        msg = "no expression is given";
+        return Value();
+    }
+    const Value &v = pull(dag_.root());
+    msg = msgs_[dag_.root()];
+    return v;
+}
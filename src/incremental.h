@@ -0,0 +1,52 @@
+#ifndef HEADER_C3B035C276CA4E6FA62CA467F8008930
+#define HEADER_C3B035C276CA4E6FA62CA467F8008930
+
+#include "ast.h"
+#include "dag.h"
+#include "intern.h"
+#include "value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief evaluates a Dag again and again while its symbols change
+/// @note every node keeps its value or error between eval() calls. set()
+/// marks the nodes depending on the symbol by following the edges of the
+/// Dag backwards, eval() recomputes only marked nodes the root needs. In
+/// SHORT_CIRCUIT mode an operand that is skipped stays marked until an
+/// eval() needs it. Values and errors are those of run().
+class Incremental
+{
+public:
+    explicit Incremental(Dag dag, EvalMode mode = EvalMode::STRICT);
+    /// @brief binds symbol to v, an UNKNOWN v leaves it unbound
+    /// @return false if the Dag has no such symbol
+    bool set(Atom symbol, const Value &v);
+    Value eval(std::string &msg);
+    /// @brief the nodes computed by the last eval()
+    std::size_t recomputed() const { return recomputed_; }
+    std::size_t size() const { return dag_.nodes.size(); }
+private:
+    void mark(std::uint32_t node);
+    const Value &pull(std::uint32_t node);
+    Value compute(std::uint32_t node, std::string &msg);
+
+    Dag dag_;
+    EvalMode mode_;
+    // the parents of node i are parents_[first_[i] .. first_[i + 1])
+    std::vector<std::uint32_t> first_;
+    std::vector<std::uint32_t> parents_;
+    std::unordered_map<Atom::Id, std::uint32_t> symbols_;
+    std::vector<Value> bound_;
+    std::vector<Value> values_;
+    std::vector<std::string> msgs_;
+    std::vector<unsigned char> dirty_;
+    std::vector<std::uint32_t> seen_;
+    std::uint32_t epoch_;
+    std::size_t recomputed_;
+};
+
+#endif
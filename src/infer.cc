@@ -0,0 +1,121 @@
+#include "infer.h"
+
+namespace {
+
+const Ast::T any[] = {Ast::T::NUMBER, Ast::T::STRING, Ast::T::BOOLEAN};
+
+const char *name(Ast::T t)
+{
+    switch (t) {
+        case Ast::T::NUMBER:
+            return "number";
+        case Ast::T::STRING:
+            return "string";
+        case Ast::T::BOOLEAN:
+            return "boolean";
+        default:
+            return "unknown";
+    }
+}
+
+const char *describe(Ast::O op, bool unary)
+{
+    switch (op) {
+        case Ast::O::PLUS:
+            return unary ? "apply unary + on" : "add";
+        case Ast::O::MINUS:
+            return unary ? "negate" : "subtract";
+        case Ast::O::MULTIPLY:
+            return "multiply";
+        case Ast::O::DIVISION:
+            return "divide";
+        case Ast::O::MODULO:
+            return "modulo";
+        case Ast::O::POWER:
+            return "apply ^ on";
+        case Ast::O::LOGICAL_AND:
+            return "apply && on";
+        case Ast::O::LOGICAL_OR:
+            return "apply || on";
+        case Ast::O::LOGICAL_NOT:
+            return "apply ! on";
+        case Ast::O::CMP_EQ:
+            return "apply == on";
+        case Ast::O::CMP_NE:
+            return "apply != on";
+        case Ast::O::CMP_GT:
+            return "apply > on";
+        case Ast::O::CMP_GE:
+            return "apply >= on";
+        case Ast::O::CMP_LT:
+            return "apply < on";
+        default:
+            return "apply <= on";
+    }
+}
+
+std::string name(TypeSet m)
+{
+    if (m == ANY_TYPE) {
+        return "any value";
+    }
+    std::string s;
+    for (unsigned i = 0; i < 3; ++i) {
+        if (m & (1u << i)) {
+            s += s.empty() ? "" : " or ";
+            s += name(any[i]);
+        }
+    }
+    return s;
+}
+
+} // namespace
+
+bool infer(
+    const Dag &dag,
+    const Declared &declared,
+    std::vector<Ast::T> &types,
+    std::string &msg
+)
+{
+    std::vector<TypeSet> masks(dag.nodes.size());
+    types.assign(dag.nodes.size(), Ast::T::UNKNOWN);
+    for (std::size_t id = 0; id < dag.nodes.size(); ++id) {
+        const Dag::Node &n = dag.nodes[id];
+        TypeSet &m = masks[id];
+        switch (n.t) {
+            case Ast::T::SYMBOL: {
+                const auto d = declared.find(n.str);
+                m = d == declared.end() ? ANY_TYPE : typeSet(d->second);
+                break;
+            }
+            case Ast::T::OPERATOR: {
+                const bool unary = n.left == Dag::NONE;
+                const TypeSet r = masks[n.right];
+                const TypeSet l = unary ? 0 : masks[n.left];
+                m = resultTypes(n.op, unary, l, r);
+                if (m) {
+                    break;
+                }
+                msg = "cannot ";
+                msg += describe(n.op, unary);
+                msg += ' ';
+                if (!unary) {
+                    msg += name(l);
+                    msg += " and ";
+                }
+                msg += name(r);
+                return false;
+            }
+            default:
+                m = typeSet(n.t);
+                break;
+        }
+        for (unsigned i = 0; i < 3; ++i) {
+            if (m == 1u << i) {
+                types[id] = any[i];
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef HEADER_069F0BD01BD84D2988C1291E5517CA88
+#define HEADER_069F0BD01BD84D2988C1291E5517CA88
+
+#include "ast.h"
+#include "dag.h"
+#include "intern.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief the types symbols are declared to have, NUMBER, STRING or
+/// BOOLEAN, symbols left out may have any of them
+typedef std::unordered_map<Atom, Ast::T, Atom::Hash> Declared;
+
+/// @brief a set of types, one bit for each of NUMBER, STRING and BOOLEAN
+typedef unsigned TypeSet;
+const TypeSet ANY_TYPE = 7;
+
+constexpr TypeSet typeSet(Ast::T t)
+{
+    return t == Ast::T::NUMBER ? 1
+        : t == Ast::T::STRING ? 2
+        : t == Ast::T::BOOLEAN ? 4 : 0;
+}
+
+/// @brief the type apply() gives for operands of types l and r, UNKNOWN
+/// if it fails for them
+constexpr Ast::T resultType(Ast::O op, Ast::T l, Ast::T r)
+{
+    const bool numbers = l == Ast::T::NUMBER && r == Ast::T::NUMBER;
+    const bool text = (l == Ast::T::STRING || l == Ast::T::NUMBER)
+        && (r == Ast::T::STRING || r == Ast::T::NUMBER);
+    switch (op) {
+        case Ast::O::PLUS:
+            return numbers ? Ast::T::NUMBER
+                : text ? Ast::T::STRING : Ast::T::UNKNOWN;
+        case Ast::O::MULTIPLY:
+            return numbers ? Ast::T::NUMBER
+                : text && l != r ? Ast::T::STRING : Ast::T::UNKNOWN;
+        case Ast::O::MINUS:
+        case Ast::O::DIVISION:
+        case Ast::O::MODULO:
+        case Ast::O::POWER:
+            return numbers ? Ast::T::NUMBER : Ast::T::UNKNOWN;
+        case Ast::O::LOGICAL_AND:
+        case Ast::O::LOGICAL_OR:
+            return l == Ast::T::BOOLEAN && r == Ast::T::BOOLEAN
+                ? Ast::T::BOOLEAN : Ast::T::UNKNOWN;
+        case Ast::O::CMP_EQ:
+        case Ast::O::CMP_NE:
+            return l == r ? Ast::T::BOOLEAN : Ast::T::UNKNOWN;
+        default:
+            return l == r && l != Ast::T::BOOLEAN
+                ? Ast::T::BOOLEAN : Ast::T::UNKNOWN;
+    }
+}
+
+constexpr Ast::T resultType(Ast::O op, Ast::T operand)
+{
+    if (op == Ast::O::LOGICAL_NOT) {
+        return operand == Ast::T::BOOLEAN ? Ast::T::BOOLEAN : Ast::T::UNKNOWN;
+    }
+    return operand == Ast::T::NUMBER ? Ast::T::NUMBER : Ast::T::UNKNOWN;
+}
+
+/// @brief the types op gives for operands of the types in l and r, empty
+/// if it fails for all of them, l is ignored for unary operators
+constexpr TypeSet resultTypes(Ast::O op, bool unary, TypeSet l, TypeSet r)
+{
+    const Ast::T all[] = {Ast::T::NUMBER, Ast::T::STRING, Ast::T::BOOLEAN};
+    TypeSet s = 0;
+    for (unsigned i = 0; i < 3; ++i) {
+        for (unsigned j = 0; j < 3; ++j) {
+            if ((unary || (l & (1u << i))) && (r & (1u << j))) {
+                s |= typeSet(unary
+                    ? resultType(op, all[j])
+                    : resultType(op, all[i], all[j]));
+            }
+        }
+    }
+    return s;
+}
+
+/// @brief the static type of every node of dag, UNKNOWN where it depends
+/// on the value of an undeclared symbol
+/// @return false if some operator rejects every value its operands may
+/// have, msg tells which
+bool infer(
+    const Dag &dag,
+    const Declared &declared,
+    std::vector<Ast::T> &types,
+    std::string &msg
+);
+
+#endif
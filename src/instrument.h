@@ -0,0 +1,80 @@
+#ifndef HEADER_D741F92CFFD94B22BF24F16D6924DC03
+#define HEADER_D741F92CFFD94B22BF24F16D6924DC03
+
+/// @brief counters and timers of parsing and evaluation, compiled in with
+/// ARIADNE_INSTRUMENT defined (cmake option INSTRUMENT)
+/// @note without it every INSTRUMENT_* macro expands to nothing, not even
+/// its arguments are evaluated
+
+#ifdef ARIADNE_INSTRUMENT
+
+#include "ast.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace instrument {
+
+enum Counter {
+    TOKENS, NODES, TYPE_ERRORS, PARSE_NS, BUILD_NS, EVAL_NS,
+    OPERATORS, ///< the first of one counter per Ast::O
+    COUNTERS = OPERATORS + static_cast<int>(Ast::O::CMP_LE) + 1,
+};
+
+/// @note relaxed, concurrent eval() calls all get counted but a snapshot
+/// of several counters is not taken at one instant
+inline std::atomic<std::uint64_t> counters[COUNTERS];
+
+inline void count(int c, std::uint64_t n = 1)
+{
+    counters[c].fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void count(Ast::O op, std::uint64_t n = 1)
+{
+    count(OPERATORS + static_cast<int>(op), n);
+}
+
+/// @brief adds the ns of its lifetime to a counter
+class Timer
+{
+public:
+    explicit Timer(Counter c) : c_(c), start_(Clock::now()) {}
+    ~Timer()
+    {
+        count(c_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start_).count());
+    }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+private:
+    typedef std::chrono::steady_clock Clock;
+    const Counter c_;
+    const Clock::time_point start_;
+};
+
+} // namespace instrument
+
+#define INSTRUMENT_COUNT(c) instrument::count(instrument::c)
+#define INSTRUMENT_OPERATOR(op, n) instrument::count(op, n)
+/// counts the operator a Program::Code evaluates, needs vm.h
+#define INSTRUMENT_CODE(code, n) do {\
+        Ast::O instrumentOp;\
+        if (evaluates(code, instrumentOp)) {\
+            instrument::count(instrumentOp, n);\
+        }\
+    } while (false)
+#define INSTRUMENT_TIME(c) const instrument::Timer instrumentTimer(\
+    instrument::c)
+
+#else
+
+#define INSTRUMENT_COUNT(c) ((void)0)
+#define INSTRUMENT_OPERATOR(op, n) ((void)0)
+#define INSTRUMENT_CODE(code, n) ((void)0)
+#define INSTRUMENT_TIME(c) ((void)0)
+
+#endif
+
+#endif
@@ -1,25 +1,111 @@
 #include "interface.h"
+#include "expression.h"
 #include "parser.h"
 #include "ast.h"
+#include "batch.h"
+#include "dag.h"
+#include "filter.h"
+#include "incremental.h"
+#include "instrument.h"
+#include "optimize.h"
+#include "profile.h"
+#include "serial.h"
+#include "value.h"
+#include "vm.h"
 
-#include <sstream>
+#include <algorithm>
 #include <utility>
 #include <string>
 
 #include <parameter.h> // ariadne code
 
-struct ExpressionImpl
+const Ast::Ptr &tree(
+    const ExpressionImpl &impl,
+    Ast::Ptr &copy,
+    std::size_t &removed
+)
 {
-    std::unique_ptr<Ast> ast_;
-    bool hasError_;
-    std::string msg_;
-};
+    if (impl.mode_ == EvalMode::STRICT || !impl.ast_) {
+        return impl.ast_;
+    }
+    copy = impl.ast_->clone();
+    removed += simplify(copy, impl.mode_);
+    return copy;
+}
+
+// rejects a parsed expression the declared types make fail in any case,
+// without declarations type errors are left to eval()
+static bool check(ExpressionImpl &impl)
+{
+    if (!impl.parsed_) {
+        return false;
+    }
+    impl.hasError_ = false;
+    impl.msg_ = "no error";
+    if (impl.declared_.empty()) {
+        return true;
+    }
+    std::vector<Ast::T> types;
+    if (!infer(share(impl.ast_), impl.declared_, types, impl.msg_)) {
+        impl.hasError_ = true;
+    }
+    return !impl.hasError_;
+}
+
+static void build(ExpressionImpl &impl)
+{
+    INSTRUMENT_TIME(BUILD_NS);
+    impl.stats_.removed = impl.folded_;
+    Ast::Ptr copy;
+    const Ast::Ptr &t = tree(impl, copy, impl.stats_.removed);
+    const Dag dag = share(t);
+    impl.filter_ = plan(t, impl.mode_);
+    impl.stats_.shared = dag.nodes.size();
+    std::vector<Ast::T> types;
+    std::string msg;
+    if (!impl.declared_.empty() && infer(dag, impl.declared_, types, msg)) {
+        impl.program_ = compile(dag, types, impl.mode_);
+    } else {
+        impl.program_ = compile(dag, impl.mode_);
+    }
+    bindSlots(impl.program_, impl.slots_);
+    bindSlots(impl.filter_, impl.slots_);
+}
+
+// one column per slot, symbols without one stay unbound
+static std::vector<Column> gather(
+    const ExpressionImpl &impl,
+    const Expression::Columns &columns
+)
+{
+    std::vector<Column> args(impl.slots_.size());
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const auto c = columns.find(impl.slots_[i]);
+        if (c != columns.end()) {
+            args[i] = c->second;
+        }
+    }
+    return args;
+}
+
+bool toValue(const parameter &p, Value &v)
+{
+    switch (p.getType()) {
+        case PT_REAL:
+            v = Value(p.getValueReal());
+            return true;
+        case PT_STRING:
+            v = Value(p.getValueString());
+            return true;
+        // case PT_BOOL:break;
+        default:
+            return false;
+    }
+}
 
 Expression::Expression()
     : impl_(std::make_shared<ExpressionImpl>())
 {
-    impl_->hasError_ = true;
-    impl_->msg_ = "no expression is given";
 }
 
 Expression::Expression(const std::string &expr)
@@ -28,25 +114,51 @@ Expression::Expression(const std::string &expr)
     parse(expr);
 }
 
+Expression::Expression(const char *expr, std::size_t n)
+    : impl_(std::make_shared<ExpressionImpl>())
+{
+    parse(expr, n);
+}
+
 bool Expression::parse(const std::string &expr)
 {
-    std::istringstream s(expr);
-    auto p = Parser(s);
-    impl_->ast_ = p.parseExpr();
+    return parse(expr.data(), expr.size());
+}
+
+bool Expression::parse(const char *expr, std::size_t n)
+{
+    if (impl_->keepSource_) {
+        impl_->source_.assign(expr, n);
+    } else {
+        impl_->source_.clear();
+    }
+    auto p = Parser(expr, n);
+    {
+        INSTRUMENT_TIME(PARSE_NS);
+        impl_->ast_ = p.parseExpr();
+    }
+    {
+        INSTRUMENT_TIME(BUILD_NS);
+        impl_->stats_.nodes = count(impl_->ast_);
+        impl_->folded_ = simplify(impl_->ast_);
+        impl_->slots_ = atoms(impl_->ast_);
+    }
+    build(*impl_);
     if (impl_->ast_) {
         if (!p.eof()) {
+            impl_->parsed_ = false;
             impl_->hasError_ = true;
             impl_->msg_ = "unprocessed components on the end, "
                 "maybe there is more than one expression given";
             return false;
         }
-        impl_->hasError_ = false;
-        impl_->msg_ = "no error";
-    } else {
-        impl_->hasError_ = true;
-        impl_->msg_ = p.msg();
+        impl_->parsed_ = true;
+        return check(*impl_);
     }
-    return !impl_->hasError_;
+    impl_->parsed_ = false;
+    impl_->hasError_ = true;
+    impl_->msg_ = p.msg();
+    return false;
 }
 
 Expression::operator bool() const
@@ -56,8 +168,7 @@ Expression::operator bool() const
 
 std::set<std::string> Expression::symbols() const
 {
-    impl_->hasError_ = false;
-    return ::symbols(impl_->ast_);
+    return std::set<std::string>(impl_->slots_.begin(), impl_->slots_.end());
 }
 
 const std::string Expression::msg() const
@@ -65,54 +176,386 @@ const std::string Expression::msg() const
     return impl_->msg_;
 }
 
-std::pair<std::shared_ptr<parameter>, std::string>
-Expression::eval(const Expression::Dict &dict)
+void Expression::setMode(Expression::Mode mode)
 {
-    std::shared_ptr<parameter> rp;
-    impl_->hasError_ = false;
-    if (!impl_->ast_) {
-        impl_->hasError_ = true;
-        impl_->msg_ ="parse failed or no given expression";
-        return std::make_pair(rp, impl_->msg_);
+    impl_->mode_ = mode == Mode::STRICT
+        ? EvalMode::STRICT : EvalMode::SHORT_CIRCUIT;
+    build(*impl_);
+}
+
+void Expression::keepSource(bool keep)
+{
+    impl_->keepSource_ = keep;
+}
+
+Expression::Stats Expression::stats() const
+{
+    return impl_->stats_;
+}
+
+Expression::Counters Expression::counters()
+{
+    Counters c = Counters();
+#ifdef ARIADNE_INSTRUMENT
+    const auto &n = instrument::counters;
+    c.tokens = n[instrument::TOKENS];
+    c.nodes = n[instrument::NODES];
+    c.typeErrors = n[instrument::TYPE_ERRORS];
+    c.parseNs = n[instrument::PARSE_NS];
+    c.buildNs = n[instrument::BUILD_NS];
+    c.evalNs = n[instrument::EVAL_NS];
+    static const char *const names[] = {
+        "+", "-", "*", "/", "%", "^", "&&", "||", "!",
+        "==", "!=", ">", ">=", "<", "<=",
+    };
+    for (int i = instrument::OPERATORS; i < instrument::COUNTERS; ++i) {
+        c.operators[names[i - instrument::OPERATORS]] = n[i];
     }
-    Ast::Dict d;
-    for (const auto &i : dict) {
-        switch (i.second->getType()) {
-            case PT_REAL:
-                d[i.first] = Ast::make(i.second->getValueReal());
-                break;
-            case PT_STRING:
-                d[i.first] = Ast::makeString(i.second->getValueString());
-                break;
-            // case PT_BOOL:break;
-            default:
-                impl_->hasError_ = true;
-                impl_->msg_ = "unrecognizable parameter type";
-                return std::make_pair(rp, impl_->msg_);
+#endif
+    return c;
+}
+
+void Expression::resetCounters()
+{
+#ifdef ARIADNE_INSTRUMENT
+    for (auto &c : instrument::counters) {
+        c = 0;
+    }
+#endif
+}
+
+// a record per expression: mode, flags, msg_, source_, the node counts,
+// the declared types and the folded tree
+enum : unsigned char { PARSED = 1, HAS_ERROR = 2 };
+
+std::string Expression::save(
+    const std::vector<Expression> &expressions,
+    bool source
+)
+{
+    serial::Writer w;
+    w.varint(expressions.size());
+    for (const auto &e : expressions) {
+        const ExpressionImpl &impl = *e.impl_;
+        w.byte(impl.mode_ == EvalMode::STRICT ? 0 : 1);
+        w.byte((impl.parsed_ ? PARSED : 0)
+            | (impl.hasError_ ? HAS_ERROR : 0));
+        w.string(impl.msg_);
+        w.string(source ? impl.source_ : std::string());
+        w.varint(impl.stats_.nodes);
+        w.varint(impl.folded_);
+        // in the order of their strings, so that equal input gives equal
+        // bytes
+        std::vector<std::pair<Atom, Ast::T> > declared(
+            impl.declared_.begin(), impl.declared_.end()
+        );
+        std::sort(declared.begin(), declared.end(),
+            [](const std::pair<Atom, Ast::T> &a,
+                const std::pair<Atom, Ast::T> &b) {
+                return before(a.first, b.first);
+            });
+        w.varint(declared.size());
+        for (const auto &d : declared) {
+            w.atom(d.first);
+            w.byte(static_cast<unsigned char>(d.second));
+        }
+        if (!w.tree(impl.ast_)) {
+            return std::string();
         }
     }
-    auto r = ::eval(impl_->ast_, d, impl_->msg_ );
-    if (!r) {
-        if (impl_->ast_) {
-            impl_->hasError_ = true;
-            return std::make_pair(rp, impl_->msg_);
+    return w.finish();
+}
+
+static bool restore(serial::Reader &r, ExpressionImpl &impl)
+{
+    unsigned char mode, flags;
+    std::uint64_t nodes, folded, declared;
+    if (!r.byte(mode) || mode > 1 || !r.byte(flags)
+        || !r.string(impl.msg_) || !r.string(impl.source_)
+        || !r.varint(nodes) || !r.varint(folded) || !r.varint(declared)) {
+        return false;
+    }
+    impl.mode_ = mode ? EvalMode::SHORT_CIRCUIT : EvalMode::STRICT;
+    impl.keepSource_ = !impl.source_.empty();
+    impl.parsed_ = flags & PARSED;
+    impl.hasError_ = flags & HAS_ERROR;
+    impl.stats_.nodes = nodes;
+    impl.folded_ = folded;
+    for (std::uint64_t i = 0; i < declared; ++i) {
+        Atom a;
+        unsigned char t;
+        if (!r.atom(a) || !r.byte(t)) {
+            return false;
         }
+        const Ast::T type = static_cast<Ast::T>(t);
+        if (type != Ast::T::NUMBER && type != Ast::T::STRING
+            && type != Ast::T::BOOLEAN) {
+            return false;
+        }
+        impl.declared_[a] = type;
+    }
+    if (!r.tree(impl.ast_)) {
+        return false;
+    }
+    impl.slots_ = atoms(impl.ast_);
+    build(impl);
+    return true;
+}
+
+bool Expression::load(
+    const char *data,
+    std::size_t n,
+    std::vector<Expression> &out
+)
+{
+    serial::Reader r(data, n);
+    std::uint64_t count;
+    if (!r.header() || !r.varint(count) || count > n) {
+        return false;
+    }
+    std::vector<Expression> expressions(count);
+    for (auto &e : expressions) {
+        if (!restore(r, *e.impl_)) {
+            return false;
+        }
+    }
+    if (!r.eof()) {
+        return false;
+    }
+    out.swap(expressions);
+    return true;
+}
+
+bool Expression::declare(const std::map<std::string, Type> &types)
+{
+    impl_->declared_.clear();
+    for (const auto &t : types) {
+        impl_->declared_[Atom(t.first)] = t.second == Type::REAL
+            ? Ast::T::NUMBER
+            : t.second == Type::STRING ? Ast::T::STRING : Ast::T::BOOLEAN;
+    }
+    build(*impl_);
+    return check(*impl_);
+}
+
+Expression::Mode Expression::mode() const
+{
+    return impl_->mode_ == EvalMode::STRICT
+        ? Mode::STRICT : Mode::SHORT_CIRCUIT;
+}
+
+std::vector<std::string> Expression::slots() const
+{
+    return std::vector<std::string>(
+        impl_->slots_.begin(), impl_->slots_.end()
+    );
+}
+
+typedef std::pair<std::shared_ptr<parameter>, std::string> Result;
+
+// the values bound for one call, every thread reuses its own buffer so
+// that eval() neither allocates nor touches the shared ExpressionImpl
+static std::vector<Value> &context()
+{
+    static thread_local std::vector<Value> args;
+    return args;
+}
+
+static Result failure(const std::string &msg)
+{
+    return std::make_pair(std::shared_ptr<parameter>(), msg);
+}
+
+static Result result(const Value &r, const std::string &msg)
+{
+    std::shared_ptr<parameter> rp;
+    if (!r) {
+        return std::make_pair(rp, msg);
     }
-    switch (r->t) {
+    switch (r.t()) {
         case Ast::T::NUMBER:
             rp = std::make_shared<parameter>(PT_REAL);
-            rp->setValueReal(r->num);
+            rp->setValueReal(r.num());
             break;
         case Ast::T::STRING:
             rp = std::make_shared<parameter>(PT_STRING);
-            rp->setValueString(r->str);
+            rp->setValueString(r.str());
             break;
         case Ast::T::BOOLEAN:
             rp = std::make_shared<parameter>(PT_REAL);
-            rp->setValueReal(r->b);
+            rp->setValueReal(r.b());
             break;
         default:
             break;
     }
-    return std::make_pair(rp, impl_->msg_);
+    return std::make_pair(rp, std::string("no error"));
+}
+
+static Result result(const ExpressionImpl &impl, const Value *args)
+{
+    std::string msg;
+    const auto r = run(impl.program_, args, msg);
+    return result(r, msg);
+}
+
+Result Expression::eval(const Expression::Dict &dict) const
+{
+    INSTRUMENT_TIME(EVAL_NS);
+    if (!impl_->ast_) {
+        return failure("parse failed or no given expression");
+    }
+    // dict and slots_ are both sorted, so one merge pass binds the values
+    const auto &slots = impl_->slots_;
+    auto &args = context();
+    args.assign(slots.size(), Value());
+    std::size_t slot = 0;
+    for (const auto &i : dict) {
+        while (slot < slots.size() && slots[slot].str() < i.first) {
+            ++slot;
+        }
+        Value v;
+        if (!toValue(*i.second, v)) {
+            return failure("unrecognizable parameter type");
+        }
+        if (slot < slots.size() && slots[slot].str() == i.first) {
+            args[slot] = std::move(v);
+        }
+    }
+    return result(*impl_, args.data());
+}
+
+Result Expression::eval(
+    const std::shared_ptr<parameter> *args, std::size_t n
+) const
+{
+    INSTRUMENT_TIME(EVAL_NS);
+    if (!impl_->ast_) {
+        return failure("parse failed or no given expression");
+    }
+    if (n != impl_->slots_.size()) {
+        return failure("expected " + std::to_string(impl_->slots_.size())
+            + " values, got " + std::to_string(n));
+    }
+    auto &values = context();
+    values.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!args[i]) {
+            values[i] = Value();
+        } else if (!toValue(*args[i], values[i])) {
+            return failure("unrecognizable parameter type");
+        }
+    }
+    return result(*impl_, values.data());
+}
+
+Result Expression::eval(const Expression::Args &args) const
+{
+    return eval(args.data(), args.size());
+}
+
+void Expression::eval(
+    const Expression::Columns &columns,
+    std::size_t rows,
+    ResultColumn &out
+) const
+{
+    INSTRUMENT_TIME(EVAL_NS);
+    if (!impl_->ast_) {
+        out.type.assign(rows, ResultColumn::Type::ERROR);
+        out.real.assign(rows, 0);
+        out.str.assign(rows, "parse failed or no given expression");
+        return;
+    }
+    const auto args = gather(*impl_, columns);
+    run(impl_->program_, args.data(), rows, out);
+}
+
+void Expression::filter(
+    const Expression::Columns &columns,
+    std::size_t rows,
+    std::vector<std::uint32_t> &selection
+) const
+{
+    INSTRUMENT_TIME(EVAL_NS);
+    const auto args = gather(*impl_, columns);
+    run(impl_->filter_, args.data(), rows, selection);
+}
+
+Expression::Session::Session(const Expression &e)
+{
+    Ast::Ptr copy;
+    std::size_t removed = 0;
+    const Ast::Ptr &t = tree(*e.impl_, copy, removed);
+    impl_.reset(new Incremental(share(t), e.impl_->mode_));
+}
+
+Expression::Session::~Session()
+{
+}
+
+bool Expression::Session::set(
+    const std::string &symbol,
+    const std::shared_ptr<parameter> &v
+)
+{
+    Atom a;
+    if (!Atom::find(Span(symbol), a)) {
+        return false;
+    }
+    Value value;
+    if (v && !toValue(*v, value)) {
+        return false;
+    }
+    return impl_->set(a, value);
+}
+
+Result Expression::Session::eval()
+{
+    INSTRUMENT_TIME(EVAL_NS);
+    if (!impl_->size()) {
+        return failure("parse failed or no given expression");
+    }
+    std::string msg;
+    const auto r = impl_->eval(msg);
+    return result(r, msg);
+}
+
+std::size_t Expression::Session::recomputed() const
+{
+    return impl_->recomputed();
+}
+
+Expression::Profiler::Profiler(const Expression &e)
+    : impl_(new Profile(e.impl_->source_, e.impl_->mode_))
+{
+}
+
+Expression::Profiler::~Profiler()
+{
+}
+
+Result Expression::Profiler::eval(const Expression::Dict &dict)
+{
+    if (!*impl_) {
+        return failure("parse failed or no given expression");
+    }
+    Value::Dict values;
+    for (const auto &i : dict) {
+        if (!toValue(*i.second, values[i.first])) {
+            return failure("unrecognizable parameter type");
+        }
+    }
+    std::string msg;
+    const auto r = impl_->eval(values, msg);
+    return result(r, msg);
+}
+
+std::string Expression::Profiler::text() const
+{
+    return impl_->text();
+}
+
+std::string Expression::Profiler::json() const
+{
+    return impl_->json();
 }
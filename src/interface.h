@@ -1,14 +1,19 @@
 #ifndef ARIADNE_PARSER_INTERFACE_H
 #define ARIADNE_PARSER_INTERFACE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <string>
 #include <set>
 #include <map>
+#include <vector>
 
 #include <parameter.h> // ariadne code
 
+#include "column.h"
+
 #if defined _WIN32 || defined __CYGWIN__
 #ifdef BUILDING_DLL
 #ifdef __GNUC__
@@ -35,17 +40,160 @@
 #endif
 
 struct ExpressionImpl;
+class Incremental;
+class Profile;
+class RuleSet;
+/// @note eval(), symbols() and slots() are const and may run concurrently
+/// on one Expression and its copies, parse(), setMode() and keepSource()
+/// may not. The error of an eval() is only reported in its result,
+/// operator bool() and msg() refer to the last parse().
 class DLL_EXPORT Expression {
 public:
+    /// @brief STRICT evaluates both operands of && and ||, SHORT_CIRCUIT
+    /// skips the right one when the left operand decides the result
+    enum class Mode { STRICT, SHORT_CIRCUIT };
     Expression();
     Expression(const std::string &expr);
+    Expression(const char *expr, std::size_t n);
     std::set<std::string> symbols() const;
     typedef std::map<std::string, std::shared_ptr<parameter> > Dict;
-    std::pair<std::shared_ptr<parameter>, std::string> eval(const Dict &);
+    typedef std::vector<std::shared_ptr<parameter> > Args;
+    std::pair<std::shared_ptr<parameter>, std::string> eval(
+        const Dict &
+    ) const;
+    /// @brief the symbols() in the order eval(args, n) expects their values
+    std::vector<std::string> slots() const;
+    /// @param args one value per slot, a null pointer leaves it unbound
+    std::pair<std::shared_ptr<parameter>, std::string> eval(
+        const std::shared_ptr<parameter> *args, std::size_t n
+    ) const;
+    std::pair<std::shared_ptr<parameter>, std::string> eval(
+        const Args &
+    ) const;
+    typedef std::map<std::string, Column> Columns;
+    /// @brief evaluates the rows [0, rows) of the columns at once
+    /// @note a symbol without column is unbound in every row, out gets one
+    /// entry per row with the result or the error eval() gives for it
+    void eval(const Columns &columns, std::size_t rows, ResultColumn &out)
+        const;
+    /// @brief the rows of [0, rows) for which the expression gives true
+    /// @note the operands of && only run on the rows the ones before let
+    /// through, in SHORT_CIRCUIT mode the right operand of || only on the
+    /// rows the left one rejects. Rows giving false, an error or no
+    /// boolean are left out, selection is ascending.
+    void filter(
+        const Columns &columns,
+        std::size_t rows,
+        std::vector<std::uint32_t> &selection
+    ) const;
     operator bool() const;
     bool parse(const std::string &expr);
+    bool parse(const char *expr, std::size_t n);
     const std::string msg() const;
+    void setMode(Mode mode);
+    Mode mode() const;
+    /// @brief whether the next parse() keeps a copy of the text for the
+    /// Profiler and save(), off by default so that parsing copies nothing
+    void keepSource(bool keep);
+    struct Stats
+    {
+        std::size_t nodes;   ///< nodes of the parsed tree
+        std::size_t removed; ///< nodes removed by constant folding
+        std::size_t shared;  ///< nodes left after merging equal subtrees
+    };
+    Stats stats() const;
+    /// @brief what all Expressions did since the last resetCounters()
+    /// @note only counted when built with option INSTRUMENT, else all 0
+    struct Counters
+    {
+        std::uint64_t tokens;     ///< tokens lexed
+        std::uint64_t nodes;      ///< tree nodes allocated
+        std::uint64_t typeErrors; ///< operations failing on operand types
+        std::uint64_t parseNs;    ///< time spent parsing
+        std::uint64_t buildNs;    ///< folding, sharing and compiling
+        std::uint64_t evalNs;     ///< in eval() and filter()
+        /// evaluations per operator, a row of a batch counts as one
+        std::map<std::string, std::uint64_t> operators;
+    };
+    static Counters counters();
+    static void resetCounters();
+    /// @brief the expressions in a compact binary form for load()
+    /// @param source keep the texts too, the ones of keepSource() and of
+    /// load(), a loaded Expression without its text gets a Profiler
+    /// recording nothing
+    /// @return an empty string if a tree is deeper than load() takes,
+    /// 4096 levels
+    /// @note the trees are stored as parse() folded them, the rewrites
+    /// depending on the mode and the compiled programs are made on load
+    static std::string save(
+        const std::vector<Expression> &expressions,
+        bool source = true
+    );
+    /// @brief makes the expressions save() stored in data again, with
+    /// their mode, declared types and errors, without parsing them
+    /// @return false if data is not of save() or of another version of
+    /// the format, out is left unchanged then
+    static bool load(
+        const char *data,
+        std::size_t n,
+        std::vector<Expression> &out
+    );
+    enum class Type { REAL, STRING, BOOL };
+    /// @brief declares the types of symbols, the others may take any
+    /// @return false if the expression fails for every value of them,
+    /// msg() tells why
+    /// @note the types are kept by parse(). Operators whose operands have
+    /// declared or constant types skip checking them, instead eval()
+    /// fails with a value of another type for a declared symbol.
+    bool declare(const std::map<std::string, Type> &types);
+    /// @brief evaluates an Expression again and again while its symbols
+    /// change, recomputing only the nodes depending on changed ones
+    /// @note the Session works on the expression and mode at the time it
+    /// is made, a later parse() or setMode() does not affect it.
+    class DLL_EXPORT Session {
+    public:
+        explicit Session(const Expression &e);
+        ~Session();
+        Session(const Session &) = delete;
+        Session &operator=(const Session &) = delete;
+        /// @param v the new value, a null pointer leaves symbol unbound
+        /// @return false if the expression has no such symbol or the type
+        /// of v is not supported
+        bool set(
+            const std::string &symbol,
+            const std::shared_ptr<parameter> &v
+        );
+        std::pair<std::shared_ptr<parameter>, std::string> eval();
+        /// @brief the nodes computed by the last eval()
+        std::size_t recomputed() const;
+    private:
+        std::unique_ptr<Incremental> impl_;
+    };
+    /// @brief evaluates the expression as written, without folding, and
+    /// records for every node its hits, time, result types and errors
+    /// @note the Profiler works on the text and mode at the time it is
+    /// made, the text is the one of keepSource() or of load(), without
+    /// one it records nothing. Times include the ones of the operands and
+    /// of timing them.
+    class DLL_EXPORT Profiler {
+    public:
+        explicit Profiler(const Expression &e);
+        ~Profiler();
+        Profiler(const Profiler &) = delete;
+        Profiler &operator=(const Profiler &) = delete;
+        std::pair<std::shared_ptr<parameter>, std::string> eval(
+            const Dict &dict
+        );
+        /// @brief the tree annotated with the records, a node per line
+        std::string text() const;
+        /// @brief the tree as nested objects with "text", "hits",
+        /// "errors", "ns", "types" and "operands"
+        std::string json() const;
+    private:
+        std::unique_ptr<Profile> impl_;
+    };
 private:
+    friend class RuleSet;
     std::shared_ptr<ExpressionImpl> impl_;
 };
 
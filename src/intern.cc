@@ -0,0 +1,116 @@
+#include "intern.h"
+
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// the strings are kept in blocks of 1024, 2048, 4096 ... entries which
+// never move, so str() needs no lock and a Span into a stored string can
+// serve as key of the index
+const unsigned FIRST = 10;
+const unsigned BLOCKS = 32 - FIRST + 1;
+
+struct SpanHash
+{
+    std::size_t operator()(const Span &s) const
+    {
+        // FNV-1a
+        std::uint64_t h = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < s.n; ++i) {
+            h = (h ^ static_cast<unsigned char>(s.p[i])) * 1099511628211ULL;
+        }
+        return static_cast<std::size_t>(h);
+    }
+};
+
+struct Table
+{
+    std::mutex lock;
+    std::unique_ptr<std::string[]> blocks[BLOCKS];
+    std::unordered_map<Span, Atom::Id, SpanHash> index;
+    std::size_t size;
+
+    Table() : size(0)
+    {
+        insert(Span());
+    }
+
+    // block and offset of id, block k holds the ids
+    // [2^FIRST * (2^k - 1), 2^FIRST * (2^(k+1) - 1))
+    static unsigned block(std::uint64_t id, std::uint64_t &offset)
+    {
+        const std::uint64_t v = (id >> FIRST) + 1;
+        unsigned k = 0;
+        while (v >> (k + 1)) {
+            ++k;
+        }
+        offset = id - ((std::uint64_t(1) << (k + FIRST)) - (1u << FIRST));
+        return k;
+    }
+
+    const std::string &at(std::uint64_t id) const
+    {
+        std::uint64_t offset;
+        const unsigned k = block(id, offset);
+        return blocks[k][offset];
+    }
+
+    Atom::Id insert(Span s)
+    {
+        assert(size <= 0xFFFFFFFFu);
+        const Atom::Id id = static_cast<Atom::Id>(size++);
+        std::uint64_t offset;
+        const unsigned k = block(id, offset);
+        if (!blocks[k]) {
+            blocks[k].reset(new std::string[std::size_t(1) << (k + FIRST)]);
+        }
+        std::string &str = blocks[k][offset];
+        str.assign(s.p, s.n);
+        index.insert(std::make_pair(Span(str), id));
+        return id;
+    }
+};
+
+Table &table()
+{
+    static Table t;
+    return t;
+}
+
+} // namespace
+
+Atom::Atom(Span s)
+{
+    Table &t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    const auto i = t.index.find(s);
+    id_ = i != t.index.end() ? i->second : t.insert(s);
+}
+
+bool Atom::find(Span s, Atom &a)
+{
+    Table &t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    const auto i = t.index.find(s);
+    if (i == t.index.end()) {
+        return false;
+    }
+    a.id_ = i->second;
+    return true;
+}
+
+std::size_t Atom::count()
+{
+    Table &t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    return t.size;
+}
+
+const std::string &Atom::str() const
+{
+    return table().at(id_);
+}
@@ -0,0 +1,50 @@
+#ifndef HEADER_3B3745423A5A4B34AD87490A90DC0F69
+#define HEADER_3B3745423A5A4B34AD87490A90DC0F69
+
+#include "span.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/// @brief a string stored once in a table shared by the whole process
+/// @note equal strings get the same id, so comparing two Atoms compares
+/// two integers. Interning and str() may run concurrently, the strings
+/// live until the process ends. Atom() is the empty string with id 0.
+class Atom
+{
+public:
+    typedef std::uint32_t Id;
+    Atom() : id_(0) {}
+    explicit Atom(Span s);
+    explicit Atom(const std::string &s) : Atom(Span(s)) {}
+    /// @brief the Atom of s if s has been interned, without interning it
+    static bool find(Span s, Atom &a);
+    /// @brief the number of strings interned so far, the empty one too
+    static std::size_t count();
+    Id id() const { return id_; }
+    const std::string &str() const;
+    operator const std::string &() const { return str(); }
+    bool operator==(Atom o) const { return id_ == o.id_; }
+    bool operator!=(Atom o) const { return id_ != o.id_; }
+    struct Hash
+    {
+        std::size_t operator()(Atom a) const { return a.id_; }
+    };
+private:
+    Id id_;
+};
+
+/// @brief orders Atoms by their strings, not by their ids
+inline bool before(Atom a, Atom b)
+{
+    return a != b && a.str() < b.str();
+}
+
+inline std::ostream &operator<<(std::ostream &os, Atom a)
+{
+    return os << a.str();
+}
+
+#endif
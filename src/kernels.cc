@@ -0,0 +1,249 @@
+#include "kernels.h"
+#include "kernels_isa.h"
+#include "arith.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace kernels {
+
+namespace {
+
+// the names clash with the forwarding functions below
+namespace loop {
+
+#define ARITHMETIC(NAME, EXPR) \
+    void NAME(const double *l, const double *r, double *out, std::size_t n)\
+    {\
+        for (std::size_t i = 0; i < n; ++i) {\
+            out[i] = EXPR;\
+        }\
+    }
+#define COMPARE(NAME, T, X) \
+    void NAME(const T *l, const T *r, unsigned char *out, std::size_t n)\
+    {\
+        for (std::size_t i = 0; i < n; ++i) {\
+            out[i] = l[i] X r[i];\
+        }\
+    }
+
+ARITHMETIC(add, l[i] + r[i])
+ARITHMETIC(sub, l[i] - r[i])
+ARITHMETIC(mul, l[i] * r[i])
+ARITHMETIC(pow, std::pow(l[i], r[i]))
+
+COMPARE(eq, double, ==)
+COMPARE(ne, double, !=)
+COMPARE(gt, double, >)
+COMPARE(ge, double, >=)
+COMPARE(lt, double, <)
+COMPARE(le, double, <=)
+COMPARE(land, unsigned char, &)
+COMPARE(lor, unsigned char, |)
+COMPARE(beq, unsigned char, ==)
+COMPARE(bne, unsigned char, !=)
+
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        zero[i] = r[i] == 0;
+        out[i] = l[i] / r[i];
+    }
+}
+
+// rows the scalar operator rejects are set to 0
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const int d = truncate(r[i]);
+        zero[i] = d == 0;
+        out[i] = d ? modulo(truncate(l[i]), d) : 0;
+    }
+}
+
+void neg(const double *v, double *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = -v[i];
+    }
+}
+
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = !v[i];
+    }
+}
+
+} // namespace loop
+
+const Table *select()
+{
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return &avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &sse2;
+    }
+#endif
+    return &scalar;
+}
+
+} // namespace
+
+const Table scalar = {
+    "scalar",
+    loop::add, loop::sub, loop::mul, loop::pow,
+    loop::div, loop::mod,
+    loop::neg,
+    loop::eq, loop::ne, loop::gt, loop::ge, loop::lt, loop::le,
+    loop::land, loop::lor, loop::beq, loop::bne,
+    loop::lnot,
+};
+
+const Table *find(const char *name)
+{
+    if (!std::strcmp(name, "scalar")) {
+        return &scalar;
+    }
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (!std::strcmp(name, "sse2") && __builtin_cpu_supports("sse2")) {
+        return &sse2;
+    }
+    if (!std::strcmp(name, "avx2") && __builtin_cpu_supports("avx2")) {
+        return &avx2;
+    }
+    if (!std::strcmp(name, "avx512") && __builtin_cpu_supports("avx512f")) {
+        return &avx512;
+    }
+#endif
+    return nullptr;
+}
+
+const Table &active()
+{
+    static const Table *const t = select();
+    return *t;
+}
+
+void add(const double *l, const double *r, double *out, std::size_t n)
+{
+    active().add(l, r, out, n);
+}
+
+void sub(const double *l, const double *r, double *out, std::size_t n)
+{
+    active().sub(l, r, out, n);
+}
+
+void mul(const double *l, const double *r, double *out, std::size_t n)
+{
+    active().mul(l, r, out, n);
+}
+
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    active().div(l, r, out, zero, n);
+}
+
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    active().mod(l, r, out, zero, n);
+}
+
+void pow(const double *l, const double *r, double *out, std::size_t n)
+{
+    active().pow(l, r, out, n);
+}
+
+void neg(const double *v, double *out, std::size_t n)
+{
+    active().neg(v, out, n);
+}
+
+void eq(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().eq(l, r, out, n);
+}
+
+void ne(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().ne(l, r, out, n);
+}
+
+void gt(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().gt(l, r, out, n);
+}
+
+void ge(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().ge(l, r, out, n);
+}
+
+void lt(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().lt(l, r, out, n);
+}
+
+void le(const double *l, const double *r, unsigned char *out, std::size_t n)
+{
+    active().le(l, r, out, n);
+}
+
+void land(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+)
+{
+    active().land(l, r, out, n);
+}
+
+void lor(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+)
+{
+    active().lor(l, r, out, n);
+}
+
+void beq(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+)
+{
+    active().beq(l, r, out, n);
+}
+
+void bne(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+)
+{
+    active().bne(l, r, out, n);
+}
+
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n)
+{
+    active().lnot(v, out, n);
+}
+
+} // namespace kernels
@@ -0,0 +1,86 @@
+#ifndef HEADER_161007413D344033A512BFD88206F79A
+#define HEADER_161007413D344033A512BFD88206F79A
+
+#include <cstddef>
+
+/// @brief element wise loops behind the batch evaluation
+/// @note out may be the same array as an operand. Booleans are bytes of
+/// 0 or 1. Division and modulo set zero[i] where the scalar operator
+/// would fail and leave out[i] unspecified there. The functions forward
+/// to the fastest Table the cpu supports, every Table gives bit for bit
+/// the results of the scalar one.
+namespace kernels {
+
+struct Table
+{
+    typedef void (*Arithmetic)(
+        const double *l, const double *r, double *out, std::size_t n
+    );
+    typedef void (*Checked)(
+        const double *l, const double *r, double *out, unsigned char *zero,
+        std::size_t n
+    );
+    typedef void (*Compare)(
+        const double *l, const double *r, unsigned char *out, std::size_t n
+    );
+    typedef void (*Logic)(
+        const unsigned char *l, const unsigned char *r, unsigned char *out,
+        std::size_t n
+    );
+    const char *name;
+    Arithmetic add, sub, mul, pow;
+    Checked div, mod;
+    void (*neg)(const double *v, double *out, std::size_t n);
+    Compare eq, ne, gt, ge, lt, le;
+    Logic land, lor, beq, bne;
+    void (*lnot)(const unsigned char *v, unsigned char *out, std::size_t n);
+};
+
+/// @brief the Table called name ("scalar", "sse2", "avx2" or "avx512")
+/// @return nullptr if it is not built in or not supported by the cpu
+const Table *find(const char *name);
+/// @brief the Table the functions below forward to
+const Table &active();
+
+void add(const double *l, const double *r, double *out, std::size_t n);
+void sub(const double *l, const double *r, double *out, std::size_t n);
+void mul(const double *l, const double *r, double *out, std::size_t n);
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+);
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+);
+void pow(const double *l, const double *r, double *out, std::size_t n);
+void neg(const double *v, double *out, std::size_t n);
+
+void eq(const double *l, const double *r, unsigned char *out, std::size_t n);
+void ne(const double *l, const double *r, unsigned char *out, std::size_t n);
+void gt(const double *l, const double *r, unsigned char *out, std::size_t n);
+void ge(const double *l, const double *r, unsigned char *out, std::size_t n);
+void lt(const double *l, const double *r, unsigned char *out, std::size_t n);
+void le(const double *l, const double *r, unsigned char *out, std::size_t n);
+
+void land(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+);
+void lor(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+);
+void beq(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+);
+void bne(
+    const unsigned char *l, const unsigned char *r, unsigned char *out,
+    std::size_t n
+);
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n);
+
+} // namespace kernels
+
+#endif
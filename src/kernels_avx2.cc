@@ -0,0 +1,174 @@
+#include "kernels_isa.h"
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+namespace kernels {
+
+namespace {
+
+// the names clash with the functions of kernels.h
+namespace loop {
+
+const std::size_t W = 4;
+
+// the low W bits of m as bytes of 0 or 1, the shifts of the product do
+// not overlap so every bit lands in the low bit of its own byte
+inline void bytes(int m, unsigned char *out)
+{
+    const std::uint32_t v =
+        (static_cast<std::uint32_t>(m) * 0x00204081u) & 0x01010101u;
+    std::memcpy(out, &v, W);
+}
+
+inline __m256d integer(__m256d v)
+{
+    return _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(v));
+}
+
+#define ARITHMETIC(NAME, OP) \
+    void NAME(const double *l, const double *r, double *out, std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            _mm256_storeu_pd(\
+                out + i, OP(_mm256_loadu_pd(l + i), _mm256_loadu_pd(r + i))\
+            );\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define COMPARE(NAME, PREDICATE) \
+    void NAME(const double *l, const double *r, unsigned char *out, \
+        std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            const __m256d c = _mm256_cmp_pd(\
+                _mm256_loadu_pd(l + i), _mm256_loadu_pd(r + i), PREDICATE\
+            );\
+            bytes(_mm256_movemask_pd(c), out + i);\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define LOGIC(NAME, EXPR) \
+    void NAME(const unsigned char *l, const unsigned char *r, \
+        unsigned char *out, std::size_t n)\
+    {\
+        const __m256i one = _mm256_set1_epi8(1);\
+        (void)one;\
+        std::size_t i = 0;\
+        for (; i + 32 <= n; i += 32) {\
+            const __m256i a = _mm256_loadu_si256(\
+                reinterpret_cast<const __m256i *>(l + i)\
+            );\
+            const __m256i b = _mm256_loadu_si256(\
+                reinterpret_cast<const __m256i *>(r + i)\
+            );\
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), EXPR);\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+
+ARITHMETIC(add, _mm256_add_pd)
+ARITHMETIC(sub, _mm256_sub_pd)
+ARITHMETIC(mul, _mm256_mul_pd)
+
+// ordered predicates except for !=, which is true for NaN like in C++
+COMPARE(eq, _CMP_EQ_OQ)
+COMPARE(ne, _CMP_NEQ_UQ)
+COMPARE(gt, _CMP_GT_OQ)
+COMPARE(ge, _CMP_GE_OQ)
+COMPARE(lt, _CMP_LT_OQ)
+COMPARE(le, _CMP_LE_OQ)
+
+LOGIC(land, _mm256_and_si256(a, b))
+LOGIC(lor, _mm256_or_si256(a, b))
+LOGIC(beq, _mm256_xor_si256(_mm256_xor_si256(a, b), one))
+LOGIC(bne, _mm256_xor_si256(a, b))
+
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m256d d = _mm256_loadu_pd(r + i);
+        const __m256d z = _mm256_cmp_pd(d, _mm256_setzero_pd(), _CMP_EQ_OQ);
+        bytes(_mm256_movemask_pd(z), zero + i);
+        _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(l + i), d));
+    }
+    scalar.div(l + i, r + i, out + i, zero + i, n - i);
+}
+
+// same as the sse2 one, see there
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    const __m256d none = _mm256_set1_pd(-1);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m256d a = integer(_mm256_loadu_pd(l + i));
+        const __m256d d = integer(_mm256_loadu_pd(r + i));
+        const __m256d z = _mm256_cmp_pd(d, _mm256_setzero_pd(), _CMP_EQ_OQ);
+        const __m256d bad = _mm256_or_pd(
+            z, _mm256_cmp_pd(d, none, _CMP_EQ_OQ)
+        );
+        const __m256d q = integer(_mm256_div_pd(a, d));
+        bytes(_mm256_movemask_pd(z), zero + i);
+        _mm256_storeu_pd(
+            out + i,
+            _mm256_andnot_pd(bad, _mm256_sub_pd(a, _mm256_mul_pd(q, d)))
+        );
+    }
+    scalar.mod(l + i, r + i, out + i, zero + i, n - i);
+}
+
+void pow(const double *l, const double *r, double *out, std::size_t n)
+{
+    scalar.pow(l, r, out, n);
+}
+
+void neg(const double *v, double *out, std::size_t n)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        _mm256_storeu_pd(out + i, _mm256_xor_pd(_mm256_loadu_pd(v + i), sign));
+    }
+    scalar.neg(v + i, out + i, n - i);
+}
+
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i a = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(v + i)
+        );
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(out + i), _mm256_xor_si256(a, one)
+        );
+    }
+    scalar.lnot(v + i, out + i, n - i);
+}
+
+} // namespace loop
+
+} // namespace
+
+const Table avx2 = {
+    "avx2",
+    loop::add, loop::sub, loop::mul, loop::pow,
+    loop::div, loop::mod,
+    loop::neg,
+    loop::eq, loop::ne, loop::gt, loop::ge, loop::lt, loop::le,
+    loop::land, loop::lor, loop::beq, loop::bne,
+    loop::lnot,
+};
+
+} // namespace kernels
@@ -0,0 +1,174 @@
+#include "kernels_isa.h"
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+namespace kernels {
+
+namespace {
+
+// the names clash with the functions of kernels.h
+namespace loop {
+
+const std::size_t W = 8;
+
+// the W bits of m as bytes of 0 or 1, a nibble at a time as in avx2
+inline void bytes(__mmask8 m, unsigned char *out)
+{
+    const std::uint32_t lo = ((m & 0xFu) * 0x00204081u) & 0x01010101u;
+    const std::uint32_t hi = ((m >> 4) * 0x00204081u) & 0x01010101u;
+    std::memcpy(out, &lo, 4);
+    std::memcpy(out + 4, &hi, 4);
+}
+
+// the zero masked forms with all lanes set, the plain ones start from
+// an undefined register that makes gcc warn wherever they are inlined
+inline __m512d integer(__m512d v)
+{
+    const __mmask8 all = 0xFF;
+    return _mm512_maskz_cvtepi32_pd(all, _mm512_maskz_cvttpd_epi32(all, v));
+}
+
+#define ARITHMETIC(NAME, OP) \
+    void NAME(const double *l, const double *r, double *out, std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            _mm512_storeu_pd(\
+                out + i, OP(_mm512_loadu_pd(l + i), _mm512_loadu_pd(r + i))\
+            );\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define COMPARE(NAME, PREDICATE) \
+    void NAME(const double *l, const double *r, unsigned char *out, \
+        std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            bytes(\
+                _mm512_cmp_pd_mask(\
+                    _mm512_loadu_pd(l + i), _mm512_loadu_pd(r + i), PREDICATE\
+                ),\
+                out + i\
+            );\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define LOGIC(NAME, EXPR) \
+    void NAME(const unsigned char *l, const unsigned char *r, \
+        unsigned char *out, std::size_t n)\
+    {\
+        const __m512i one = _mm512_set1_epi8(1);\
+        (void)one;\
+        std::size_t i = 0;\
+        for (; i + 64 <= n; i += 64) {\
+            const __m512i a = _mm512_loadu_si512(l + i);\
+            const __m512i b = _mm512_loadu_si512(r + i);\
+            _mm512_storeu_si512(out + i, EXPR);\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+
+ARITHMETIC(add, _mm512_add_pd)
+ARITHMETIC(sub, _mm512_sub_pd)
+ARITHMETIC(mul, _mm512_mul_pd)
+
+COMPARE(eq, _CMP_EQ_OQ)
+COMPARE(ne, _CMP_NEQ_UQ)
+COMPARE(gt, _CMP_GT_OQ)
+COMPARE(ge, _CMP_GE_OQ)
+COMPARE(lt, _CMP_LT_OQ)
+COMPARE(le, _CMP_LE_OQ)
+
+LOGIC(land, _mm512_and_si512(a, b))
+LOGIC(lor, _mm512_or_si512(a, b))
+LOGIC(beq, _mm512_xor_si512(_mm512_xor_si512(a, b), one))
+LOGIC(bne, _mm512_xor_si512(a, b))
+
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m512d d = _mm512_loadu_pd(r + i);
+        bytes(_mm512_cmp_pd_mask(d, _mm512_setzero_pd(), _CMP_EQ_OQ), zero + i);
+        _mm512_storeu_pd(out + i, _mm512_div_pd(_mm512_loadu_pd(l + i), d));
+    }
+    scalar.div(l + i, r + i, out + i, zero + i, n - i);
+}
+
+// same as the sse2 one, see there
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    const __m512d none = _mm512_set1_pd(-1);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m512d a = integer(_mm512_loadu_pd(l + i));
+        const __m512d d = integer(_mm512_loadu_pd(r + i));
+        const __mmask8 z = _mm512_cmp_pd_mask(
+            d, _mm512_setzero_pd(), _CMP_EQ_OQ
+        );
+        const __mmask8 ok = ~(z | _mm512_cmp_pd_mask(d, none, _CMP_EQ_OQ));
+        const __m512d q = integer(_mm512_div_pd(a, d));
+        bytes(z, zero + i);
+        _mm512_storeu_pd(
+            out + i,
+            _mm512_maskz_mov_pd(ok, _mm512_sub_pd(a, _mm512_mul_pd(q, d)))
+        );
+    }
+    scalar.mod(l + i, r + i, out + i, zero + i, n - i);
+}
+
+void pow(const double *l, const double *r, double *out, std::size_t n)
+{
+    scalar.pow(l, r, out, n);
+}
+
+// _mm512_xor_pd needs avx512dq, the sign is flipped as an integer
+void neg(const double *v, double *out, std::size_t n)
+{
+    const __m512i sign = _mm512_set1_epi64(INT64_MIN);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m512i x = _mm512_castpd_si512(_mm512_loadu_pd(v + i));
+        _mm512_storeu_pd(
+            out + i, _mm512_castsi512_pd(_mm512_xor_si512(x, sign))
+        );
+    }
+    scalar.neg(v + i, out + i, n - i);
+}
+
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n)
+{
+    const __m512i one = _mm512_set1_epi8(1);
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_si512(
+            out + i, _mm512_xor_si512(_mm512_loadu_si512(v + i), one)
+        );
+    }
+    scalar.lnot(v + i, out + i, n - i);
+}
+
+} // namespace loop
+
+} // namespace
+
+const Table avx512 = {
+    "avx512",
+    loop::add, loop::sub, loop::mul, loop::pow,
+    loop::div, loop::mod,
+    loop::neg,
+    loop::eq, loop::ne, loop::gt, loop::ge, loop::lt, loop::le,
+    loop::land, loop::lor, loop::beq, loop::bne,
+    loop::lnot,
+};
+
+} // namespace kernels
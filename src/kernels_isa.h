@@ -0,0 +1,20 @@
+#ifndef HEADER_F374ECC4FD8541A68D9C67870C10179E
+#define HEADER_F374ECC4FD8541A68D9C67870C10179E
+
+#include "kernels.h"
+
+// the kernels of one instruction set each, the vector ones are compiled
+// with their own flags and handle the rows past the last full vector
+// with the scalar Table
+namespace kernels {
+
+extern const Table scalar;
+#ifdef KERNELS_X86
+extern const Table sse2;
+extern const Table avx2;
+extern const Table avx512;
+#endif
+
+} // namespace kernels
+
+#endif
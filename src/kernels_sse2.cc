@@ -0,0 +1,166 @@
+#include "kernels_isa.h"
+
+#include <emmintrin.h>
+
+namespace kernels {
+
+namespace {
+
+// the names clash with the functions of kernels.h
+namespace loop {
+
+const std::size_t W = 2;
+
+// the low W bits of m as bytes of 0 or 1
+inline void bytes(int m, unsigned char *out)
+{
+    out[0] = m & 1;
+    out[1] = (m >> 1) & 1;
+}
+
+#define ARITHMETIC(NAME, OP) \
+    void NAME(const double *l, const double *r, double *out, std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            _mm_storeu_pd(\
+                out + i, OP(_mm_loadu_pd(l + i), _mm_loadu_pd(r + i))\
+            );\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define COMPARE(NAME, OP) \
+    void NAME(const double *l, const double *r, unsigned char *out, \
+        std::size_t n)\
+    {\
+        std::size_t i = 0;\
+        for (; i + W <= n; i += W) {\
+            const __m128d c = OP(_mm_loadu_pd(l + i), _mm_loadu_pd(r + i));\
+            bytes(_mm_movemask_pd(c), out + i);\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+#define LOGIC(NAME, EXPR) \
+    void NAME(const unsigned char *l, const unsigned char *r, \
+        unsigned char *out, std::size_t n)\
+    {\
+        const __m128i one = _mm_set1_epi8(1);\
+        (void)one;\
+        std::size_t i = 0;\
+        for (; i + 16 <= n; i += 16) {\
+            const __m128i a = _mm_loadu_si128(\
+                reinterpret_cast<const __m128i *>(l + i)\
+            );\
+            const __m128i b = _mm_loadu_si128(\
+                reinterpret_cast<const __m128i *>(r + i)\
+            );\
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), EXPR);\
+        }\
+        scalar.NAME(l + i, r + i, out + i, n - i);\
+    }
+
+ARITHMETIC(add, _mm_add_pd)
+ARITHMETIC(sub, _mm_sub_pd)
+ARITHMETIC(mul, _mm_mul_pd)
+
+COMPARE(eq, _mm_cmpeq_pd)
+COMPARE(ne, _mm_cmpneq_pd)
+COMPARE(gt, _mm_cmpgt_pd)
+COMPARE(ge, _mm_cmpge_pd)
+COMPARE(lt, _mm_cmplt_pd)
+COMPARE(le, _mm_cmple_pd)
+
+LOGIC(land, _mm_and_si128(a, b))
+LOGIC(lor, _mm_or_si128(a, b))
+LOGIC(beq, _mm_xor_si128(_mm_xor_si128(a, b), one))
+LOGIC(bne, _mm_xor_si128(a, b))
+
+void div(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m128d d = _mm_loadu_pd(r + i);
+        bytes(_mm_movemask_pd(_mm_cmpeq_pd(d, _mm_setzero_pd())), zero + i);
+        _mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(l + i), d));
+    }
+    scalar.div(l + i, r + i, out + i, zero + i, n - i);
+}
+
+inline __m128d integer(__m128d v)
+{
+    return _mm_cvtepi32_pd(_mm_cvttpd_epi32(v));
+}
+
+// cvttpd gives INT_MIN for NaN and out of range values like truncate(),
+// the quotient of two ints is close enough to exact for its truncation
+// to be the integer quotient, so a - q * d is the exact remainder
+void mod(
+    const double *l, const double *r, double *out, unsigned char *zero,
+    std::size_t n
+)
+{
+    const __m128d none = _mm_set1_pd(-1);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        const __m128d a = integer(_mm_loadu_pd(l + i));
+        const __m128d d = integer(_mm_loadu_pd(r + i));
+        const __m128d z = _mm_cmpeq_pd(d, _mm_setzero_pd());
+        const __m128d bad = _mm_or_pd(z, _mm_cmpeq_pd(d, none));
+        const __m128d q = integer(_mm_div_pd(a, d));
+        bytes(_mm_movemask_pd(z), zero + i);
+        _mm_storeu_pd(
+            out + i, _mm_andnot_pd(bad, _mm_sub_pd(a, _mm_mul_pd(q, d)))
+        );
+    }
+    scalar.mod(l + i, r + i, out + i, zero + i, n - i);
+}
+
+// no vector pow, the wrapper keeps the Table constant initialized
+void pow(const double *l, const double *r, double *out, std::size_t n)
+{
+    scalar.pow(l, r, out, n);
+}
+
+void neg(const double *v, double *out, std::size_t n)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        _mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(v + i), sign));
+    }
+    scalar.neg(v + i, out + i, n - i);
+}
+
+void lnot(const unsigned char *v, unsigned char *out, std::size_t n)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i a = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(v + i)
+        );
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(a, one)
+        );
+    }
+    scalar.lnot(v + i, out + i, n - i);
+}
+
+} // namespace loop
+
+} // namespace
+
+const Table sse2 = {
+    "sse2",
+    loop::add, loop::sub, loop::mul, loop::pow,
+    loop::div, loop::mod,
+    loop::neg,
+    loop::eq, loop::ne, loop::gt, loop::ge, loop::lt, loop::le,
+    loop::land, loop::lor, loop::beq, loop::bne,
+    loop::lnot,
+};
+
+} // namespace kernels
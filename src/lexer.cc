@@ -0,0 +1,317 @@
+#include "lexer.h"
+#include "number.h"
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+
+static bool isSpace(int c)
+{
+    return c != EOF && std::isspace(c);
+}
+
+static bool isAlpha(int c)
+{
+    return c != EOF && std::isalpha(c);
+}
+
+static bool isDigit(int c)
+{
+    return c != EOF && std::isdigit(c);
+}
+
+static bool isAlnum(int c)
+{
+    return c != EOF && std::isalnum(c);
+}
+
+Lexer::Lexer(const char *s, std::size_t n)
+    : begin_(s), p_(s), end_(s + n), copied_(false)
+{
+}
+
+int Lexer::peek() const
+{
+    return p_ < end_ ? static_cast<unsigned char>(*p_) : EOF;
+}
+
+int Lexer::get()
+{
+    return p_ < end_ ? static_cast<unsigned char>(*p_++) : EOF;
+}
+
+void Lexer::skipWs()
+{
+    while (isSpace(peek())) {
+        ++p_;
+    }
+}
+
+void Lexer::append(const char *from, const char *to)
+{
+    if (!copied_ && from == sym_.p + sym_.n) {
+        sym_.n += to - from;
+        return;
+    }
+    if (!copied_) {
+        scratch_.assign(sym_.p, sym_.n);
+        copied_ = true;
+    }
+    scratch_.append(from, to);
+}
+
+Lexer::TK Lexer::next(Token &tok, std::string &msg)
+{
+    skipWs();
+    tok.at = p_ - begin_;
+    const TK tk = scan(tok, msg);
+    tok.n = p_ - begin_ - tok.at;
+    // a symbol looks past the blanks behind it for more of itself
+    while (tok.n && isSpace(
+        static_cast<unsigned char>(begin_[tok.at + tok.n - 1])
+    )) {
+        --tok.n;
+    }
+    return tk;
+}
+
+Lexer::TK Lexer::scan(Token &tok, std::string &msg)
+{
+    const int peek = this->peek();
+    if (peek == EOF) {
+        msg = "EOF";
+        return TK::END;
+    } else if (isAlpha(peek) || peek == '_') {
+        sym_ = Span(p_, 0);
+        copied_ = false;
+        const auto r = peekAlpha(msg);
+        if (r != TK::SYMBOL) {
+            return r;
+        }
+        tok.text = copied_ ? Span(scratch_) : sym_;
+        if (tok.text == Span("true", 4)) {
+            return TK::T;
+        } else if (tok.text == Span("false", 5)) {
+            return TK::F;
+        }
+        return TK::SYMBOL;
+    } else if (isDigit(peek)) {
+        return number(tok);
+    } else switch (peek) {
+            case '-':
+                ++p_;
+                tok.op = Ast::O::MINUS;
+                return TK::OP;
+            case '+':
+                ++p_;
+                tok.op = Ast::O::PLUS;
+                return TK::OP;
+            case '*':
+                ++p_;
+                tok.op = Ast::O::MULTIPLY;
+                return TK::OP;
+            case '/':
+                ++p_;
+                tok.op = Ast::O::DIVISION;
+                return TK::OP;
+            case '%':
+                ++p_;
+                tok.op = Ast::O::MODULO;
+                return TK::OP;
+            case '^':
+                ++p_;
+                tok.op = Ast::O::POWER;
+                return TK::OP;
+            case '(':
+                ++p_;
+                return TK::BRACKET_OPEN;
+            case ')':
+                ++p_;
+                return TK::BRACKET_CLOSE;
+            case '&':
+                if (twoChars('&')) {
+                    tok.op = Ast::O::LOGICAL_AND;
+                    return TK::OP;
+                }
+                msg = "operator '&' not understandable, do you mean '&&' ?";
+                return TK::ERROR;
+            case '|':
+                if (twoChars('|')) {
+                    tok.op = Ast::O::LOGICAL_OR;
+                    return TK::OP;
+                }
+                msg = "operator '|' not understandable, do you mean '|| ?";
+                return TK::ERROR;
+            case '=':
+                if (twoChars('=')) {
+                    tok.op = Ast::O::CMP_EQ;
+                    return TK::OP;
+                }
+                msg = "operator '=' not understandable, do you mean '==' ?";
+                return TK::ERROR;
+            case '<':
+                tok.op = optionalEQ(Ast::O::CMP_LE, Ast::O::CMP_LT);
+                return TK::OP;
+            case '>':
+                tok.op = optionalEQ(Ast::O::CMP_GE, Ast::O::CMP_GT);
+                return TK::OP;
+            case '!':
+                tok.op = optionalEQ(Ast::O::CMP_NE, Ast::O::LOGICAL_NOT);
+                return TK::OP;
+            case '"':
+                return peekQuote(tok, msg);
+            default:
+                msg = "invalid symbol ";
+                msg += static_cast<char>(peek);
+                return TK::ERROR;
+    }
+}
+
+bool Lexer::twoChars(char second)
+{
+    ++p_;
+    return get() == second;
+}
+
+Ast::O Lexer::optionalEQ(Ast::O withEQ, Ast::O without)
+{
+    ++p_;
+    if (peek() == '=') {
+        ++p_;
+        return withEQ;
+    }
+    return without;
+}
+
+Lexer::TK Lexer::number(Token &tok)
+{
+    const char *start = p_;
+    while (isDigit(peek())) {
+        ++p_;
+    }
+    if (peek() == '.') {
+        ++p_;
+        while (isDigit(peek())) {
+            ++p_;
+        }
+    }
+    if (peek() == 'e' || peek() == 'E') {
+        const char *e = p_ + 1;
+        if (e < end_ && (*e == '+' || *e == '-')) {
+            ++e;
+        }
+        if (e < end_ && isDigit(static_cast<unsigned char>(*e))) {
+            p_ = e;
+            while (isDigit(peek())) {
+                ++p_;
+            }
+        }
+    }
+    tok.text = Span(start, p_ - start);
+    tok.num = parseNumber(start, tok.text.n);
+    return TK::NUMBER;
+}
+
+#define CASE_BRACKETS \
+    case '(':\
+        if (pushBrackets(')', msg) == TK::ERROR) {\
+            return TK::ERROR;\
+        }\
+        break;\
+    case '[':\
+        if (pushBrackets(']', msg) == TK::ERROR) {\
+            return TK::ERROR;\
+        }\
+        break;\
+    case '{':\
+        if (pushBrackets('}', msg) == TK::ERROR) {\
+            return TK::ERROR;\
+        }\
+        break;
+
+Lexer::TK Lexer::peekAlpha(std::string &msg)
+{
+    do {
+        const char *start = p_;
+        if (p_ < end_) {
+            ++p_;
+        }
+        while (isAlnum(peek()) || peek() == '_') {
+            ++p_;
+        }
+        append(start, p_);
+        bool consumed = true;
+        while (consumed) {
+            skipWs();
+            switch (peek()) {
+                case '.':
+                    append(p_, p_ + 1);
+                    ++p_;
+                    return peekAlpha(msg);
+                CASE_BRACKETS
+                default:
+                    consumed = false;
+                    break;
+            }
+        }
+    } while (isAlpha(peek()) || peek() == '.' || peek() == '_');
+    return TK::SYMBOL;
+}
+
+Lexer::TK Lexer::pushBrackets(char closeChar, std::string &msg)
+{
+    append(p_, p_ + 1);
+    ++p_;
+    while (peek() != closeChar) {
+        switch (peek()) {
+            case EOF:
+                msg = "unmatched parethenses";
+                return TK::ERROR;
+            case '"': {
+                const char *start = p_++;
+                while (peek() != '"') {
+                    if (peek() == EOF) {
+                        msg = "unmatched quote";
+                        return TK::ERROR;
+                    }
+                    ++p_;
+                }
+                ++p_;
+                append(start, p_);
+                break;
+            }
+            CASE_BRACKETS
+            default:
+                append(p_, p_ + 1);
+                ++p_;
+        }
+    }
+    append(p_, p_ + 1);
+    ++p_;
+    return TK::SYMBOL;
+}
+
+Lexer::TK Lexer::peekQuote(Token &tok, std::string &msg)
+{
+    const char *start = ++p_;
+    while (peek() != '"') {
+        if (peek() == EOF) {
+            msg = "unmatched quote";
+            return TK::ERROR;
+        }
+        ++p_;
+    }
+    tok.text = Span(start, p_ - start);
+    ++p_; // the tail quote
+    return TK::STRING;
+}
+
+Span Lexer::nextWord()
+{
+    skipWs();
+    const char *start = p_;
+    while (peek() != EOF && !isSpace(peek())) {
+        ++p_;
+    }
+    return Span(start, p_ - start);
+}
@@ -0,0 +1,52 @@
+#ifndef HEADER_08598FA02AE74BE49CD968B938F89EA2
+#define HEADER_08598FA02AE74BE49CD968B938F89EA2
+
+#include "ast.h"
+#include "span.h"
+
+#include <cstddef>
+#include <string>
+
+/// @brief tokenizer working directly on a contiguous buffer
+/// @note token texts are spans into the source buffer, only symbols whose
+/// spelling has to be normalized (e.g. "a (x)" -> "a(x)") are copied into
+/// an internal scratch buffer, which stays valid until the next token
+class Lexer
+{
+public:
+    enum class TK {
+        UNKNOWN, ERROR, END, SYMBOL, STRING, NUMBER, T, F, OP,
+        BRACKET_OPEN, BRACKET_CLOSE
+    };
+    struct Token
+    {
+        Span text;
+        Ast::O op;
+        double num;
+        std::size_t at; ///< offset of the token in the buffer
+        std::size_t n;
+    };
+    Lexer(const char *s, std::size_t n);
+    TK next(Token &tok, std::string &msg);
+    Span nextWord();
+private:
+    const char *begin_;
+    const char *p_;
+    const char *end_;
+    std::string scratch_;
+    bool copied_;
+    Span sym_;
+    int peek() const;
+    int get();
+    void skipWs();
+    void append(const char *from, const char *to);
+    TK scan(Token &tok, std::string &msg);
+    TK number(Token &tok);
+    TK peekAlpha(std::string &msg);
+    TK pushBrackets(char closeChar, std::string &msg);
+    TK peekQuote(Token &tok, std::string &msg);
+    bool twoChars(char second);
+    Ast::O optionalEQ(Ast::O withEQ, Ast::O without);
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "mapping.h"
+
+#if defined __unix__ || defined __APPLE__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool Mapping::open(const std::string &path, bool random, std::string &msg)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        msg = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        msg = "cannot open " + path;
+        return false;
+    }
+    if (st.st_size == 0) {
+        // mmap takes no empty range
+        ::close(fd);
+        data_ = "";
+        return true;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        msg = "cannot map " + path;
+        return false;
+    }
+    madvise(p, st.st_size, random ? MADV_RANDOM : MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(p);
+    size_ = st.st_size;
+    return true;
+}
+
+void Mapping::close()
+{
+    if (size_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+#include <fstream>
+#include <iterator>
+
+bool Mapping::open(const std::string &path, bool, std::string &msg)
+{
+    close();
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        msg = "cannot open " + path;
+        return false;
+    }
+    copy_.assign(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+    data_ = copy_.data();
+    size_ = copy_.size();
+    return true;
+}
+
+void Mapping::close()
+{
+    copy_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HEADER_6CFF2D1225274AF9BC60A852ABDAA871
+#define HEADER_6CFF2D1225274AF9BC60A852ABDAA871
+
+#include <cstddef>
+#include <string>
+
+/// @brief a file mapped read-only and shared with other processes mapping
+/// it, read into memory where mmap is missing
+class Mapping
+{
+public:
+    Mapping() : data_(nullptr), size_(0) {}
+    ~Mapping() { close(); }
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+    /// @param random the pages are read in no order, so the kernel should
+    /// not read ahead
+    bool open(const std::string &path, bool random, std::string &msg);
+    void close();
+    /// @brief null if no file is open, an empty file has data too
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+private:
+    const char *data_;
+    std::size_t size_;
+#if !(defined __unix__ || defined __APPLE__)
+    std::string copy_;
+#endif
+};
+
+#endif
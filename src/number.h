@@ -0,0 +1,65 @@
+#ifndef HEADER_4EC7A9B59FD74AC997A36B2D56A91652
+#define HEADER_4EC7A9B59FD74AC997A36B2D56A91652
+
+#include "span.h"
+
+#include <charconv>
+#include <clocale>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <system_error>
+
+/// @brief room for every number formatNumber() writes
+const std::size_t NUMBER_CHARS = 32;
+
+/// @brief writes v to buf as std::ostream does with max_digits10
+/// precision in the "C" locale, the digits of printf("%.17g")
+inline Span formatNumber(double v, char *buf)
+{
+    const auto r = std::to_chars(buf, buf + NUMBER_CHARS, v,
+        std::chars_format::general, std::numeric_limits<double>::max_digits10);
+    return Span(buf, r.ptr - buf);
+}
+
+/// @brief the value strtod() gives for a number as the Lexer takes it,
+/// digits with an optional fraction and exponent, in any locale
+inline double parseNumber(const char *p, std::size_t n)
+{
+    double v = 0;
+    const auto r = std::from_chars(p, p + n, v);
+    if (r.ec != std::errc::result_out_of_range) {
+        return v;
+    }
+    // past the range of double, and for subnormals in some libraries,
+    // strtod() gives HUGE_VAL, 0 or the subnormal, with the decimal point
+    // of the locale
+    std::string s(p, r.ptr - p);
+    const std::size_t dot = s.find('.');
+    if (dot != std::string::npos) {
+        s.replace(dot, 1, std::localeconv()->decimal_point);
+    }
+    return std::strtod(s.c_str(), nullptr);
+}
+
+/// @brief reads the whole of p as a number, an optional - and then what
+/// the Lexer takes for one, with the value parseNumber() gives
+/// @return false for anything else, e.g. spaces, hex, inf or nan
+inline bool readNumber(const char *p, std::size_t n, double &v)
+{
+    const char *q = p + (n > 0 && *p == '-');
+    if (q == p + n || !((*q >= '0' && *q <= '9') || *q == '.')) {
+        return false;
+    }
+    const auto r = std::from_chars(p, p + n, v);
+    if (r.ptr != p + n) {
+        return false;
+    }
+    if (r.ec == std::errc::result_out_of_range) {
+        v = parseNumber(p, n);
+    }
+    return r.ec == std::errc() || r.ec == std::errc::result_out_of_range;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include "optimize.h"
+#include "ast.h"
+#include "value.h"
+
+#include <cmath>
+#include <string>
+#include <utility>
+
+// possible result types of a successful evaluation
+enum : unsigned { NUM = 1, STR = 2, BOOL = 4, ANY = NUM | STR | BOOL };
+
+static unsigned types(const Ast::Ptr &p)
+{
+    switch (p->t) {
+        case Ast::T::NUMBER:
+            return NUM;
+        case Ast::T::STRING:
+            return STR;
+        case Ast::T::BOOLEAN:
+            return BOOL;
+        case Ast::T::OPERATOR:
+            if (!p->left) {
+                return p->op == Ast::O::LOGICAL_NOT ? BOOL : NUM;
+            }
+            switch (p->op) {
+                case Ast::O::PLUS:
+                case Ast::O::MULTIPLY:
+                    return NUM | STR;
+                case Ast::O::MINUS:
+                case Ast::O::DIVISION:
+                case Ast::O::MODULO:
+                case Ast::O::POWER:
+                    return NUM;
+                default:
+                    return BOOL;
+            }
+        default:
+            return ANY;
+    }
+}
+
+static bool isLiteral(const Ast::Ptr &p)
+{
+    return p->t == Ast::T::NUMBER || p->t == Ast::T::STRING
+        || p->t == Ast::T::BOOLEAN;
+}
+
+static bool isNumber(const Ast::Ptr &p, double v)
+{
+    // x - (-0) is not x for x == -0
+    return p->t == Ast::T::NUMBER && p->num == v && !std::signbit(p->num);
+}
+
+static bool isBoolean(const Ast::Ptr &p, bool b)
+{
+    return p->t == Ast::T::BOOLEAN && p->b == b;
+}
+
+static bool isUnary(const Ast::Ptr &p, Ast::O op)
+{
+    return p->t == Ast::T::OPERATOR && !p->left && p->right && p->op == op;
+}
+
+static Ast::Ptr *neutral(Ast::Ptr &p, EvalMode mode)
+{
+    auto &l = p->left;
+    auto &r = p->right;
+    if (!l) {
+        switch (p->op) {
+            case Ast::O::PLUS:
+                return types(r) == NUM ? &r : nullptr;
+            case Ast::O::MINUS:
+                return isUnary(r, Ast::O::MINUS) && types(r->right) == NUM
+                    ? &r->right : nullptr;
+            case Ast::O::LOGICAL_NOT:
+                return isUnary(r, Ast::O::LOGICAL_NOT)
+                    && types(r->right) == BOOL ? &r->right : nullptr;
+            default:
+                return nullptr;
+        }
+    }
+    switch (p->op) {
+        case Ast::O::MULTIPLY:
+            if (isNumber(r, 1) && !(types(l) & BOOL)) {
+                return &l;
+            }
+            if (isNumber(l, 1) && !(types(r) & BOOL)) {
+                return &r;
+            }
+            return nullptr;
+        case Ast::O::DIVISION:
+            return isNumber(r, 1) && types(l) == NUM ? &l : nullptr;
+        case Ast::O::MINUS:
+            return isNumber(r, 0) && types(l) == NUM ? &l : nullptr;
+        case Ast::O::LOGICAL_AND:
+        case Ast::O::LOGICAL_OR: {
+            const bool unit = p->op == Ast::O::LOGICAL_AND;
+            if (mode == EvalMode::SHORT_CIRCUIT && isBoolean(l, !unit)) {
+                return &l;
+            }
+            if (isBoolean(l, unit) && types(r) == BOOL) {
+                return &r;
+            }
+            if (isBoolean(r, unit) && types(l) == BOOL) {
+                return &l;
+            }
+            return nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+static void fold(Ast::Ptr &p, EvalMode mode)
+{
+    if (!p || p->t != Ast::T::OPERATOR) {
+        return;
+    }
+    fold(p->left, mode);
+    fold(p->right, mode);
+    if (!p->right) {
+        // no operand to work with, evaluation reports it
+        return;
+    }
+    if (isLiteral(p->right) && (!p->left || isLiteral(p->left))) {
+        std::string msg;
+        const auto v = evaluate(p, Value::Dict(), msg, mode);
+        if (v) {
+            p = v.toAst();
+            return;
+        }
+    }
+    if (Ast::Ptr *keep = neutral(p, mode)) {
+        Ast::Ptr k = std::move(*keep);
+        p = std::move(k);
+    }
+}
+
+std::size_t count(const Ast::Ptr &root)
+{
+    if (!root) {
+        return 0;
+    }
+    return 1 + count(root->left) + count(root->right);
+}
+
+std::size_t simplify(Ast::Ptr &root, EvalMode mode)
+{
+    const std::size_t before = count(root);
+    fold(root, mode);
+    return before - count(root);
+}
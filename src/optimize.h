@@ -0,0 +1,16 @@
+#ifndef HEADER_2A4C41A0E7B94F1B8C2FDE9A33C5B7D1
+#define HEADER_2A4C41A0E7B94F1B8C2FDE9A33C5B7D1
+
+#include "ast.h"
+
+#include <cstddef>
+
+/// @brief folds literal-only subtrees and removes neutral operations
+/// @note a rewrite is only done if eval() gives the same result and the
+/// same error for every dictionary, so failing constants like 1/0 stay.
+/// Rewrites valid in STRICT mode are valid in SHORT_CIRCUIT mode too.
+/// @return the number of removed nodes
+std::size_t simplify(Ast::Ptr &root, EvalMode mode = EvalMode::STRICT);
+std::size_t count(const Ast::Ptr &root);
+
+#endif
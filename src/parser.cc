@@ -1,219 +1,48 @@
 #include "parser.h"
 #include "ast.h"
+#include "instrument.h"
 
-#include <cctype>
 #include <istream>
+#include <iterator>
 
-Parser::Parser(std::istream &s) : s_(s), tk_(TK::UNKNOWN), eof_(false)
+Parser::Parser(std::istream &s)
+    : buf_(new std::string(
+        std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>()
+    )),
+    lex_(buf_->data(), buf_->size()), tk_(TK::UNKNOWN), eof_(false)
 {
 }
 
-Parser::TK Parser::token()
-{
-    s_ >> std::ws;
-    const int peek = static_cast<int>(s_.peek());
-    if (peek == std::istream::traits_type::eof()) {
-        eof_ = true;
-        msg_ = "EOF";
-        return TK::END;
-    } else if (std::isalpha(peek) || peek == '_') {
-        str_.clear();
-        return peekAlpha();
-    } else if (std::isdigit(peek)) {
-        s_ >> num_;
-        return TK::NUMBER;
-    } else switch (peek) {
-            case '-':
-                s_.get();
-                op_ = Ast::O::MINUS;
-                return TK::OP;
-            case '+':
-                s_.get();
-                op_ = Ast::O::PLUS;
-                return TK::OP;
-            case '*':
-                s_.get();
-                op_ = Ast::O::MULTIPLY;
-                return TK::OP;
-            case '/':
-                s_.get();
-                op_ = Ast::O::DIVISION;
-                return TK::OP;
-            case '%':
-                s_.get();
-                op_ = Ast::O::MODULO;
-                return TK::OP;
-            case '^':
-                s_.get();
-                op_ = Ast::O::POWER;
-                return TK::OP;
-            case '(':
-                s_.get();
-                return TK::BRACKET_OPEN;
-            case ')':
-                s_.get();
-                return TK::BRACKET_CLOSE;
-            case '&':
-                return peekAND();
-            case '|':
-                return peekOR();
-            case '=':
-                return peekEQ();
-            case '<':
-                return peekLT();
-            case '>':
-                return peekGT();
-            case '!':
-                return peekNot();
-            case '"':
-                return peekQuote();
-            default:
-                msg_ = "invalid symbol ";
-                msg_ += static_cast<char>(peek);
-                return TK::ERROR;
-    }
-}
-
-Parser::TK Parser::peekEQ()
+Parser::Parser(const char *s, std::size_t n)
+    : lex_(s, n), tk_(TK::UNKNOWN), eof_(false)
 {
-    s_.get();
-    const auto next = s_.get();
-    if (next == '=') {
-        op_ = Ast::O::CMP_EQ;
-        return TK::OP;
-    }
-    msg_ = "operator '=' not understandable, do you mean '==' ?";
-    return TK::ERROR;
 }
 
-Parser::TK Parser::peekLT()
+// an operator covers the text from its left operand, or from itself if
+// it has none, to the end of its right operand
+static void cover(Ast &root)
 {
-    s_.get();
-    const auto next = s_.peek();
-    if (next == '=') {
-        op_ = Ast::O::CMP_LE;
-        s_.get();
-    } else {
-        op_ = Ast::O::CMP_LT;
+    if (root.left) {
+        root.at = root.left->at;
     }
-    return TK::OP;
+    root.n = root.right->at + root.right->n - root.at;
 }
 
-Parser::TK Parser::peekGT()
+Ast::Ptr Parser::located(Ast::Ptr node)
 {
-    s_.get();
-    const auto next = s_.peek();
-    if (next == '=') {
-        op_ = Ast::O::CMP_GE;
-        s_.get();
-    } else {
-        op_ = Ast::O::CMP_GT;
-    }
-    return TK::OP;
+    node->at = tok_.at;
+    node->n = tok_.n;
+    return node;
 }
 
-Parser::TK Parser::peekNot()
-{
-    s_.get();
-    const auto next = s_.peek();
-    if (next == '=') {
-        op_ = Ast::O::CMP_NE;
-        s_.get();
-    } else {
-        op_ = Ast::O::LOGICAL_NOT;
-    }
-    return TK::OP;
-}
-
-#define CASE_BRACKETS \
-    case '(':\
-        if (pushBrackets(')') == TK::ERROR) {\
-            return TK::ERROR;\
-        }\
-        break;\
-    case '[':\
-        if (pushBrackets(']') == TK::ERROR) {\
-            return TK::ERROR;\
-        }\
-        break;\
-    case '{':\
-        if (pushBrackets('}') == TK::ERROR) {\
-            return TK::ERROR;\
-        }\
-        break;
-
-Parser::TK Parser::peekAlpha()
-{
-    do {
-        str_.push_back(s_.get());
-        while (std::isalnum(s_.peek()) || s_.peek() == '_') {
-            str_.push_back(s_.get());
-        }
-        bool consumed = true;
-        while (consumed) {
-            s_ >> std::ws;
-            switch (s_.peek()) {
-                case '.':
-                    str_.push_back(s_.get());
-                    return peekAlpha();
-                CASE_BRACKETS
-                default:
-                    consumed = false;
-                    break;
-            }
-        }
-    } while (std::isalpha(s_.peek()) || s_.peek() == '.' || s_.peek() == '_');
-    if (str_ == "true") {
-        return TK::T;
-    } else if (str_ == "false") {
-        return TK::F;
-    }
-    return TK::SYMBOL;
-}
-
-Parser::TK Parser::pushBrackets(char closeChar)
-{
-    str_.push_back(s_.get());
-    while (s_.peek() != closeChar) {
-        switch (s_.peek()) {
-            case std::istream::traits_type::eof():
-                msg_ = "unmatched parethenses";
-                return TK::ERROR;
-            case '"': {
-                std::string t;
-                t.swap(str_);
-                const auto r = peekQuote();
-                if (r != TK::STRING) {
-                    return r;
-                }
-                t += '"';
-                t += str_;
-                t += '"';
-                str_.swap(t);
-                break;
-            }
-            CASE_BRACKETS
-            default:
-                str_.push_back(s_.get());
-        }
-    }
-    str_.push_back(s_.get());
-    return TK::SYMBOL;
-}
-
-Parser::TK Parser::peekQuote()
+Parser::TK Parser::token()
 {
-    s_.get();
-    while (s_.peek() != '"') {
-        if (s_.peek() == std::istream::traits_type::eof()) {
-            msg_ = "unmatched quote";
-            return TK::ERROR;
-        }
-        str_.push_back(s_.get());
+    const auto tk = lex_.next(tok_, msg_);
+    INSTRUMENT_COUNT(TOKENS);
+    if (tk == TK::END) {
+        eof_ = true;
     }
-    s_.get(); // the tail quote
-    return TK::STRING;
-
+    return tk;
 }
 
 Ast::Ptr Parser::parseAtomicExpr()
@@ -225,20 +54,21 @@ Ast::Ptr Parser::parseAtomicExpr()
             return nullptr;
         case TK::SYMBOL:
             swallowToken();
-            return Ast::makeSymbol(str_);
+            return located(Ast::makeSymbol(tok_.text));
         case TK::STRING:
             swallowToken();
-            return Ast::makeString(str_);
+            return located(Ast::makeString(tok_.text));
         case TK::NUMBER:
             swallowToken();
-            return Ast::make(num_);
+            return located(Ast::make(tok_.num));
         case TK::T:
             swallowToken();
-            return Ast::make(true);
+            return located(Ast::make(true));
         case TK::F:
             swallowToken();
-            return Ast::make(false);
+            return located(Ast::make(false));
         case TK::BRACKET_OPEN: {
+                const std::size_t open = tok_.at;
                 swallowToken();
                 Ast::Ptr root = parseExpr();
                 if (!root) {
@@ -252,6 +82,9 @@ Ast::Ptr Parser::parseAtomicExpr()
                     return nullptr;
                 }
                 swallowToken();
+                // the text of a node in parentheses includes them
+                root->at = open;
+                root->n = tok_.at + tok_.n - open;
                 return root;
             };
         case TK::ERROR:
@@ -267,35 +100,14 @@ Ast::Ptr Parser::parseAtomicExpr()
 
 void Parser::dumpPosition()
 {
-    std::string word;
-    s_ >> word;
+    const Span word = lex_.nextWord();
     msg_ += " before '";
-    msg_ += word.empty() ? "the end" : word;
-    msg_ += '\'';
-}
-
-Parser::TK Parser::peekAND()
-{
-    s_.get();
-    const auto next = s_.get();
-    if (next == '&') {
-        op_ = Ast::O::LOGICAL_AND;
-        return TK::OP;
-    }
-    msg_ = "operator '&' not understandable, do you mean '&&' ?";
-    return TK::ERROR;
-}
-
-Parser::TK Parser::peekOR()
-{
-    s_.get();
-    const auto next = s_.get();
-    if (next == '|') {
-        op_ = Ast::O::LOGICAL_OR;
-        return TK::OP;
+    if (word.empty()) {
+        msg_ += "the end";
+    } else {
+        msg_.append(word.p, word.n);
     }
-    msg_ = "operator '|' not understandable, do you mean '|| ?";
-    return TK::ERROR;
+    msg_ += '\'';
 }
 
 Ast::Ptr Parser::genericDeniableExpr(std::function<Ast::Ptr()> f)
@@ -305,20 +117,20 @@ Ast::Ptr Parser::genericDeniableExpr(std::function<Ast::Ptr()> f)
         return f();
     }
     Ast::Ptr root;
-    switch (op_) {
+    switch (tok_.op) {
         case Ast::O::PLUS:
             swallowToken();
-            root = Ast::make(Ast::O::PLUS);
+            root = located(Ast::make(Ast::O::PLUS));
             root->right = f();
             break;
         case Ast::O::MINUS:
             swallowToken();
-            root = Ast::make(Ast::O::MINUS);
+            root = located(Ast::make(Ast::O::MINUS));
             root->right = f();
             break;
         case Ast::O::LOGICAL_NOT:
             swallowToken();
-            root = Ast::make(Ast::O::LOGICAL_NOT);
+            root = located(Ast::make(Ast::O::LOGICAL_NOT));
             root->right = f();
             break;
         default:
@@ -327,6 +139,13 @@ Ast::Ptr Parser::genericDeniableExpr(std::function<Ast::Ptr()> f)
             dumpPosition();
             root.release();
     }
+    if (root && !root->right) {
+        // the operand failed and told why, e.g. unexpected end
+        return nullptr;
+    }
+    if (root) {
+        cover(*root);
+    }
     return root;
 }
 
@@ -343,7 +162,6 @@ Ast::Ptr Parser::parseDeniablePotExpr()
 void Parser::preToken(bool force)
 {
     if (tk_ == TK::UNKNOWN || force) {
-        str_.clear();
         tk_  = token();
     }
 }
@@ -360,7 +178,7 @@ Ast::Ptr Parser::parsePotExpr()
         return nullptr;
     }
     preToken();
-    if (tk_ == TK::OP && op_ == Ast::O::POWER) {
+    if (tk_ == TK::OP && tok_.op == Ast::O::POWER) {
         swallowToken();
         auto a = std::move(root);
         root = Ast::make(Ast::O::POWER);
@@ -369,6 +187,7 @@ Ast::Ptr Parser::parsePotExpr()
         if (!root->right) {
             return nullptr;
         }
+        cover(*root);
     }
     return root;
 }
@@ -403,7 +222,7 @@ Ast::Ptr Parser::parseCmpExpr()
         return a;
     }
     Ast::Ptr root;
-    switch (op_) {
+    switch (tok_.op) {
         case Ast::O::CMP_EQ:
         case Ast::O::CMP_NE:
         case Ast::O::CMP_GT:
@@ -411,7 +230,7 @@ Ast::Ptr Parser::parseCmpExpr()
         case Ast::O::CMP_LT:
         case Ast::O::CMP_LE:
             swallowToken();
-            root = Ast::make(op_);
+            root = Ast::make(tok_.op);
             break;
         default:
             return a;
@@ -421,6 +240,7 @@ Ast::Ptr Parser::parseCmpExpr()
     if (!root->right) {
         return nullptr;
     }
+    cover(*root);
     return root;
 }
 
@@ -436,11 +256,11 @@ Ast::Ptr Parser::parseExpr()
         return a;
     }
     Ast::Ptr root;
-    switch (op_) {
+    switch (tok_.op) {
         case Ast::O::LOGICAL_AND:
         case Ast::O::LOGICAL_OR:
             swallowToken();
-            root = Ast::make(op_);
+            root = Ast::make(tok_.op);
             break;
         default:
             return a;
@@ -450,6 +270,7 @@ Ast::Ptr Parser::parseExpr()
     if (!root->right) {
         return nullptr;
     }
+    cover(*root);
     return root;
 }
 
@@ -460,11 +281,11 @@ Ast::Ptr Parser::parsePlusMinusExprTail(Ast::Ptr &&a)
         return std::move(a);
     }
     Ast::Ptr root;
-    switch (op_) {
+    switch (tok_.op) {
         case Ast::O::PLUS:
         case Ast::O::MINUS:
             swallowToken();
-            root = Ast::make(op_);
+            root = Ast::make(tok_.op);
             break;
         default:
             return std::move(a);
@@ -474,6 +295,7 @@ Ast::Ptr Parser::parsePlusMinusExprTail(Ast::Ptr &&a)
     if (!root->right) {
         return nullptr;
     }
+    cover(*root);
     return parsePlusMinusExprTail(std::move(root));
 }
 
@@ -484,12 +306,12 @@ Ast::Ptr Parser::parseMulDivModExprTail(Ast::Ptr &&a)
         return std::move(a);
     }
     Ast::Ptr root;
-    switch (op_) {
+    switch (tok_.op) {
         case Ast::O::MULTIPLY:
         case Ast::O::DIVISION:
         case Ast::O::MODULO:
             swallowToken();
-            root = Ast::make(op_);
+            root = Ast::make(tok_.op);
             break;
         default:
             return std::move(a);
@@ -499,6 +321,7 @@ Ast::Ptr Parser::parseMulDivModExprTail(Ast::Ptr &&a)
     if (!root->right) {
         return nullptr;
     }
+    cover(*root);
     return parseMulDivModExprTail(std::move(root));
 
 }
@@ -2,17 +2,21 @@
 #define HEADER_086303CA18754744903657E6B3A52B68
 
 #include "ast.h"
+#include "lexer.h"
+#include <cstddef>
 #include <iosfwd>
 #include <functional>
+#include <memory>
+#include <string>
 
 class Parser
 {
 public:
-    enum class TK {
-        UNKNOWN, ERROR, END, SYMBOL, STRING, NUMBER, T, F, OP,
-        BRACKET_OPEN, BRACKET_CLOSE
-    };
+    typedef Lexer::TK TK;
+    /// @note reads the rest of the stream into an owned buffer
     Parser(std::istream &s);
+    /// @note the buffer is not copied and must outlive the parser
+    Parser(const char *s, std::size_t n);
     bool eof() const { return eof_; }
     TK token();
     Ast::Ptr parseAtomicExpr();
@@ -26,24 +30,16 @@ public:
     Ast::Ptr parseExpr();
     const std::string &msg() const { return msg_; }
 private:
-    std::istream &s_;
+    std::unique_ptr<std::string> buf_;
+    Lexer lex_;
+    Lexer::Token tok_;
     std::string msg_;
-    std::string str_;
-    Ast::O op_;
     TK tk_;
-    double num_;
     void dumpPosition();
     void preToken(bool force = false);
     void swallowToken();
-    TK peekEQ();
-    TK peekLT();
-    TK peekGT();
-    TK peekNot();
-    TK peekAlpha();
-    TK peekAND();
-    TK peekOR();
-    Parser::TK pushBrackets(char closeChar);
-    Parser::TK peekQuote();
+    /// @brief node with the position of the current token
+    Ast::Ptr located(Ast::Ptr node);
     bool eof_;
     Ast::Ptr parsePlusMinusExprTail(Ast::Ptr &&);
     Ast::Ptr parseMulDivModExprTail(Ast::Ptr &&);
@@ -0,0 +1,156 @@
+#include "profile.h"
+#include "parser.h"
+
+#include <cstdio>
+
+namespace {
+
+void collect(const Ast::Ptr &p, std::unordered_map<const Ast *,
+    Profile::Node> &nodes)
+{
+    if (!p) {
+        return;
+    }
+    nodes[p.get()];
+    collect(p->left, nodes);
+    collect(p->right, nodes);
+}
+
+void line(
+    const Profile &profile,
+    const std::string &source,
+    const Ast::Ptr &p,
+    unsigned depth,
+    std::string &out
+)
+{
+    if (!p) {
+        return;
+    }
+    const Profile::Node &n = profile.node(*p);
+    char buf[128];
+    std::snprintf(buf, sizeof(buf),
+        "%10llu %8llu %12llu %10.1f %8llu %8llu %8llu  ",
+        static_cast<unsigned long long>(n.hits),
+        static_cast<unsigned long long>(n.errors),
+        static_cast<unsigned long long>(n.ns),
+        n.hits ? static_cast<double>(n.ns) / n.hits : 0.0,
+        static_cast<unsigned long long>(n.numbers),
+        static_cast<unsigned long long>(n.strings),
+        static_cast<unsigned long long>(n.booleans));
+    out += buf;
+    out.append(2 * depth, ' ');
+    out.append(source, p->at, p->n);
+    out += '\n';
+    line(profile, source, p->left, depth + 1, out);
+    line(profile, source, p->right, depth + 1, out);
+}
+
+void quote(const char *s, std::size_t n, std::string &out)
+{
+    out += '"';
+    for (std::size_t i = 0; i < n; ++i) {
+        const unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void object(
+    const Profile &profile,
+    const std::string &source,
+    const Ast::Ptr &p,
+    std::string &out
+)
+{
+    const Profile::Node &n = profile.node(*p);
+    out += "{\"text\": ";
+    quote(source.data() + p->at, p->n, out);
+    out += ", \"hits\": " + std::to_string(n.hits)
+        + ", \"errors\": " + std::to_string(n.errors)
+        + ", \"ns\": " + std::to_string(n.ns)
+        + ", \"types\": {\"number\": " + std::to_string(n.numbers)
+        + ", \"string\": " + std::to_string(n.strings)
+        + ", \"boolean\": " + std::to_string(n.booleans) + "}";
+    if (p->right) {
+        out += ", \"operands\": [";
+        if (p->left) {
+            object(profile, source, p->left, out);
+            out += ", ";
+        }
+        object(profile, source, p->right, out);
+        out += ']';
+    }
+    out += '}';
+}
+
+} // namespace
+
+Profile::Profile(const std::string &source, EvalMode mode)
+    : source_(source), mode_(mode)
+{
+    Parser p(source_.data(), source_.size());
+    root_ = p.parseExpr();
+    if (root_ && !p.eof()) {
+        root_.reset();
+    }
+    collect(root_, nodes_);
+}
+
+Value Profile::eval(const Value::Dict &dict, std::string &msg)
+{
+    return evaluate(root_, dict, msg, mode_, *this);
+}
+
+const Profile::Node &Profile::node(const Ast &n) const
+{
+    return nodes_.at(&n);
+}
+
+void Profile::record(const Ast &node, std::uint64_t ns, const Value &v)
+{
+    Node &n = nodes_[&node];
+    ++n.hits;
+    n.ns += ns;
+    switch (v.t()) {
+        case Ast::T::NUMBER:
+            ++n.numbers;
+            break;
+        case Ast::T::STRING:
+            ++n.strings;
+            break;
+        case Ast::T::BOOLEAN:
+            ++n.booleans;
+            break;
+        default:
+            ++n.errors;
+            break;
+    }
+}
+
+std::string Profile::text() const
+{
+    std::string out = "      hits   errors           ns     ns/hit"
+        "   number   string  boolean  expression\n";
+    line(*this, source_, root_, 0, out);
+    return out;
+}
+
+std::string Profile::json() const
+{
+    if (!root_) {
+        return "null";
+    }
+    std::string out;
+    object(*this, source_, root_, out);
+    return out;
+}
@@ -0,0 +1,44 @@
+#ifndef HEADER_7BA6D11F23904BC5BFA6FF419876F88D
+#define HEADER_7BA6D11F23904BC5BFA6FF419876F88D
+
+#include "ast.h"
+#include "value.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/// @brief what every node of an expression did over many evaluations
+/// @note the tree is parsed anew from the source without folding, so
+/// every node stands for a piece of the text as written. It is evaluated
+/// by the tree walker, nodes SHORT_CIRCUIT skips get no hit.
+class Profile : public Recorder
+{
+public:
+    struct Node
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t errors = 0;
+        std::uint64_t ns = 0;        ///< with the ones of the operands
+        std::uint64_t numbers = 0;   ///< results of each type
+        std::uint64_t strings = 0;
+        std::uint64_t booleans = 0;
+    };
+    Profile(const std::string &source, EvalMode mode);
+    /// @brief false if the source does not parse
+    explicit operator bool() const { return static_cast<bool>(root_); }
+    Value eval(const Value::Dict &dict, std::string &msg);
+    const Ast::Ptr &root() const { return root_; }
+    const Node &node(const Ast &n) const;
+    /// @brief one line per node, indented by its depth
+    std::string text() const;
+    std::string json() const;
+    void record(const Ast &node, std::uint64_t ns, const Value &v) override;
+private:
+    std::string source_;
+    Ast::Ptr root_;
+    EvalMode mode_;
+    std::unordered_map<const Ast *, Node> nodes_;
+};
+
+#endif
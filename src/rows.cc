@@ -0,0 +1,504 @@
+#include "rows.h"
+#include "number.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace rows {
+
+namespace {
+
+// copies the rows of a group of one expression to columns of their own,
+// evaluates them and puts the results back in the rows
+void evalGroup(
+    const Expression &e,
+    const std::vector<std::size_t> &slots,
+    const Chunk &c,
+    const std::vector<std::uint32_t> &rows,
+    ResultColumn &out
+)
+{
+    const auto names = e.slots();
+    const std::size_t n = rows.size();
+    std::vector<std::vector<double> > real(slots.size());
+    std::vector<std::unique_ptr<bool[]> > boolean(slots.size());
+    std::vector<std::vector<Span> > str(slots.size());
+    Expression::Columns columns;
+    for (std::size_t s = 0; s < slots.size(); ++s) {
+        const Cells &cells = c.cells[slots[s]];
+        switch (cells.kind[rows.front()]) {
+            case REAL:
+                for (const auto r : rows) {
+                    real[s].push_back(cells.real[r]);
+                }
+                columns[names[s]] = Column(real[s].data());
+                break;
+            case BOOL:
+                boolean[s].reset(new bool[n]);
+                for (std::size_t i = 0; i < n; ++i) {
+                    boolean[s][i] = cells.boolean[rows[i]];
+                }
+                columns[names[s]] = Column(boolean[s].get());
+                break;
+            case STRING:
+                for (const auto r : rows) {
+                    str[s].push_back(cells.str[r]);
+                }
+                columns[names[s]] = Column(str[s].data());
+                break;
+            default:
+                break;
+        }
+    }
+    ResultColumn group;
+    e.eval(columns, n, group);
+    for (std::size_t i = 0; i < n; ++i) {
+        out.type[rows[i]] = group.type[i];
+        out.real[rows[i]] = group.real[i];
+        out.str[rows[i]] = std::move(group.str[i]);
+    }
+}
+
+} // namespace
+
+const std::size_t Layout::NONE;
+
+void csv(
+    const std::string &line,
+    std::vector<Field> &fields,
+    std::deque<std::string> &decoded
+)
+{
+    fields.clear();
+    const char *p = line.data();
+    const char *end = p + line.size();
+    for (;;) {
+        Field f = {Span(p, 0), false};
+        if (p < end && *p == '"') {
+            f.quoted = true;
+            const char *begin = ++p;
+            std::string *copy = nullptr;
+            while (p < end && !(*p == '"' && (p + 1 == end || p[1] != '"'))) {
+                if (*p == '"') {
+                    // "" stands for ", the field is copied without them
+                    if (!copy) {
+                        decoded.emplace_back(begin, p);
+                        copy = &decoded.back();
+                    }
+                    ++p;
+                }
+                if (copy) {
+                    *copy += *p;
+                }
+                ++p;
+            }
+            f.text = copy ? Span(*copy) : Span(begin, p - begin);
+            while (p < end && *p != ',') {
+                ++p;
+            }
+        } else {
+            while (p < end && *p != ',') {
+                ++p;
+            }
+            f.text = Span(f.text.p, p - f.text.p);
+        }
+        fields.push_back(f);
+        if (p == end) {
+            return;
+        }
+        ++p;
+    }
+}
+
+bool openQuote(const std::string &line)
+{
+    // where csv() would be: at the start of a field, in an unquoted one,
+    // in a quoted one or just after a " in it
+    enum { START, PLAIN, QUOTED, CLOSED } state = START;
+    for (const char c : line) {
+        if (state == QUOTED) {
+            state = c == '"' ? CLOSED : QUOTED;
+        } else if (c == ',') {
+            state = START;
+        } else if (c == '"' && state != PLAIN) {
+            state = QUOTED;
+        } else {
+            state = PLAIN;
+        }
+    }
+    return state == QUOTED;
+}
+
+void set(Cells &c, std::size_t row, const Field &f)
+{
+    if (f.quoted) {
+        c.kind[row] = STRING;
+        c.str[row] = f.text;
+        return;
+    }
+    if (f.text.empty()) {
+        return;
+    }
+    const Span t = f.text;
+    if (t == Span("true", 4) || t == Span("false", 5)) {
+        c.kind[row] = BOOL;
+        c.boolean[row] = t.n == 4;
+        return;
+    }
+    if (readNumber(t.p, t.n, c.real[row])) {
+        c.kind[row] = REAL;
+        return;
+    }
+    c.real[row] = 0;
+    c.kind[row] = STRING;
+    c.str[row] = t;
+}
+
+void Json::ws()
+{
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) {
+        ++p_;
+    }
+}
+
+bool Json::take(char c)
+{
+    ws();
+    if (p_ < end_ && *p_ == c) {
+        ++p_;
+        return true;
+    }
+    return false;
+}
+
+bool Json::atEnd()
+{
+    ws();
+    return p_ == end_;
+}
+
+bool Json::literal(const char *s)
+{
+    const std::size_t n = std::strlen(s);
+    if (static_cast<std::size_t>(end_ - p_) < n
+        || std::memcmp(p_, s, n) != 0) {
+        return false;
+    }
+    p_ += n;
+    return true;
+}
+
+void Json::utf8(unsigned long c, std::string &out)
+{
+    if (c < 0x80) {
+        out += static_cast<char>(c);
+    } else if (c < 0x800) {
+        out += static_cast<char>(0xc0 | c >> 6);
+        out += static_cast<char>(0x80 | (c & 0x3f));
+    } else {
+        out += static_cast<char>(0xe0 | c >> 12);
+        out += static_cast<char>(0x80 | (c >> 6 & 0x3f));
+        out += static_cast<char>(0x80 | (c & 0x3f));
+    }
+}
+
+bool Json::string(Span &s)
+{
+    if (!take('"')) {
+        return false;
+    }
+    const char *begin = p_;
+    while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+        ++p_;
+    }
+    if (p_ < end_ && *p_ == '"') {
+        s = Span(begin, p_++ - begin);
+        return true;
+    }
+    decoded_.emplace_back(begin, p_);
+    std::string &out = decoded_.back();
+    while (p_ < end_ && *p_ != '"') {
+        if (*p_ != '\\') {
+            out += *p_++;
+            continue;
+        }
+        if (++p_ == end_) {
+            return false;
+        }
+        const char c = *p_++;
+        switch (c) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                if (end_ - p_ < 4) {
+                    return false;
+                }
+                char hex[5] = {p_[0], p_[1], p_[2], p_[3], 0};
+                char *e;
+                const unsigned long u = std::strtoul(hex, &e, 16);
+                if (e != hex + 4) {
+                    return false;
+                }
+                utf8(u, out);
+                p_ += 4;
+                break;
+            }
+            default:
+                out += c;
+                break;
+        }
+    }
+    if (p_ == end_) {
+        return false;
+    }
+    ++p_;
+    s = Span(out);
+    return true;
+}
+
+// skips a nested array or object
+bool Json::skip()
+{
+    int depth = 0;
+    do {
+        ws();
+        if (p_ == end_) {
+            return false;
+        }
+        if (*p_ == '"') {
+            Span s;
+            if (!string(s)) {
+                return false;
+            }
+            continue;
+        }
+        depth += *p_ == '[' || *p_ == '{';
+        depth -= *p_ == ']' || *p_ == '}';
+        ++p_;
+    } while (depth > 0);
+    return true;
+}
+
+bool Json::scalar(Kind &kind, Field &value, double &real)
+{
+    ws();
+    if (p_ == end_) {
+        return false;
+    }
+    kind = MISSING;
+    switch (*p_) {
+        case '"':
+            kind = STRING;
+            return string(value.text);
+        case 't':
+            kind = BOOL;
+            real = 1;
+            return literal("true");
+        case 'f':
+            kind = BOOL;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        case '[':
+        case '{':
+            return skip();
+        default: {
+            // the characters a number may have, the whole of them must be
+            // one
+            const char *e = p_;
+            while (e < end_ && *e && std::strchr("0123456789+-.eE", *e)) {
+                ++e;
+            }
+            if (!readNumber(p_, e - p_, real)) {
+                return false;
+            }
+            p_ = e;
+            kind = REAL;
+            return true;
+        }
+    }
+}
+
+void parse(const Options &o, const Layout &layout, Chunk &c)
+{
+    const std::size_t rows = c.lines.size();
+    c.cells.resize(layout.symbols.size());
+    for (auto &cells : c.cells) {
+        cells.resize(rows);
+    }
+    c.bad.assign(rows, false);
+    std::vector<Field> fields;
+    std::string key;
+    for (std::size_t row = 0; row < rows; ++row) {
+        const std::string &line = c.lines[row];
+        if (!o.ndjson) {
+            // a row of other fields than the header has no cells
+            csv(line, fields, c.decoded);
+            if (fields.size() != layout.csv.size()) {
+                c.bad[row] = true;
+                continue;
+            }
+            for (std::size_t i = 0; i < fields.size(); ++i) {
+                if (layout.csv[i] != Layout::NONE) {
+                    set(c.cells[layout.csv[i]], row, fields[i]);
+                }
+            }
+            continue;
+        }
+        Json json(line, c.decoded);
+        const bool ok = json.object(
+            [&](Span k, Kind kind, Span str, double real) {
+                key.assign(k.p, k.n);
+                const auto i = layout.index.find(key);
+                if (i == layout.index.end()) {
+                    return;
+                }
+                Cells &cells = c.cells[i->second];
+                cells.kind[row] = kind;
+                cells.real[row] = real;
+                cells.boolean[row] = real != 0;
+                cells.str[row] = str;
+            });
+        if (!ok) {
+            for (auto &cells : c.cells) {
+                cells.kind[row] = MISSING;
+            }
+            c.bad[row] = true;
+        }
+    }
+}
+
+void eval(
+    const std::vector<Expression> &expressions,
+    const std::vector<std::vector<std::size_t> > &slots,
+    const Layout &layout,
+    Chunk &c
+)
+{
+    const std::size_t rows = c.lines.size();
+    Expression::Columns columns;
+    std::vector<bool> mixed(layout.symbols.size());
+    for (std::size_t i = 0; i < layout.symbols.size(); ++i) {
+        mixed[i] = c.cells[i].uniform() == MIXED;
+        columns[layout.symbols[i]] = c.cells[i].column();
+    }
+    c.results.resize(expressions.size());
+    for (std::size_t e = 0; e < expressions.size(); ++e) {
+        bool uniform = true;
+        for (const auto s : slots[e]) {
+            uniform = uniform && !mixed[s];
+        }
+        ResultColumn &out = c.results[e];
+        if (uniform) {
+            expressions[e].eval(columns, rows, out);
+            continue;
+        }
+        out.type.assign(rows, ResultColumn::Type::ERROR);
+        out.real.assign(rows, 0);
+        out.str.assign(rows, std::string());
+        std::map<std::string, std::vector<std::uint32_t> > groups;
+        std::string kinds(slots[e].size(), '\0');
+        for (std::size_t r = 0; r < rows; ++r) {
+            for (std::size_t s = 0; s < slots[e].size(); ++s) {
+                kinds[s] = c.cells[slots[e][s]].kind[r];
+            }
+            groups[kinds].push_back(r);
+        }
+        for (const auto &g : groups) {
+            evalGroup(expressions[e], slots[e], c, g.second, out);
+        }
+    }
+}
+
+void number(double v, std::string &out)
+{
+    // %.15g unless it does not read back as v, then %.17g, as to_chars()
+    // and from_chars() do it in any locale
+    char buf[32];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v,
+        std::chars_format::general, 15);
+    double back = 0;
+    std::from_chars(buf, r.ptr, back);
+    if (back != v) {
+        r = std::to_chars(buf, buf + sizeof(buf), v,
+            std::chars_format::general, 17);
+    }
+    out.append(buf, r.ptr - buf);
+}
+
+void quote(const std::string &s, bool json, std::string &out)
+{
+    out += '"';
+    for (const char ch : s) {
+        const unsigned char c = ch;
+        if (!json && c == '"') {
+            out += "\"\"";
+        } else if (json && (c == '"' || c == '\\')) {
+            out += '\\';
+            out += ch;
+        } else if (json && c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += ch;
+        }
+    }
+    out += '"';
+}
+
+void write(
+    const Options &o,
+    const Chunk &c,
+    std::vector<std::size_t> &errors,
+    std::string &out
+)
+{
+    out.clear();
+    for (std::size_t row = 0; row < c.lines.size(); ++row) {
+        out += o.ndjson ? "[" : "";
+        for (std::size_t e = 0; e < c.results.size(); ++e) {
+            if (e) {
+                out += o.ndjson ? ", " : ",";
+            }
+            const ResultColumn &r = c.results[e];
+            if (c.bad[row]) {
+                out += o.ndjson ? "null" : "";
+                continue;
+            }
+            switch (r.type[row]) {
+                case ResultColumn::Type::REAL:
+                case ResultColumn::Type::BOOL:
+                    // JSON has no infinities and no NaN
+                    if (o.ndjson && !std::isfinite(r.real[row])) {
+                        out += "null";
+                    } else if (std::isnan(r.real[row])) {
+                        // whatever its sign
+                        out += "nan";
+                    } else {
+                        number(r.real[row], out);
+                    }
+                    break;
+                case ResultColumn::Type::STRING:
+                    quote(r.str[row], o.ndjson, out);
+                    break;
+                default:
+                    ++errors[e];
+                    out += o.ndjson ? "null" : "";
+                    break;
+            }
+        }
+        out += o.ndjson ? "]\n" : "\n";
+    }
+}
+
+} // namespace rows
@@ -0,0 +1,189 @@
+#ifndef HEADER_3A8E96D6796A4ACF8E99D8F9429CBEC5
+#define HEADER_3A8E96D6796A4ACF8E99D8F9429CBEC5
+
+#include "interface.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief the stages of the stream tool between reading lines and writing
+/// them: parsing CSV or NDJSON rows into columns, evaluating and
+/// formatting the results
+namespace rows {
+
+enum Kind : unsigned char { MISSING, REAL, BOOL, STRING, MIXED };
+
+/// @brief the values of one symbol in the rows of a chunk
+struct Cells
+{
+    void resize(std::size_t rows)
+    {
+        kind.assign(rows, MISSING);
+        real.assign(rows, 0);
+        boolean.reset(new bool[rows]());
+        str.assign(rows, Span());
+    }
+    /// @brief the kind of every row, MIXED if they differ
+    Kind uniform() const
+    {
+        for (const auto k : kind) {
+            if (k != kind.front()) {
+                return MIXED;
+            }
+        }
+        return kind.empty() ? MISSING : static_cast<Kind>(kind.front());
+    }
+    Column column() const
+    {
+        switch (uniform()) {
+            case REAL:
+                return Column(real.data());
+            case BOOL:
+                return Column(boolean.get());
+            case STRING:
+                return Column(str.data());
+            default:
+                return Column();
+        }
+    }
+    std::vector<unsigned char> kind;
+    std::vector<double> real;
+    std::unique_ptr<bool[]> boolean;
+    std::vector<Span> str;
+};
+
+/// @brief rows passing through the stages, the spans of the cells point
+/// into lines or decoded
+struct Chunk
+{
+    std::vector<std::string> lines;
+    std::deque<std::string> decoded;
+    std::vector<Cells> cells;     ///< one per symbol
+    std::vector<bool> bad;        ///< rows that did not parse
+    std::vector<ResultColumn> results;
+};
+
+typedef std::unique_ptr<Chunk> ChunkPtr;
+
+struct Options
+{
+    bool ndjson = false;
+    bool shortCircuit = false;
+    std::size_t chunk = 4096;
+    std::size_t queue = 4;
+    std::string input;
+    std::vector<std::string> expressions;
+};
+
+/// @brief the symbols of all expressions and where the input has them
+struct Layout
+{
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, std::size_t> index;
+    std::vector<std::size_t> csv;  ///< symbol of each CSV column or NONE
+    static const std::size_t NONE = static_cast<std::size_t>(-1);
+};
+
+/// @brief one field of a CSV line, quoted fields are strings
+struct Field
+{
+    Span text;
+    bool quoted;
+};
+
+/// @brief splits a CSV line into fields, those with "" are copied to
+/// decoded without them
+void csv(
+    const std::string &line,
+    std::vector<Field> &fields,
+    std::deque<std::string> &decoded
+);
+
+/// @brief whether a CSV line ends within a quoted field, which then goes
+/// on in the next line
+bool openQuote(const std::string &line);
+
+/// @brief the cell of row from a CSV field, unquoted fields are numbers
+/// if readNumber() takes the whole of them
+void set(Cells &c, std::size_t row, const Field &f);
+
+/// @brief reads the parts of one flat JSON object
+class Json
+{
+public:
+    Json(const std::string &line, std::deque<std::string> &decoded)
+        : p_(line.data()), end_(line.data() + line.size()), decoded_(decoded)
+    {
+    }
+    /// @brief calls f(key, kind, str, real) for every member of the object
+    template <class F>
+    bool object(F f)
+    {
+        if (!take('{')) {
+            return false;
+        }
+        if (take('}')) {
+            return atEnd();
+        }
+        do {
+            Span key;
+            Field value = {Span(), false};
+            Kind kind;
+            double real = 0;
+            if (!string(key) || !take(':') || !scalar(kind, value, real)) {
+                return false;
+            }
+            f(key, kind, value.text, real);
+        } while (take(','));
+        return take('}') && atEnd();
+    }
+private:
+    void ws();
+    bool take(char c);
+    bool atEnd();
+    bool literal(const char *s);
+    static void utf8(unsigned long c, std::string &out);
+    bool string(Span &s);
+    bool skip();
+    bool scalar(Kind &kind, Field &value, double &real);
+    const char *p_;
+    const char *end_;
+    std::deque<std::string> &decoded_;
+};
+
+/// @brief the cells of the lines of c
+void parse(const Options &o, const Layout &layout, Chunk &c);
+
+/// @brief the results of c, a column per symbol where its kind is the same
+/// in every row, else the rows are split by the kinds of the symbols of an
+/// expression
+/// @param slots the symbols of the slots of each expression
+void eval(
+    const std::vector<Expression> &expressions,
+    const std::vector<std::vector<std::size_t> > &slots,
+    const Layout &layout,
+    Chunk &c
+);
+
+void number(double v, std::string &out);
+
+/// @brief s as a CSV field or a JSON string
+void quote(const std::string &s, bool json, std::string &out);
+
+/// @brief the lines of the results of c to out, counting the errors of
+/// each expression in errors, a bad row gives a line of empty results
+/// that are no errors
+void write(
+    const Options &o,
+    const Chunk &c,
+    std::vector<std::size_t> &errors,
+    std::string &out
+);
+
+} // namespace rows
+
+#endif
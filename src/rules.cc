@@ -0,0 +1,369 @@
+#include "rules.h"
+#include "expression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+typedef std::uint32_t Index;
+
+// symbol == literal, numbers and booleans are kept in num
+struct Key
+{
+    Atom symbol;
+    Ast::T t;
+    double num;
+    Atom str;
+    bool operator==(const Key &k) const
+    {
+        return symbol == k.symbol && t == k.t && num == k.num
+            && str == k.str;
+    }
+};
+
+struct KeyHash
+{
+    std::size_t operator()(const Key &k) const
+    {
+        std::size_t h = std::hash<double>()(k.num);
+        h = h * 31 + k.symbol.id();
+        h = h * 31 + k.str.id();
+        return h * 31 + static_cast<std::size_t>(k.t);
+    }
+};
+
+// the literals a symbol is compared with, by the operator with the symbol
+// on its left
+struct Bounds
+{
+    std::multimap<double, Index> gt, ge, lt, le;
+};
+
+struct Rule
+{
+    Program program;
+    std::vector<Atom> slots;
+    // the indexed comparisons and symbols to be satisfied by an event
+    Index need;
+};
+
+// the satisfied needs per rule and the arguments of one evaluation, every
+// thread reuses its own buffers
+struct Scratch
+{
+    std::vector<Index> count;
+    std::vector<Index> touched;
+    std::vector<Value> args;
+    /// 1 + the position of each atom in the values of the event, 0 for
+    /// atoms it has none of
+    std::vector<std::size_t> value;
+};
+
+Scratch &scratch()
+{
+    static thread_local Scratch s;
+    return s;
+}
+
+bool literal(const Ast &a)
+{
+    return a.t == Ast::T::NUMBER || a.t == Ast::T::STRING
+        || a.t == Ast::T::BOOLEAN;
+}
+
+// the operator giving the same as l op r for r op l
+Ast::O mirror(Ast::O op)
+{
+    switch (op) {
+        case Ast::O::CMP_GT:
+            return Ast::O::CMP_LT;
+        case Ast::O::CMP_GE:
+            return Ast::O::CMP_LE;
+        case Ast::O::CMP_LT:
+            return Ast::O::CMP_GT;
+        case Ast::O::CMP_LE:
+            return Ast::O::CMP_GE;
+        default:
+            return op;
+    }
+}
+
+// the operands of the && chain at p, each has to give true for p to
+void conjuncts(const Ast *p, std::vector<const Ast *> &out)
+{
+    if (p->t == Ast::T::OPERATOR && p->op == Ast::O::LOGICAL_AND) {
+        conjuncts(p->left.get(), out);
+        conjuncts(p->right.get(), out);
+    } else {
+        out.push_back(p);
+    }
+}
+
+// the symbols short circuit evaluation of p reads in any case, p giving
+// true if hold is set
+void reads(const Ast *p, bool hold, std::vector<Atom> &out)
+{
+    if (!p) {
+        return;
+    }
+    if (p->t == Ast::T::SYMBOL) {
+        out.push_back(p->str);
+    }
+    if (p->t != Ast::T::OPERATOR) {
+        return;
+    }
+    switch (p->op) {
+        case Ast::O::LOGICAL_AND:
+            reads(p->left.get(), hold, out);
+            if (hold) {
+                reads(p->right.get(), hold, out);
+            }
+            break;
+        case Ast::O::LOGICAL_OR:
+            reads(p->left.get(), false, out);
+            break;
+        default:
+            reads(p->left.get(), false, out);
+            reads(p->right.get(), false, out);
+    }
+}
+
+// false if no literal equals v
+bool key(Atom symbol, const Value &v, Key &k)
+{
+    k.symbol = symbol;
+    k.t = v.t();
+    k.num = 0;
+    k.str = Atom();
+    switch (v.t()) {
+        case Ast::T::NUMBER:
+            // -0 == 0
+            k.num = v.num() == 0 ? 0 : v.num();
+            return true;
+        case Ast::T::BOOLEAN:
+            k.num = v.b();
+            return true;
+        case Ast::T::STRING:
+            return Atom::find(v.span(), k.str);
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+struct RuleSetImpl
+{
+    std::vector<Rule> rules;
+    // the rules that cannot give true without the symbol
+    std::unordered_map<Atom, std::vector<Index>, Atom::Hash> readers;
+    std::unordered_map<Key, std::vector<Index>, KeyHash> equal;
+    std::unordered_map<Atom, Bounds, Atom::Hash> bounds;
+    // the rules without anything to check before evaluating them
+    std::vector<Index> always;
+};
+
+RuleSet::RuleSet()
+    : impl_(new RuleSetImpl())
+{
+}
+
+RuleSet::~RuleSet()
+{
+}
+
+RuleSet::Id RuleSet::add(const Expression &e)
+{
+    RuleSetImpl &impl = *impl_;
+    const Index id = impl.rules.size();
+    impl.rules.push_back(Rule());
+    const ExpressionImpl &source = *e.impl_;
+    if (!source.ast_) {
+        // never evaluated, never matches
+        impl.rules.back().need = 1;
+        return id;
+    }
+    Rule &rule = impl.rules.back();
+    rule.program = source.program_;
+    rule.slots = source.slots_;
+    rule.need = 0;
+    Ast::Ptr copy;
+    std::size_t removed = 0;
+    const Ast *root = tree(source, copy, removed).get();
+
+    std::vector<Atom> symbols;
+    if (source.mode_ == EvalMode::STRICT) {
+        symbols = source.slots_;
+    } else {
+        reads(root, true, symbols);
+        std::sort(symbols.begin(), symbols.end(), [](Atom a, Atom b) {
+            return a.id() < b.id();
+        });
+        symbols.erase(std::unique(symbols.begin(), symbols.end()),
+            symbols.end());
+    }
+    for (const Atom s : symbols) {
+        impl.readers[s].push_back(id);
+        ++rule.need;
+    }
+
+    std::vector<const Ast *> all;
+    conjuncts(root, all);
+    for (const Ast *c : all) {
+        if (c->t != Ast::T::OPERATOR || !c->left || !c->right) {
+            continue;
+        }
+        const Ast *symbol = c->left.get();
+        const Ast *value = c->right.get();
+        Ast::O op = c->op;
+        if (value->t == Ast::T::SYMBOL) {
+            std::swap(symbol, value);
+            op = mirror(op);
+        }
+        if (symbol->t != Ast::T::SYMBOL || !literal(*value)) {
+            continue;
+        }
+        std::multimap<double, Index> *bound = nullptr;
+        switch (op) {
+            case Ast::O::CMP_EQ: {
+                    Key k;
+                    key(symbol->str, Value::fromAst(*value), k);
+                    impl.equal[k].push_back(id);
+                    ++rule.need;
+                }
+                continue;
+            case Ast::O::CMP_GT:
+                bound = &impl.bounds[symbol->str].gt;
+                break;
+            case Ast::O::CMP_GE:
+                bound = &impl.bounds[symbol->str].ge;
+                break;
+            case Ast::O::CMP_LT:
+                bound = &impl.bounds[symbol->str].lt;
+                break;
+            case Ast::O::CMP_LE:
+                bound = &impl.bounds[symbol->str].le;
+                break;
+            default:
+                continue;
+        }
+        // strings are compared too, only numbers are indexed
+        if (value->t == Ast::T::NUMBER) {
+            bound->insert(std::make_pair(value->num, id));
+            ++rule.need;
+        }
+    }
+    if (!rule.need) {
+        impl.always.push_back(id);
+    }
+    return id;
+}
+
+std::size_t RuleSet::size() const
+{
+    return impl_->rules.size();
+}
+
+std::size_t RuleSet::match(
+    const Expression::Dict &event,
+    std::vector<Id> &matched
+) const
+{
+    const RuleSetImpl &impl = *impl_;
+    matched.clear();
+    std::vector<std::pair<Atom, Value> > values;
+    values.reserve(event.size());
+    for (const auto &i : event) {
+        Value v;
+        if (!toValue(*i.second, v)) {
+            return 0;
+        }
+        // no rule reads a symbol never interned
+        Atom a;
+        if (Atom::find(Span(i.first), a)) {
+            values.emplace_back(a, std::move(v));
+        }
+    }
+
+    Scratch &s = scratch();
+    s.count.resize(std::max(s.count.size(), impl.rules.size()), 0);
+    s.touched.clear();
+    const auto hit = [&s](Index r) {
+        if (!s.count[r]++) {
+            s.touched.push_back(r);
+        }
+    };
+    const auto hitAll = [&hit](
+        std::multimap<double, Index>::const_iterator b,
+        std::multimap<double, Index>::const_iterator e
+    ) {
+        for (; b != e; ++b) {
+            hit(b->second);
+        }
+    };
+    for (const auto &sv : values) {
+        const auto r = impl.readers.find(sv.first);
+        if (r != impl.readers.end()) {
+            for (const Index id : r->second) {
+                hit(id);
+            }
+        }
+        Key k;
+        const auto eq = key(sv.first, sv.second, k)
+            ? impl.equal.find(k) : impl.equal.end();
+        if (eq != impl.equal.end()) {
+            for (const Index id : eq->second) {
+                hit(id);
+            }
+        }
+        const auto b = impl.bounds.find(sv.first);
+        if (b == impl.bounds.end() || sv.second.t() != Ast::T::NUMBER
+            || std::isnan(sv.second.num())) {
+            continue;
+        }
+        const double v = sv.second.num();
+        hitAll(b->second.gt.begin(), b->second.gt.lower_bound(v));
+        hitAll(b->second.ge.begin(), b->second.ge.upper_bound(v));
+        hitAll(b->second.lt.upper_bound(v), b->second.lt.end());
+        hitAll(b->second.le.lower_bound(v), b->second.le.end());
+    }
+
+    std::vector<Index> candidates(impl.always);
+    for (const Index id : s.touched) {
+        if (s.count[id] == impl.rules[id].need) {
+            candidates.push_back(id);
+        }
+        s.count[id] = 0;
+    }
+    std::sort(candidates.begin(), candidates.end());
+    // a slot is bound with one lookup by the id of its atom
+    s.value.resize(std::max(s.value.size(), Atom::count()), 0);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        s.value[values[i].first.id()] = i + 1;
+    }
+    std::string msg;
+    for (const Index id : candidates) {
+        const Rule &rule = impl.rules[id];
+        s.args.assign(rule.slots.size(), Value());
+        for (std::size_t i = 0; i < rule.slots.size(); ++i) {
+            const std::size_t at = rule.slots[i].id() < s.value.size()
+                ? s.value[rule.slots[i].id()] : 0;
+            if (at) {
+                s.args[i] = values[at - 1].second;
+            }
+        }
+        const Value r = run(rule.program, s.args.data(), msg);
+        if (r.t() == Ast::T::BOOLEAN && r.b()) {
+            matched.push_back(id);
+        }
+    }
+    for (const auto &sv : values) {
+        s.value[sv.first.id()] = 0;
+    }
+    return candidates.size();
+}
@@ -0,0 +1,41 @@
+#ifndef ARIADNE_PARSER_RULES_H
+#define ARIADNE_PARSER_RULES_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "interface.h"
+
+struct RuleSetImpl;
+/// @brief finds the Expressions giving true for one set of parameters
+/// without evaluating most of the others
+/// @note every comparison of a symbol with a literal a rule needs to be
+/// true is indexed, == in hash tables, <, <=, > and >= on numbers in
+/// sorted bounds. Only the rules whose indexed comparisons all hold and
+/// whose event has every symbol they must read are evaluated. A rule
+/// works on its expression and mode at the time of add(). match() may
+/// run concurrently, add() may not.
+class DLL_EXPORT RuleSet {
+public:
+    typedef std::size_t Id;
+    RuleSet();
+    ~RuleSet();
+    RuleSet(const RuleSet &) = delete;
+    RuleSet &operator=(const RuleSet &) = delete;
+    /// @return the id of e, ids count from 0 in the order of add()
+    Id add(const Expression &e);
+    std::size_t size() const;
+    /// @brief the ids of the rules giving true for event, ascending
+    /// @return the number of rules evaluated to find them
+    /// @note a parameter of a type Expressions do not support fails every
+    /// eval(), so no rule matches then
+    std::size_t match(
+        const Expression::Dict &event,
+        std::vector<Id> &matched
+    ) const;
+private:
+    std::unique_ptr<RuleSetImpl> impl_;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "serial.h"
+
+#include <cstring>
+
+namespace serial {
+
+namespace {
+
+const char MAGIC[] = {'A', 'E', 'X', 'B'};
+
+enum Tag : unsigned char {
+    NONE, NUMBER, TRUE, FALSE, STRING, SYMBOL, OPERATOR
+};
+
+void varint(std::uint64_t v, std::string &out)
+{
+    while (v >= 0x80) {
+        out += static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+void string(const std::string &s, std::string &out)
+{
+    varint(s.size(), out);
+    out += s;
+}
+
+} // namespace
+
+void Writer::varint(std::uint64_t v)
+{
+    serial::varint(v, body_);
+}
+
+void Writer::number(double v)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+        byte(static_cast<unsigned char>(bits >> (8 * i)));
+    }
+}
+
+void Writer::string(const std::string &s)
+{
+    serial::string(s, body_);
+}
+
+void Writer::atom(Atom a)
+{
+    const auto i = index_.emplace(a, atoms_.size());
+    if (i.second) {
+        atoms_.push_back(a);
+    }
+    varint(i.first->second);
+}
+
+bool Writer::tree(const Ast::Ptr &p, unsigned depth)
+{
+    // the same limit as Reader::tree(), counting missing operands too
+    if (depth >= MAX_DEPTH) {
+        return false;
+    }
+    if (!p) {
+        byte(NONE);
+        return true;
+    }
+    switch (p->t) {
+        case Ast::T::NUMBER:
+            byte(NUMBER);
+            number(p->num);
+            return true;
+        case Ast::T::BOOLEAN:
+            byte(p->b ? TRUE : FALSE);
+            return true;
+        case Ast::T::STRING:
+            byte(STRING);
+            atom(p->str);
+            return true;
+        case Ast::T::SYMBOL:
+            byte(SYMBOL);
+            atom(p->str);
+            return true;
+        case Ast::T::OPERATOR:
+            byte(OPERATOR);
+            byte(static_cast<unsigned char>(p->op));
+            return tree(p->left, depth + 1) && tree(p->right, depth + 1);
+        default:
+            byte(NONE);
+            return true;
+    }
+}
+
+std::string Writer::finish() const
+{
+    std::string out(MAGIC, sizeof(MAGIC));
+    out += static_cast<char>(VERSION & 0xff);
+    out += static_cast<char>(VERSION >> 8);
+    serial::varint(atoms_.size(), out);
+    for (const Atom a : atoms_) {
+        serial::string(a.str(), out);
+    }
+    return out + body_;
+}
+
+bool Reader::header()
+{
+    if (static_cast<std::size_t>(end_ - p_) < sizeof(MAGIC) + 2
+        || std::memcmp(p_, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    p_ += sizeof(MAGIC);
+    unsigned char lo, hi;
+    byte(lo);
+    byte(hi);
+    if ((lo | hi << 8) != VERSION) {
+        return false;
+    }
+    std::uint64_t n;
+    if (!varint(n) || n > static_cast<std::size_t>(end_ - p_)) {
+        return false;
+    }
+    atoms_.clear();
+    atoms_.reserve(n);
+    for (std::uint64_t i = 0; i < n; ++i) {
+        std::uint64_t size;
+        if (!varint(size) || size > static_cast<std::size_t>(end_ - p_)) {
+            return false;
+        }
+        atoms_.push_back(Atom(Span(p_, size)));
+        p_ += size;
+    }
+    return true;
+}
+
+bool Reader::byte(unsigned char &c)
+{
+    if (p_ == end_) {
+        return false;
+    }
+    c = static_cast<unsigned char>(*p_++);
+    return true;
+}
+
+bool Reader::varint(std::uint64_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        unsigned char c;
+        if (!byte(c)) {
+            return false;
+        }
+        v |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Reader::number(double &v)
+{
+    if (end_ - p_ < 8) {
+        return false;
+    }
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+        bits |= static_cast<std::uint64_t>(
+            static_cast<unsigned char>(p_[i])) << (8 * i);
+    }
+    p_ += 8;
+    std::memcpy(&v, &bits, sizeof(v));
+    return true;
+}
+
+bool Reader::string(std::string &s)
+{
+    std::uint64_t n;
+    if (!varint(n) || n > static_cast<std::size_t>(end_ - p_)) {
+        return false;
+    }
+    s.assign(p_, n);
+    p_ += n;
+    return true;
+}
+
+bool Reader::atom(Atom &a)
+{
+    std::uint64_t i;
+    if (!varint(i) || i >= atoms_.size()) {
+        return false;
+    }
+    a = atoms_[i];
+    return true;
+}
+
+bool Reader::tree(Ast::Ptr &p, unsigned depth)
+{
+    unsigned char tag;
+    if (depth >= MAX_DEPTH || !byte(tag)) {
+        return false;
+    }
+    switch (tag) {
+        case NONE:
+            p.reset();
+            return true;
+        case NUMBER: {
+            double v;
+            if (!number(v)) {
+                return false;
+            }
+            p = Ast::make(v);
+            return true;
+        }
+        case TRUE:
+        case FALSE:
+            p = Ast::make(tag == TRUE);
+            return true;
+        case STRING:
+        case SYMBOL: {
+            Atom a;
+            if (!atom(a)) {
+                return false;
+            }
+            p.reset(new Ast(a));
+            p->t = tag == STRING ? Ast::T::STRING : Ast::T::SYMBOL;
+            return true;
+        }
+        case OPERATOR: {
+            unsigned char op;
+            if (!byte(op)
+                || op > static_cast<unsigned char>(Ast::O::CMP_LE)) {
+                return false;
+            }
+            const auto o = static_cast<Ast::O>(op);
+            p = Ast::make(o);
+            if (!tree(p->left, depth + 1) || !tree(p->right, depth + 1)) {
+                return false;
+            }
+            // as the parser makes them: + - ! unary, ! never binary
+            const bool unary = o == Ast::O::PLUS || o == Ast::O::MINUS
+                || o == Ast::O::LOGICAL_NOT;
+            return p->right && (p->left ? o != Ast::O::LOGICAL_NOT : unary);
+        }
+        default:
+            return false;
+    }
+}
+
+} // namespace serial
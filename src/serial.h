@@ -0,0 +1,71 @@
+#ifndef HEADER_8870E99F8B244C0B9CB1A272B74E28EF
+#define HEADER_8870E99F8B244C0B9CB1A272B74E28EF
+
+#include "ast.h"
+#include "intern.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief the binary form of Expression::save()
+/// @note a file is the magic "AEXB", a 16 bit version and the strings of
+/// all atoms, followed by the records. Integers are LEB128 varints,
+/// numbers 8 bytes little endian, atoms the index of their string. A tree
+/// is written in preorder, one tag per node and a NONE tag for a missing
+/// operand.
+namespace serial {
+
+const std::uint16_t VERSION = 1;
+/// @brief the deepest tree a Reader takes and a Writer writes, so that
+/// hostile data cannot exhaust the stack of the Reader or of what builds
+/// on the tree
+const unsigned MAX_DEPTH = 4096;
+
+class Writer
+{
+public:
+    void byte(unsigned char c) { body_ += static_cast<char>(c); }
+    void varint(std::uint64_t v);
+    void number(double v);
+    void string(const std::string &s);
+    void atom(Atom a);
+    /// @return false if p is deeper than a Reader takes, what was written
+    /// is of no use then
+    bool tree(const Ast::Ptr &p) { return tree(p, 0); }
+    /// @brief the header, the atom table and everything written so far
+    std::string finish() const;
+private:
+    bool tree(const Ast::Ptr &p, unsigned depth);
+    std::string body_;
+    std::vector<Atom> atoms_;
+    std::unordered_map<Atom, std::uint32_t, Atom::Hash> index_;
+};
+
+/// @brief reads what a Writer wrote, every call returns false instead of
+/// reading past the end or taking invalid data
+class Reader
+{
+public:
+    Reader(const char *data, std::size_t n) : p_(data), end_(data + n) {}
+    /// @brief checks magic and version and interns the atom table
+    bool header();
+    bool byte(unsigned char &c);
+    bool varint(std::uint64_t &v);
+    bool number(double &v);
+    bool string(std::string &s);
+    bool atom(Atom &a);
+    bool tree(Ast::Ptr &p) { return tree(p, 0); }
+    bool eof() const { return p_ == end_; }
+private:
+    bool tree(Ast::Ptr &p, unsigned depth);
+    const char *p_;
+    const char *end_;
+    std::vector<Atom> atoms_;
+};
+
+} // namespace serial
+
+#endif
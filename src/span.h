@@ -0,0 +1,29 @@
+#ifndef HEADER_7E5E75CF552E4D0C871BAD78923B0901
+#define HEADER_7E5E75CF552E4D0C871BAD78923B0901
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/// @brief non-owning view of a character range, the buffer must outlive it
+/// @note not std::string_view although the build is C++17. Arrays of
+/// Span are the string columns of the public Column, and p and n are used
+/// directly all over the tree, so it stays a plain pointer and length
+/// whose layout does not depend on the standard library
+struct Span
+{
+    Span() : p(nullptr), n(0) {}
+    Span(const char *p, std::size_t n) : p(p), n(n) {}
+    Span(const std::string &s) : p(s.data()), n(s.size()) {}
+    std::string str() const { return std::string(p, n); }
+    bool empty() const { return n == 0; }
+    bool operator==(const Span &o) const
+    {
+        return n == o.n && (n == 0 || std::memcmp(p, o.p, n) == 0);
+    }
+    bool operator!=(const Span &o) const { return !(*this == o); }
+    const char *p;
+    std::size_t n;
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "interface.h"
+#include "rows.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief evaluates expressions over every row of a CSV or NDJSON stream
+/// usage: stream [--ndjson] [--short-circuit] [--chunk rows]
+///     [--queue chunks] [--input file] expression...
+/// @note reading lines, parsing them into columns, evaluating and writing
+/// run as stages on their own threads, passing chunks of rows through
+/// bounded queues. CSV starts with a header naming the columns, a quoted
+/// field is a string and may span lines, an unquoted one a number, true
+/// or false if it is one, an empty one is unbound. NDJSON rows are flat
+/// objects, keys missing or null are unbound. Every row gives a line with
+/// the result of each expression, a CSV field or an element of a JSON
+/// array, left empty or null on errors. A CSV row with other fields than the header
+/// or a line that is no JSON object gives a line of empty results only
+/// and counts as not parsed. Booleans are written as 1 and 0 like eval()
+/// gives them. The rate and how long each stage waited for input or for
+/// room in the next queue go to stderr at the end.
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::duration d)
+{
+    return std::chrono::duration<double>(d).count();
+}
+
+/// @brief the time a stage ran, waited for input and for room to output
+struct Stage
+{
+    explicit Stage(const char *name)
+        : name(name), total(), starved(), blocked()
+    {
+    }
+    const char *name;
+    Clock::duration total;
+    Clock::duration starved;
+    Clock::duration blocked;
+};
+
+/// @brief a queue holding at most capacity items between two stages
+template <class T>
+class Queue
+{
+public:
+    explicit Queue(std::size_t capacity) : capacity_(capacity), closed_(false)
+    {
+    }
+    /// @brief waits for room, adding the time waited to blocked
+    void push(T v, Clock::duration &blocked)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto start = Clock::now();
+        notFull_.wait(lock, [this] { return items_.size() < capacity_; });
+        blocked += Clock::now() - start;
+        items_.push_back(std::move(v));
+        notEmpty_.notify_one();
+    }
+    /// @brief waits for an item, adding the time waited to starved
+    /// @return false once the queue is closed and empty
+    bool pop(T &v, Clock::duration &starved)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto start = Clock::now();
+        notEmpty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        starved += Clock::now() - start;
+        if (items_.empty()) {
+            return false;
+        }
+        v = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+private:
+    std::size_t capacity_;
+    bool closed_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+bool options(int argc, char *argv[], rows::Options &o)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const bool value = i + 1 < argc;
+        if (a == "--ndjson") {
+            o.ndjson = true;
+        } else if (a == "--short-circuit") {
+            o.shortCircuit = true;
+        } else if (a == "--chunk" && value) {
+            o.chunk = std::strtoul(argv[++i], nullptr, 10);
+        } else if (a == "--queue" && value) {
+            o.queue = std::strtoul(argv[++i], nullptr, 10);
+        } else if (a == "--input" && value) {
+            o.input = argv[++i];
+        } else if (a.compare(0, 2, "--") == 0) {
+            return false;
+        } else {
+            o.expressions.push_back(a);
+        }
+    }
+    return !o.expressions.empty() && o.chunk && o.queue;
+}
+
+void report(
+    const rows::Options &o,
+    std::size_t rows,
+    std::size_t bad,
+    Clock::duration elapsed,
+    const std::vector<Stage> &stages,
+    const std::vector<std::size_t> &errors
+)
+{
+    const double s = seconds(elapsed);
+    std::fprintf(stderr, "%zu rows in %.3f s, %.0f rows/s, %zu rows not "
+        "parsed\n", rows, s, s > 0 ? rows / s : 0.0, bad);
+    std::fprintf(stderr, "%-8s %10s %10s %10s\n",
+        "stage", "busy s", "starved s", "blocked s");
+    for (const auto &st : stages) {
+        std::fprintf(stderr, "%-8s %10.3f %10.3f %10.3f\n", st.name,
+            seconds(st.total - st.starved - st.blocked),
+            seconds(st.starved), seconds(st.blocked));
+    }
+    for (std::size_t e = 0; e < errors.size(); ++e) {
+        std::fprintf(stderr, "%zu errors of %s\n", errors[e],
+            o.expressions[e].c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    rows::Options o;
+    if (!options(argc, argv, o)) {
+        std::cerr << "usage: " << argv[0] << " [--ndjson] [--short-circuit]"
+            " [--chunk rows] [--queue chunks] [--input file] expression..."
+            << std::endl;
+        return 1;
+    }
+    std::vector<Expression> expressions;
+    rows::Layout layout;
+    std::set<std::string> symbols;
+    for (const auto &str : o.expressions) {
+        expressions.emplace_back(str);
+        if (!expressions.back()) {
+            std::cerr << "Error: " << str << ": " << expressions.back().msg()
+                << std::endl;
+            return 2;
+        }
+        if (o.shortCircuit) {
+            expressions.back().setMode(Expression::Mode::SHORT_CIRCUIT);
+        }
+        const auto s = expressions.back().symbols();
+        symbols.insert(s.begin(), s.end());
+    }
+    layout.symbols.assign(symbols.begin(), symbols.end());
+    for (std::size_t i = 0; i < layout.symbols.size(); ++i) {
+        layout.index[layout.symbols[i]] = i;
+    }
+    // the symbols of the slots of each expression, resolved once
+    std::vector<std::vector<std::size_t> > slots;
+    for (const auto &e : expressions) {
+        slots.emplace_back();
+        for (const auto &s : e.slots()) {
+            slots.back().push_back(layout.index[s]);
+        }
+    }
+
+    std::ifstream file;
+    if (!o.input.empty()) {
+        file.open(o.input);
+        if (!file) {
+            std::cerr << "Error: cannot open " << o.input << std::endl;
+            return 3;
+        }
+    }
+    std::istream &in = o.input.empty() ? std::cin : file;
+    std::ios::sync_with_stdio(false);
+    // a line, or a CSV row going on while a quoted field is open
+    const auto next = [&in, &o](std::string &line) {
+        if (!std::getline(in, line)) {
+            return false;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::string more;
+        while (!o.ndjson && rows::openQuote(line) && std::getline(in, more)) {
+            if (!more.empty() && more.back() == '\r') {
+                more.pop_back();
+            }
+            line += '\n';
+            line += more;
+        }
+        return true;
+    };
+    std::string line;
+    std::string out;
+    if (!o.ndjson) {
+        next(line);
+        std::vector<rows::Field> fields;
+        std::deque<std::string> decoded;
+        rows::csv(line, fields, decoded);
+        std::set<std::string> found;
+        for (const auto &f : fields) {
+            const auto i = layout.index.find(f.text.str());
+            layout.csv.push_back(
+                i == layout.index.end() ? rows::Layout::NONE : i->second);
+            if (i != layout.index.end()) {
+                found.insert(i->first);
+            }
+        }
+        for (const auto &s : layout.symbols) {
+            if (!found.count(s)) {
+                std::cerr << "Warning: no column for " << s << std::endl;
+            }
+        }
+        for (std::size_t e = 0; e < o.expressions.size(); ++e) {
+            out += e ? "," : "";
+            rows::quote(o.expressions[e], false, out);
+        }
+        out += '\n';
+        std::fwrite(out.data(), 1, out.size(), stdout);
+    }
+
+    std::vector<Stage> stages = {
+        Stage("read"), Stage("parse"), Stage("eval"), Stage("write")
+    };
+    Queue<rows::ChunkPtr> lines(o.queue);
+    Queue<rows::ChunkPtr> parsed(o.queue);
+    Queue<rows::ChunkPtr> evaluated(o.queue);
+    const auto start = Clock::now();
+
+    std::thread reader([&] {
+        Stage &st = stages[0];
+        const auto begin = Clock::now();
+        rows::ChunkPtr c(new rows::Chunk);
+        while (next(line)) {
+            if (line.empty()) {
+                continue;
+            }
+            c->lines.push_back(line);
+            if (c->lines.size() == o.chunk) {
+                lines.push(std::move(c), st.blocked);
+                c.reset(new rows::Chunk);
+            }
+        }
+        if (!c->lines.empty()) {
+            lines.push(std::move(c), st.blocked);
+        }
+        lines.close();
+        st.total = Clock::now() - begin;
+    });
+    std::thread parser([&] {
+        Stage &st = stages[1];
+        const auto begin = Clock::now();
+        rows::ChunkPtr c;
+        while (lines.pop(c, st.starved)) {
+            rows::parse(o, layout, *c);
+            parsed.push(std::move(c), st.blocked);
+        }
+        parsed.close();
+        st.total = Clock::now() - begin;
+    });
+    std::thread evaluator([&] {
+        Stage &st = stages[2];
+        const auto begin = Clock::now();
+        rows::ChunkPtr c;
+        while (parsed.pop(c, st.starved)) {
+            rows::eval(expressions, slots, layout, *c);
+            evaluated.push(std::move(c), st.blocked);
+        }
+        evaluated.close();
+        st.total = Clock::now() - begin;
+    });
+
+    Stage &st = stages[3];
+    std::size_t rows = 0;
+    std::size_t bad = 0;
+    std::vector<std::size_t> errors(expressions.size());
+    rows::ChunkPtr c;
+    const auto begin = Clock::now();
+    while (evaluated.pop(c, st.starved)) {
+        rows::write(o, *c, errors, out);
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        rows += c->lines.size();
+        bad += std::count(c->bad.begin(), c->bad.end(), true);
+    }
+    std::fflush(stdout);
+    st.total = Clock::now() - begin;
+    reader.join();
+    parser.join();
+    evaluator.join();
+    report(o, rows, bad, Clock::now() - start, stages, errors);
+    return std::ferror(stdout) ? 4 : 0;
+}
@@ -0,0 +1,147 @@
+#include "value.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+Value::Value(Span s) : t_(Ast::T::STRING)
+{
+    if (s.n <= SMALL) {
+        small_ = static_cast<std::uint8_t>(s.n);
+        if (s.n) {
+            std::memcpy(buf_, s.p, s.n);
+        }
+    } else {
+        small_ = SHARED;
+        new (&shared_) std::shared_ptr<const std::string>(
+            std::make_shared<const std::string>(s.p, s.n)
+        );
+    }
+}
+
+Value::Value(std::string &&s) : t_(Ast::T::STRING)
+{
+    if (s.size() <= SMALL) {
+        small_ = static_cast<std::uint8_t>(s.size());
+        if (!s.empty()) {
+            std::memcpy(buf_, s.data(), s.size());
+        }
+    } else {
+        small_ = SHARED;
+        new (&shared_) std::shared_ptr<const std::string>(
+            std::make_shared<const std::string>(std::move(s))
+        );
+    }
+}
+
+Value::Value(const Value &v) : t_(Ast::T::UNKNOWN), small_(0)
+{
+    copy(v);
+}
+
+Value::Value(Value &&v) : t_(Ast::T::UNKNOWN), small_(0)
+{
+    move(v);
+}
+
+Value &Value::operator=(const Value &v)
+{
+    if (this != &v) {
+        reset();
+        copy(v);
+    }
+    return *this;
+}
+
+Value &Value::operator=(Value &&v)
+{
+    if (this != &v) {
+        reset();
+        move(v);
+    }
+    return *this;
+}
+
+void Value::reset()
+{
+    if (t_ == Ast::T::STRING && small_ == SHARED) {
+        shared_.~shared_ptr();
+    }
+    t_ = Ast::T::UNKNOWN;
+    small_ = 0;
+}
+
+void Value::copy(const Value &v)
+{
+    t_ = v.t_;
+    small_ = v.small_;
+    if (t_ == Ast::T::STRING && small_ == SHARED) {
+        new (&shared_) std::shared_ptr<const std::string>(v.shared_);
+    } else {
+        std::memcpy(buf_, v.buf_, SMALL);
+    }
+}
+
+void Value::move(Value &v)
+{
+    t_ = v.t_;
+    small_ = v.small_;
+    if (t_ == Ast::T::STRING && small_ == SHARED) {
+        new (&shared_) std::shared_ptr<const std::string>(
+            std::move(v.shared_)
+        );
+        v.reset();
+    } else {
+        std::memcpy(buf_, v.buf_, SMALL);
+    }
+}
+
+const char *Value::data() const
+{
+    return small_ == SHARED ? shared_->data() : buf_;
+}
+
+std::size_t Value::size() const
+{
+    return small_ == SHARED ? shared_->size() : small_;
+}
+
+int Value::compare(const Value &v) const
+{
+    const std::size_t l = size();
+    const std::size_t r = v.size();
+    const int c = l && r ? std::memcmp(data(), v.data(), std::min(l, r)) : 0;
+    if (c) {
+        return c;
+    }
+    return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+Value Value::fromAst(const Ast &a)
+{
+    switch (a.t) {
+        case Ast::T::NUMBER:
+            return Value(a.num);
+        case Ast::T::BOOLEAN:
+            return Value(a.b);
+        case Ast::T::STRING:
+            return Value(Span(a.str));
+        default:
+            return Value();
+    }
+}
+
+Ast::Ptr Value::toAst() const
+{
+    switch (t_) {
+        case Ast::T::NUMBER:
+            return Ast::make(num_);
+        case Ast::T::BOOLEAN:
+            return Ast::make(b_);
+        case Ast::T::STRING:
+            return Ast::makeString(str());
+        default:
+            return nullptr;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef HEADER_03F8E3D2F1494686ABFDE133737EE634
+#define HEADER_03F8E3D2F1494686ABFDE133737EE634
+
+#include "ast.h"
+#include "span.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+/// @brief inline tagged result of an evaluation step
+/// @note numbers, booleans and strings of up to SMALL characters live in
+/// the object itself, longer strings are shared and never copied. A
+/// default constructed value has type UNKNOWN and signals an error.
+class Value
+{
+public:
+    typedef std::map<std::string, Value> Dict;
+    static const std::size_t SMALL = 22;
+    Value() : t_(Ast::T::UNKNOWN), small_(0) {}
+    explicit Value(double v) : t_(Ast::T::NUMBER), small_(0) { num_ = v; }
+    explicit Value(bool b) : t_(Ast::T::BOOLEAN), small_(0) { b_ = b; }
+    explicit Value(Span s);
+    explicit Value(std::string &&s);
+    explicit Value(const std::string &s) : Value(Span(s)) {}
+    Value(const Value &v);
+    Value(Value &&v);
+    Value &operator=(const Value &v);
+    Value &operator=(Value &&v);
+    ~Value() { reset(); }
+    static Value fromAst(const Ast &a);
+    Ast::Ptr toAst() const;
+
+    Ast::T t() const { return t_; }
+    double num() const { return num_; }
+    bool b() const { return b_; }
+    const char *data() const;
+    std::size_t size() const;
+    Span span() const { return Span(data(), size()); }
+    std::string str() const { return span().str(); }
+    int compare(const Value &v) const;
+    explicit operator bool() const { return t_ != Ast::T::UNKNOWN; }
+private:
+    static const std::uint8_t SHARED = 0xFF;
+    Ast::T t_;
+    std::uint8_t small_;
+    union {
+        double num_;
+        bool b_;
+        char buf_[SMALL];
+        std::shared_ptr<const std::string> shared_;
+    };
+    void reset();
+    void copy(const Value &v);
+    void move(Value &v);
+};
+
+Value apply(Ast::O op, const Value &operand, std::string &msg);
+Value apply(Ast::O op, const Value &l, const Value &r, std::string &msg);
+Value evaluate(
+    const Ast::Ptr &root,
+    const Value::Dict &dict,
+    std::string &msg,
+    EvalMode mode = EvalMode::STRICT
+);
+/// @brief gets every node evaluate() computes with the result and the
+/// ns it took, the ones of its operands included
+class Recorder
+{
+public:
+    virtual ~Recorder() {}
+    virtual void record(const Ast &node, std::uint64_t ns, const Value &v)
+        = 0;
+};
+Value evaluate(
+    const Ast::Ptr &root,
+    const Value::Dict &dict,
+    std::string &msg,
+    EvalMode mode,
+    Recorder &recorder
+);
+/// @brief whether l alone decides l && r resp. l || r
+bool decides(Ast::O op, const Value &l);
+
+#endif
@@ -0,0 +1,661 @@
+#include "vm.h"
+#include "arith.h"
+#include "ast.h"
+#include "dag.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Compiler
+{
+    // where a shared node was stored, region is the innermost conditional
+    // part of the code the store was emitted in
+    struct Slot
+    {
+        std::uint32_t index;
+        std::size_t region;
+    };
+    Program &p;
+    const Dag &dag;
+    // the static node types, null if unknown
+    const std::vector<Ast::T> *types;
+    std::map<Atom::Id, std::uint32_t> symbols;
+    std::map<std::uint32_t, std::uint32_t> consts;
+    std::map<std::uint32_t, Slot> slots;
+    std::vector<std::size_t> open;
+    std::size_t regions;
+
+    void emit(Program::Code code, std::uint32_t arg = 0)
+    {
+        Program::Instr i;
+        i.code = code;
+        i.arg = arg;
+        p.code.push_back(i);
+    }
+
+    // a stored slot is filled whenever code of a region still open runs
+    bool dominates(std::size_t region) const
+    {
+        return std::find(open.begin(), open.end(), region) != open.end();
+    }
+
+    std::size_t operand(std::uint32_t id)
+    {
+        const auto &n = dag.nodes[id];
+        if (n.uses < 2 || n.t != Ast::T::OPERATOR) {
+            return node(id);
+        }
+        const auto s = slots.find(id);
+        if (s == slots.end()) {
+            Slot slot;
+            slot.index = p.slots++;
+            slot.region = open.back();
+            slots[id] = slot;
+            const std::size_t depth = node(id);
+            emit(Program::Code::STORE, slot.index);
+            return depth;
+        }
+        if (dominates(s->second.region)) {
+            emit(Program::Code::FETCH, s->second.index);
+            return 1;
+        }
+        // the first evaluation may have been skipped by a jump
+        s->second.region = open.back();
+        const std::size_t at = p.code.size();
+        emit(Program::Code::CACHED);
+        const std::size_t depth = node(id);
+        emit(Program::Code::STORE, s->second.index);
+        p.code[at].arg = p.code.size();
+        return depth;
+    }
+
+    std::size_t node(std::uint32_t id)
+    {
+        const auto &n = dag.nodes[id];
+        switch (n.t) {
+            case Ast::T::BOOLEAN:
+            case Ast::T::NUMBER:
+            case Ast::T::STRING: {
+                const auto r = consts.insert(
+                    std::make_pair(id, p.consts.size())
+                );
+                if (r.second) {
+                    switch (n.t) {
+                        case Ast::T::BOOLEAN:
+                            p.consts.push_back(Value(n.b));
+                            break;
+                        case Ast::T::NUMBER:
+                            p.consts.push_back(Value(n.num));
+                            break;
+                        default:
+                            p.consts.push_back(Value(n.str));
+                            break;
+                    }
+                }
+                emit(Program::Code::CONST, r.first->second);
+                return 1;
+            }
+            case Ast::T::SYMBOL: {
+                const auto r = symbols.insert(
+                    std::make_pair(n.str.id(), p.symbols.size())
+                );
+                if (r.second) {
+                    p.symbols.push_back(n.str);
+                }
+                emit(load(type(id)), r.first->second);
+                return 1;
+            }
+            case Ast::T::OPERATOR:
+                return op(n);
+            default:
+                assert(false /* unreachable */);
+                return 0;
+        }
+    }
+
+    std::size_t shortCircuit(const Dag::Node &n)
+    {
+        const bool isAnd = n.op == Ast::O::LOGICAL_AND;
+        const std::size_t l = operand(n.left);
+        const std::size_t jump = p.code.size();
+        emit(isAnd ? Program::Code::JUMP_FALSE : Program::Code::JUMP_TRUE);
+        open.push_back(++regions);
+        const std::size_t r = operand(n.right) + 1;
+        open.pop_back();
+        if (type(n.left) == Ast::T::BOOLEAN
+            && type(n.right) == Ast::T::BOOLEAN
+        ) {
+            emit(isAnd ? Program::Code::LAND_BOOL : Program::Code::LOR_BOOL);
+        } else {
+            emit(isAnd ? Program::Code::LAND : Program::Code::LOR);
+        }
+        p.code[jump].arg = p.code.size();
+        return l > r ? l : r;
+    }
+
+    std::size_t op(const Dag::Node &n)
+    {
+        if (p.mode == EvalMode::SHORT_CIRCUIT && n.left != Dag::NONE
+            && (n.op == Ast::O::LOGICAL_AND || n.op == Ast::O::LOGICAL_OR)
+        ) {
+            return shortCircuit(n);
+        }
+        const std::size_t r = operand(n.right);
+        if (n.left == Dag::NONE) {
+            const bool number = type(n.right) == Ast::T::NUMBER;
+            switch (n.op) {
+                case Ast::O::PLUS:
+                    // +x is x for a number
+                    if (!number) {
+                        emit(Program::Code::POS);
+                    }
+                    break;
+                case Ast::O::MINUS:
+                    emit(number ? Program::Code::NEG_NUM : Program::Code::NEG);
+                    break;
+                default:
+                    emit(type(n.right) == Ast::T::BOOLEAN
+                        ? Program::Code::NOT_BOOL : Program::Code::NOT);
+                    break;
+            }
+            return r;
+        }
+        const std::size_t l = operand(n.left) + 1;
+        emit(code(n.op, type(n.left), type(n.right)));
+        return l > r ? l : r;
+    }
+
+    Ast::T type(std::uint32_t id) const
+    {
+        return types ? (*types)[id] : Ast::T::UNKNOWN;
+    }
+
+    static Program::Code load(Ast::T t)
+    {
+        switch (t) {
+            case Ast::T::NUMBER:
+                return Program::Code::LOAD_NUM;
+            case Ast::T::STRING:
+                return Program::Code::LOAD_STR;
+            case Ast::T::BOOLEAN:
+                return Program::Code::LOAD_BOOL;
+            default:
+                return Program::Code::LOAD;
+        }
+    }
+
+    // the code for operands of the static types l and r
+    static Program::Code code(Ast::O o, Ast::T l, Ast::T r)
+    {
+        if (l != r) {
+            return code(o);
+        }
+        switch (l) {
+            case Ast::T::NUMBER:
+                switch (o) {
+                    case Ast::O::PLUS:
+                        return Program::Code::ADD_NUM;
+                    case Ast::O::MINUS:
+                        return Program::Code::SUB_NUM;
+                    case Ast::O::MULTIPLY:
+                        return Program::Code::MUL_NUM;
+                    case Ast::O::DIVISION:
+                        return Program::Code::DIV_NUM;
+                    case Ast::O::MODULO:
+                        return Program::Code::MOD_NUM;
+                    case Ast::O::POWER:
+                        return Program::Code::POW_NUM;
+                    case Ast::O::CMP_EQ:
+                        return Program::Code::EQ_NUM;
+                    case Ast::O::CMP_NE:
+                        return Program::Code::NE_NUM;
+                    case Ast::O::CMP_GT:
+                        return Program::Code::GT_NUM;
+                    case Ast::O::CMP_GE:
+                        return Program::Code::GE_NUM;
+                    case Ast::O::CMP_LT:
+                        return Program::Code::LT_NUM;
+                    case Ast::O::CMP_LE:
+                        return Program::Code::LE_NUM;
+                    default:
+                        break;
+                }
+                break;
+            case Ast::T::STRING:
+                switch (o) {
+                    case Ast::O::CMP_EQ:
+                        return Program::Code::EQ_STR;
+                    case Ast::O::CMP_NE:
+                        return Program::Code::NE_STR;
+                    case Ast::O::CMP_GT:
+                        return Program::Code::GT_STR;
+                    case Ast::O::CMP_GE:
+                        return Program::Code::GE_STR;
+                    case Ast::O::CMP_LT:
+                        return Program::Code::LT_STR;
+                    case Ast::O::CMP_LE:
+                        return Program::Code::LE_STR;
+                    default:
+                        break;
+                }
+                break;
+            case Ast::T::BOOLEAN:
+                switch (o) {
+                    case Ast::O::CMP_EQ:
+                        return Program::Code::EQ_BOOL;
+                    case Ast::O::CMP_NE:
+                        return Program::Code::NE_BOOL;
+                    case Ast::O::LOGICAL_AND:
+                        return Program::Code::AND_BOOL;
+                    case Ast::O::LOGICAL_OR:
+                        return Program::Code::OR_BOOL;
+                    default:
+                        break;
+                }
+                break;
+            default:
+                break;
+        }
+        return code(o);
+    }
+
+    static Program::Code code(Ast::O o)
+    {
+        switch (o) {
+            case Ast::O::PLUS:
+                return Program::Code::ADD;
+            case Ast::O::MINUS:
+                return Program::Code::SUB;
+            case Ast::O::MULTIPLY:
+                return Program::Code::MUL;
+            case Ast::O::DIVISION:
+                return Program::Code::DIV;
+            case Ast::O::MODULO:
+                return Program::Code::MOD;
+            case Ast::O::POWER:
+                return Program::Code::POW;
+            case Ast::O::LOGICAL_AND:
+                return Program::Code::AND;
+            case Ast::O::LOGICAL_OR:
+                return Program::Code::OR;
+            case Ast::O::CMP_EQ:
+                return Program::Code::EQ;
+            case Ast::O::CMP_NE:
+                return Program::Code::NE;
+            case Ast::O::CMP_GT:
+                return Program::Code::GT;
+            case Ast::O::CMP_GE:
+                return Program::Code::GE;
+            case Ast::O::CMP_LT:
+                return Program::Code::LT;
+            default:
+                return Program::Code::LE;
+        }
+    }
+};
+
+} // namespace
+
+static Program compile(
+    const Dag &dag,
+    const std::vector<Ast::T> *types,
+    EvalMode mode
+)
+{
+    Program p;
+    p.depth = 0;
+    p.slots = 0;
+    p.mode = mode;
+    if (!dag.nodes.empty()) {
+        Compiler c = {p, dag, types, {}, {}, {}, {0}, 0};
+        p.depth = c.operand(dag.root());
+    }
+    return p;
+}
+
+Program compile(const Dag &dag, EvalMode mode)
+{
+    return compile(dag, nullptr, mode);
+}
+
+Program compile(const Ast::Ptr &root, EvalMode mode)
+{
+    return compile(share(root), mode);
+}
+
+Program compile(
+    const Dag &dag,
+    const std::vector<Ast::T> &types,
+    EvalMode mode
+)
+{
+    assert(types.size() == dag.nodes.size());
+    return compile(dag, &types, mode);
+}
+
+Program::Code untyped(Program::Code c)
+{
+    switch (c) {
+        case Program::Code::LOAD_NUM:
+        case Program::Code::LOAD_STR:
+        case Program::Code::LOAD_BOOL:
+            return Program::Code::LOAD;
+        case Program::Code::NEG_NUM:
+            return Program::Code::NEG;
+        case Program::Code::NOT_BOOL:
+            return Program::Code::NOT;
+        case Program::Code::ADD_NUM:
+            return Program::Code::ADD;
+        case Program::Code::SUB_NUM:
+            return Program::Code::SUB;
+        case Program::Code::MUL_NUM:
+            return Program::Code::MUL;
+        case Program::Code::DIV_NUM:
+            return Program::Code::DIV;
+        case Program::Code::MOD_NUM:
+            return Program::Code::MOD;
+        case Program::Code::POW_NUM:
+            return Program::Code::POW;
+        case Program::Code::EQ_NUM:
+        case Program::Code::EQ_STR:
+        case Program::Code::EQ_BOOL:
+            return Program::Code::EQ;
+        case Program::Code::NE_NUM:
+        case Program::Code::NE_STR:
+        case Program::Code::NE_BOOL:
+            return Program::Code::NE;
+        case Program::Code::GT_NUM:
+        case Program::Code::GT_STR:
+            return Program::Code::GT;
+        case Program::Code::GE_NUM:
+        case Program::Code::GE_STR:
+            return Program::Code::GE;
+        case Program::Code::LT_NUM:
+        case Program::Code::LT_STR:
+            return Program::Code::LT;
+        case Program::Code::LE_NUM:
+        case Program::Code::LE_STR:
+            return Program::Code::LE;
+        case Program::Code::AND_BOOL:
+            return Program::Code::AND;
+        case Program::Code::OR_BOOL:
+            return Program::Code::OR;
+        case Program::Code::LAND_BOOL:
+            return Program::Code::LAND;
+        case Program::Code::LOR_BOOL:
+            return Program::Code::LOR;
+        default:
+            return c;
+    }
+}
+
+void bindSlots(Program &p, const std::vector<Atom> &slots)
+{
+    std::vector<std::uint32_t> index(p.symbols.size());
+    for (std::size_t i = 0; i < p.symbols.size(); ++i) {
+        const auto s = std::find(slots.begin(), slots.end(), p.symbols[i]);
+        assert(s != slots.end());
+        index[i] = static_cast<std::uint32_t>(s - slots.begin());
+    }
+    for (auto &i : p.code) {
+        if (untyped(i.code) == Program::Code::LOAD) {
+            i.arg = index[i.arg];
+        }
+    }
+    p.symbols = slots;
+}
+
+void bindSlots(Program &p, const std::vector<std::string> &slots)
+{
+    std::vector<Atom> atoms;
+    for (const auto &s : slots) {
+        atoms.push_back(Atom(s));
+    }
+    bindSlots(p, atoms);
+}
+
+// the stack holds the left operand on top of the right one
+#define UNARY(C, O) \
+    case Program::Code::C:\
+        sp[-1] = apply(O, sp[-1], msg);\
+        if (!sp[-1]) {\
+            return Value();\
+        }\
+        break;
+#define BINARY(C, O) \
+    case Program::Code::C:\
+        --sp;\
+        sp[-1] = apply(O, sp[0], sp[-1], msg);\
+        if (!sp[-1]) {\
+            return Value();\
+        }\
+        break;
+#define JUMP(C, O) \
+    case Program::Code::C:\
+        if (decides(O, sp[-1])) {\
+            i = begin + i->arg - 1;\
+        }\
+        break;
+#define COMBINE(C, O) \
+    case Program::Code::C:\
+        --sp;\
+        sp[-1] = apply(O, sp[-1], sp[0], msg);\
+        if (!sp[-1]) {\
+            return Value();\
+        }\
+        break;
+
+// the operands have the types the compiler found, only the results of
+// DIV_NUM and MOD_NUM are left to check
+#define NUMBERS(C, X) \
+    case Program::Code::C:\
+        --sp;\
+        sp[-1] = Value(sp[0].num() X sp[-1].num());\
+        break;
+#define STRINGS(C, X) \
+    case Program::Code::C:\
+        --sp;\
+        sp[-1] = Value(sp[0].compare(sp[-1]) X 0);\
+        break;
+#define BOOLEANS(C, X) \
+    case Program::Code::C:\
+        --sp;\
+        sp[-1] = Value(sp[0].b() X sp[-1].b());\
+        break;
+#define LOAD_AS(C, T) \
+    case Program::Code::C:\
+        if (!loadable(args[i->arg], T, p.symbols[i->arg], msg)) {\
+            return Value();\
+        }\
+        *sp++ = args[i->arg];\
+        break;
+
+bool evaluates(Program::Code c, Ast::O &op)
+{
+    static const Ast::O ops[] = {
+        Ast::O::PLUS, Ast::O::MINUS, Ast::O::LOGICAL_NOT,
+        Ast::O::PLUS, Ast::O::MINUS, Ast::O::MULTIPLY, Ast::O::DIVISION,
+        Ast::O::MODULO, Ast::O::POWER,
+        Ast::O::LOGICAL_AND, Ast::O::LOGICAL_OR,
+        Ast::O::CMP_EQ, Ast::O::CMP_NE, Ast::O::CMP_GT, Ast::O::CMP_GE,
+        Ast::O::CMP_LT, Ast::O::CMP_LE,
+    };
+    c = untyped(c);
+    if (c >= Program::Code::POS && c <= Program::Code::LE) {
+        op = ops[static_cast<int>(c) - static_cast<int>(Program::Code::POS)];
+        return true;
+    }
+    if (c == Program::Code::LAND || c == Program::Code::LOR) {
+        op = c == Program::Code::LAND
+            ? Ast::O::LOGICAL_AND : Ast::O::LOGICAL_OR;
+        return true;
+    }
+    return false;
+}
+
+std::string mistyped(Atom symbol, Ast::T t)
+{
+    INSTRUMENT_COUNT(TYPE_ERRORS);
+    std::string msg = "symbol ";
+    msg += symbol;
+    msg += t == Ast::T::NUMBER ? " is not a number"
+        : t == Ast::T::STRING ? " is not a string" : " is not a boolean";
+    return msg;
+}
+
+static bool loadable(const Value &v, Ast::T t, Atom symbol, std::string &msg)
+{
+    if (!v) {
+        msg = "unsolvable symbol ";
+        msg += symbol;
+        return false;
+    }
+    if (v.t() != t) {
+        msg = mistyped(symbol, t);
+        return false;
+    }
+    return true;
+}
+
+Value run(const Program &p, const Value::Dict &dict, std::string &msg)
+{
+    std::vector<Value> args(p.symbols.size());
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const auto v = dict.find(p.symbols[i]);
+        if (v != dict.cend()) {
+            args[i] = v->second;
+        }
+    }
+    return run(p, args.data(), msg);
+}
+
+Value run(const Program &p, const Value *args, std::string &msg)
+{
+    if (p.code.empty()) {
+        return Value();
+    }
+    // operand stack followed by the slots of shared nodes
+    Value local[16];
+    std::vector<Value> heap;
+    Value *stack = local;
+    if (p.depth + p.slots > sizeof(local) / sizeof(local[0])) {
+        heap.resize(p.depth + p.slots);
+        stack = heap.data();
+    }
+    Value *const slots = stack + p.depth;
+    Value *sp = stack;
+    const Program::Instr *begin = p.code.data();
+    const Program::Instr *end = begin + p.code.size();
+    for (const Program::Instr *i = begin; i < end; ++i) {
+        INSTRUMENT_CODE(i->code, 1);
+        switch (i->code) {
+            case Program::Code::CONST:
+                *sp++ = p.consts[i->arg];
+                break;
+            case Program::Code::LOAD:
+                if (!args[i->arg]) {
+                    msg = "unsolvable symbol ";
+                    msg += p.symbols[i->arg];
+                    return Value();
+                }
+                *sp++ = args[i->arg];
+                break;
+            case Program::Code::STORE:
+                slots[i->arg] = sp[-1];
+                break;
+            case Program::Code::FETCH:
+                *sp++ = slots[i->arg];
+                break;
+            case Program::Code::CACHED: {
+                const Program::Instr *store = begin + i->arg - 1;
+                if (slots[store->arg]) {
+                    *sp++ = slots[store->arg];
+                    i = store;
+                }
+                break;
+            }
+            UNARY(POS, Ast::O::PLUS)
+            UNARY(NEG, Ast::O::MINUS)
+            UNARY(NOT, Ast::O::LOGICAL_NOT)
+            BINARY(ADD, Ast::O::PLUS)
+            BINARY(SUB, Ast::O::MINUS)
+            BINARY(MUL, Ast::O::MULTIPLY)
+            BINARY(DIV, Ast::O::DIVISION)
+            BINARY(MOD, Ast::O::MODULO)
+            BINARY(POW, Ast::O::POWER)
+            BINARY(AND, Ast::O::LOGICAL_AND)
+            BINARY(OR, Ast::O::LOGICAL_OR)
+            BINARY(EQ, Ast::O::CMP_EQ)
+            BINARY(NE, Ast::O::CMP_NE)
+            BINARY(GT, Ast::O::CMP_GT)
+            BINARY(GE, Ast::O::CMP_GE)
+            BINARY(LT, Ast::O::CMP_LT)
+            BINARY(LE, Ast::O::CMP_LE)
+            JUMP(JUMP_FALSE, Ast::O::LOGICAL_AND)
+            JUMP(JUMP_TRUE, Ast::O::LOGICAL_OR)
+            COMBINE(LAND, Ast::O::LOGICAL_AND)
+            COMBINE(LOR, Ast::O::LOGICAL_OR)
+            LOAD_AS(LOAD_NUM, Ast::T::NUMBER)
+            LOAD_AS(LOAD_STR, Ast::T::STRING)
+            LOAD_AS(LOAD_BOOL, Ast::T::BOOLEAN)
+            case Program::Code::NEG_NUM:
+                sp[-1] = Value(-sp[-1].num());
+                break;
+            case Program::Code::NOT_BOOL:
+                sp[-1] = Value(!sp[-1].b());
+                break;
+            NUMBERS(ADD_NUM, +)
+            NUMBERS(SUB_NUM, -)
+            NUMBERS(MUL_NUM, *)
+            case Program::Code::DIV_NUM:
+                --sp;
+                if (sp[-1].num() == 0) {
+                    msg = "divide by 0";
+                    return Value();
+                }
+                sp[-1] = Value(sp[0].num() / sp[-1].num());
+                break;
+            case Program::Code::MOD_NUM: {
+                --sp;
+                const int d = truncate(sp[-1].num());
+                if (d == 0) {
+                    msg = "modulo by 0";
+                    return Value();
+                }
+                sp[-1] = Value(modulo(truncate(sp[0].num()), d));
+                break;
+            }
+            case Program::Code::POW_NUM:
+                --sp;
+                sp[-1] = Value(std::pow(sp[0].num(), sp[-1].num()));
+                break;
+            NUMBERS(EQ_NUM, ==)
+            NUMBERS(NE_NUM, !=)
+            NUMBERS(GT_NUM, >)
+            NUMBERS(GE_NUM, >=)
+            NUMBERS(LT_NUM, <)
+            NUMBERS(LE_NUM, <=)
+            STRINGS(EQ_STR, ==)
+            STRINGS(NE_STR, !=)
+            STRINGS(GT_STR, >)
+            STRINGS(GE_STR, >=)
+            STRINGS(LT_STR, <)
+            STRINGS(LE_STR, <=)
+            BOOLEANS(EQ_BOOL, ==)
+            BOOLEANS(NE_BOOL, !=)
+            BOOLEANS(AND_BOOL, &&)
+            BOOLEANS(OR_BOOL, ||)
+            BOOLEANS(LAND_BOOL, &&)
+            BOOLEANS(LOR_BOOL, ||)
+        }
+    }
+    assert(sp == stack + 1);
+    return std::move(stack[0]);
+}
@@ -0,0 +1,75 @@
+#ifndef HEADER_8D5F40EB2B054DE4B66C7B74A0601F31
+#define HEADER_8D5F40EB2B054DE4B66C7B74A0601F31
+
+#include "ast.h"
+#include "dag.h"
+#include "value.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief linear stack machine code lowered from an Ast
+/// @note operands are pushed right first, so that errors are reported in
+/// the same order as by the recursive eval(). In SHORT_CIRCUIT mode the
+/// operands of && and || are pushed left first, JUMP_FALSE/JUMP_TRUE skip
+/// the right one and LAND/LOR combine them in that order.
+/// Nodes shared in the Dag are computed once per run: STORE keeps the top
+/// in a slot and FETCH pushes it again. Where the first computation may
+/// have been jumped over, CACHED pushes the slot and jumps past the STORE
+/// at arg - 1 if the slot is filled, otherwise the code is run again.
+/// The codes with a type suffix are only emitted for operands of known
+/// static types and skip the type checks, LOAD_* check the value bound.
+struct Program
+{
+    enum class Code : std::uint8_t {
+        CONST, LOAD, STORE, FETCH, CACHED,
+        POS, NEG, NOT,
+        ADD, SUB, MUL, DIV, MOD, POW,
+        AND, OR,
+        EQ, NE, GT, GE, LT, LE,
+        JUMP_FALSE, JUMP_TRUE, LAND, LOR,
+        LOAD_NUM, LOAD_STR, LOAD_BOOL,
+        NEG_NUM, NOT_BOOL,
+        ADD_NUM, SUB_NUM, MUL_NUM, DIV_NUM, MOD_NUM, POW_NUM,
+        EQ_NUM, NE_NUM, GT_NUM, GE_NUM, LT_NUM, LE_NUM,
+        EQ_STR, NE_STR, GT_STR, GE_STR, LT_STR, LE_STR,
+        EQ_BOOL, NE_BOOL, AND_BOOL, OR_BOOL, LAND_BOOL, LOR_BOOL,
+    };
+    struct Instr
+    {
+        Code code;
+        std::uint32_t arg;
+    };
+    std::vector<Instr> code;
+    std::vector<Value> consts;
+    std::vector<Atom> symbols;
+    std::size_t depth;
+    std::size_t slots;
+    EvalMode mode;
+};
+
+Program compile(const Dag &dag, EvalMode mode = EvalMode::STRICT);
+Program compile(const Ast::Ptr &root, EvalMode mode = EvalMode::STRICT);
+/// @param types the static type of every node of dag as given by infer()
+Program compile(
+    const Dag &dag,
+    const std::vector<Ast::T> &types,
+    EvalMode mode = EvalMode::STRICT
+);
+/// @brief the code doing what c does without knowing operand types
+Program::Code untyped(Program::Code c);
+/// @brief the operator c evaluates, false for codes evaluating none
+bool evaluates(Program::Code c, Ast::O &op);
+/// @brief the error of a LOAD_* given a value of another type than t
+std::string mistyped(Atom symbol, Ast::T t);
+/// @brief renumbers the symbols of p to their index in slots
+/// @note slots has to contain every symbol of p, it may contain more
+void bindSlots(Program &p, const std::vector<Atom> &slots);
+void bindSlots(Program &p, const std::vector<std::string> &slots);
+/// @param args one value per symbol of p, an UNKNOWN one is unbound
+Value run(const Program &p, const Value *args, std::string &msg);
+Value run(const Program &p, const Value::Dict &dict, std::string &msg);
+
+#endif
@@ -2,6 +2,9 @@
 #include "../src/parser.h"
 
 #include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 TEST(Ast, Ctor)
 {
@@ -16,9 +19,9 @@ TEST(Ast, Make)
     EXPECT_EQ(Ast::T::OPERATOR, Ast::make(Ast::O::CMP_LE)->t);
     EXPECT_EQ(Ast::O::CMP_LE, Ast::make(Ast::O::CMP_LE)->op);
     EXPECT_EQ(Ast::T::BOOLEAN, Ast::make(false)->t);
-    EXPECT_EQ("wu", Ast::makeString("wu")->str);
+    EXPECT_EQ("wu", Ast::makeString("wu")->str.str());
     EXPECT_EQ(Ast::T::STRING, Ast::makeString("wu")->t);
-    EXPECT_EQ("wu", Ast::makeSymbol("wu")->str);
+    EXPECT_EQ("wu", Ast::makeSymbol("wu")->str.str());
     EXPECT_EQ(Ast::T::SYMBOL, Ast::makeSymbol("wu")->t);
 }
 
@@ -130,7 +133,31 @@ TEST(Ast, EvalAdd3)
     auto v = eval(t, d, msg);
     EXPECT_TRUE(static_cast<bool>(v));
     EXPECT_EQ(Ast::T::STRING, v->t);
-    EXPECT_EQ("1a3", v->str);
+    EXPECT_EQ("1a3", v->str.str());
+}
+
+TEST(Ast, EvalAddNumberText)
+{
+    // numbers are written with 17 digits, the same in every locale
+    for (const auto &c : std::vector<std::pair<std::string, std::string> >{
+        {"0.1+a", "0.10000000000000001a"}, {"a+1", "a1"},
+        {"a+-2.5e-3", "a-0.0025000000000000001"}, {"a+1e300", "a1.0000000000000001e+300"},
+        {"123456789012+a", "123456789012a"},
+        {"a+\"long enough not to fit inline\"+1",
+            "along enough not to fit inline1"}
+    }) {
+        std::istringstream s(c.first);
+        auto p = Parser(s);
+        auto t = p.parseExpr();
+        EXPECT_TRUE(static_cast<bool>(t)) << c.first;
+        std::string msg;
+        auto d = Ast::Dict();
+        d["a"] = Ast::makeString("a");
+        auto v = eval(t, d, msg);
+        ASSERT_TRUE(static_cast<bool>(v)) << c.first << msg;
+        EXPECT_EQ(Ast::T::STRING, v->t);
+        EXPECT_EQ(c.second, v->str.str());
+    }
 }
 
 TEST(Ast, EvalAddFail)
@@ -219,7 +246,30 @@ TEST(Ast, EvalMul2)
     auto v = eval(t, d, msg);
     EXPECT_TRUE(static_cast<bool>(v));
     EXPECT_EQ(Ast::T::STRING, v->t);
-    EXPECT_EQ("aaaaaa", v->str);
+    EXPECT_EQ("aaaaaa", v->str.str());
+}
+
+TEST(Ast, EvalMulLong)
+{
+    std::istringstream s("a*10*0+a*3+\"-\"+a*7");
+    auto p = Parser(s);
+    auto t = p.parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t));
+    std::string msg;
+    auto d = Ast::Dict();
+    d["a"] = Ast::makeString("abcd");
+    auto v = eval(t, d, msg);
+    ASSERT_TRUE(static_cast<bool>(v)) << msg;
+    EXPECT_EQ(Ast::T::STRING, v->t);
+    std::string want;
+    for (int i = 0; i < 3; ++i) {
+        want += "abcd";
+    }
+    want += "-";
+    for (int i = 0; i < 7; ++i) {
+        want += "abcd";
+    }
+    EXPECT_EQ(want, v->str.str());
 }
 
 TEST(Ast, EvalMulFail)
@@ -565,7 +615,7 @@ TEST(Ast, MixedTest2)
     auto v = eval(t, d, msg);
     EXPECT_TRUE(static_cast<bool>(v));
     EXPECT_EQ(Ast::T::STRING, v->t);
-    EXPECT_EQ("a-2147483646", v->str);
+    EXPECT_EQ("a-2147483646", v->str.str());
 }
 
 TEST(Ast, parseMixedSymbol1)
@@ -612,3 +662,57 @@ TEST(Ast, parseMixedSymbol3)
     EXPECT_EQ(Ast::T::NUMBER, v->t);
     EXPECT_EQ(4, v->num);
 }
+
+TEST(Ast, ShortCircuitSkipsRight)
+{
+    for (const auto str : {
+        "false && unresolved", "true || unresolved",
+        "false && 1/0 == 1", "true || \"s\" - 1 > 0",
+        "1 > 2 && a.b(x) || 3 > 2"
+    }) {
+        std::istringstream s(str);
+        auto p = Parser(s);
+        auto t = p.parseExpr();
+        EXPECT_TRUE(static_cast<bool>(t)) << str;
+        std::string msg;
+        auto d = Ast::Dict();
+        EXPECT_FALSE(static_cast<bool>(eval(t, d, msg))) << str;
+        auto v = eval(t, d, msg, EvalMode::SHORT_CIRCUIT);
+        EXPECT_TRUE(static_cast<bool>(v)) << str << ": " << msg;
+        EXPECT_EQ(Ast::T::BOOLEAN, v->t) << str;
+    }
+}
+
+TEST(Ast, ShortCircuitEvaluatesRight)
+{
+    for (const auto str : {
+        "true && unresolved", "false || unresolved", "unresolved && false",
+        "true&&1", "false||\"s\"", "1&&false", "\"s\"||true"
+    }) {
+        std::istringstream s(str);
+        auto p = Parser(s);
+        auto t = p.parseExpr();
+        EXPECT_TRUE(static_cast<bool>(t)) << str;
+        std::string msg;
+        auto d = Ast::Dict();
+        auto v = eval(t, d, msg, EvalMode::SHORT_CIRCUIT);
+        EXPECT_FALSE(static_cast<bool>(v)) << str;
+    }
+}
+
+TEST(Ast, ShortCircuitResult)
+{
+    std::istringstream s("a > 1 && a < 3 || a == 7");
+    auto p = Parser(s);
+    auto t = p.parseExpr();
+    std::string msg;
+    auto d = Ast::Dict();
+    for (const double a : {0.0, 2.0, 5.0, 7.0}) {
+        d["a"] = Ast::make(a);
+        auto strict = eval(t, d, msg);
+        auto lazy = eval(t, d, msg, EvalMode::SHORT_CIRCUIT);
+        ASSERT_TRUE(static_cast<bool>(strict));
+        ASSERT_TRUE(static_cast<bool>(lazy));
+        EXPECT_EQ(strict->b, lazy->b) << a;
+    }
+}
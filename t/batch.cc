@@ -0,0 +1,170 @@
+#include "../src/ast.h"
+#include "../src/batch.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static Program program(const char *str, EvalMode mode)
+{
+    std::istringstream s(str);
+    const auto t = Parser(s).parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t)) << str;
+    return compile(t, mode);
+}
+
+// runs every row through run() and compares it with the batch result
+static void expectSameAsRun(
+    const Program &p,
+    const std::vector<Column> &columns,
+    const std::vector<std::vector<Value> > &rows,
+    const char *str
+)
+{
+    ResultColumn out;
+    run(p, columns.data(), rows.size(), out);
+    ASSERT_EQ(rows.size(), out.type.size()) << str;
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        std::string msg;
+        const auto v = run(p, rows[i].data(), msg);
+        switch (v.t()) {
+            case Ast::T::NUMBER:
+                ASSERT_EQ(ResultColumn::Type::REAL, out.type[i])
+                    << str << " row " << i;
+                if (v.num() == v.num()) {
+                    EXPECT_EQ(v.num(), out.real[i]) << str << " row " << i;
+                }
+                break;
+            case Ast::T::BOOLEAN:
+                ASSERT_EQ(ResultColumn::Type::BOOL, out.type[i])
+                    << str << " row " << i;
+                EXPECT_EQ(v.b(), out.real[i] != 0) << str << " row " << i;
+                break;
+            case Ast::T::STRING:
+                ASSERT_EQ(ResultColumn::Type::STRING, out.type[i])
+                    << str << " row " << i;
+                EXPECT_EQ(v.str(), out.str[i]) << str << " row " << i;
+                break;
+            default:
+                ASSERT_EQ(ResultColumn::Type::ERROR, out.type[i])
+                    << str << " row " << i;
+                EXPECT_EQ(msg, out.str[i]) << str << " row " << i;
+                break;
+        }
+    }
+}
+
+TEST(Batch, SameAsRun)
+{
+    // more rows than one chunk, with zeros, negatives and fractions
+    const std::size_t n = 2500;
+    std::vector<double> a(n), f(n);
+    std::unique_ptr<bool[]> b(new bool[n]);
+    std::vector<std::string> strings(n);
+    std::vector<Span> s(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = static_cast<double>(i % 7) - 2.5 * (i % 3 == 0);
+        f[i] = static_cast<double>(i % 5);
+        b[i] = i % 3 == 1;
+        strings[i] = i % 4 ? "a" : "a string too long to be kept inline";
+        s[i] = Span(strings[i]);
+    }
+    for (const auto str : evalCorpus) {
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            auto p = program(str, mode);
+            bindSlots(p, {"a", "a.f()", "unbound"});
+            const std::vector<std::vector<Column> > inputs = {
+                {Column(a.data()), Column(f.data()), Column()},
+                {Column(b.get()), Column(), Column()},
+                {Column(s.data()), Column(a.data()), Column()},
+            };
+            for (const auto &columns : inputs) {
+                std::vector<std::vector<Value> > rows(n);
+                for (std::size_t i = 0; i < n; ++i) {
+                    for (const auto &c : columns) {
+                        switch (c.type) {
+                            case Column::Type::REAL:
+                                rows[i].push_back(Value(c.real[i]));
+                                break;
+                            case Column::Type::BOOL:
+                                rows[i].push_back(Value(c.boolean[i]));
+                                break;
+                            case Column::Type::STRING:
+                                rows[i].push_back(Value(c.str[i]));
+                                break;
+                            default:
+                                rows[i].push_back(Value());
+                                break;
+                        }
+                    }
+                }
+                expectSameAsRun(p, columns, rows, str);
+            }
+        }
+    }
+}
+
+TEST(Batch, RowErrors)
+{
+    const double x[] = {1, 0, -2, 0, 4};
+    auto p = program("x != 0 && 8 / x > 1", EvalMode::STRICT);
+    ResultColumn out;
+    const Column c(x);
+    run(p, &c, 5, out);
+    EXPECT_EQ(ResultColumn::Type::BOOL, out.type[0]);
+    EXPECT_EQ(ResultColumn::Type::ERROR, out.type[1]);
+    EXPECT_EQ("divide by 0", out.str[1]);
+    EXPECT_EQ(ResultColumn::Type::BOOL, out.type[2]);
+    EXPECT_EQ(0, out.real[2]);
+    EXPECT_EQ(ResultColumn::Type::ERROR, out.type[3]);
+    EXPECT_EQ(1, out.real[4]);
+    // the skipped division cannot fail
+    p = program("x != 0 && 8 / x > 1", EvalMode::SHORT_CIRCUIT);
+    run(p, &c, 5, out);
+    for (std::size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(ResultColumn::Type::BOOL, out.type[i]) << i;
+        EXPECT_EQ(x[i] != 0 && 8 / x[i] > 1, out.real[i] != 0) << i;
+    }
+}
+
+TEST(Batch, Unbound)
+{
+    auto p = program("x + 1", EvalMode::STRICT);
+    ResultColumn out;
+    const Column c;
+    run(p, &c, 3, out);
+    ASSERT_EQ(3u, out.type.size());
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(ResultColumn::Type::ERROR, out.type[i]);
+        EXPECT_EQ("unsolvable symbol x", out.str[i]);
+    }
+    run(Program(compile(nullptr)), &c, 2, out);
+    EXPECT_EQ(2u, out.type.size());
+}
+
+TEST(Batch, Cached)
+{
+    // a*2>1 is shared, its first evaluation is skipped for a <= 0
+    const char *str[] = {
+        "(a > 0 && a*2>1) || a*2>1", "(a > 0 && a*2>1) && (a*2>1)",
+        "(a > 0 || a-1 > 0) && !(a-1 > 0) || (a-1)/a > 0",
+    };
+    std::vector<double> a;
+    for (int i = -3; i < 4; ++i) {
+        a.push_back(i * 0.5);
+    }
+    std::vector<std::vector<Value> > rows;
+    for (const double v : a) {
+        rows.push_back({Value(v)});
+    }
+    for (const auto s : str) {
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            expectSameAsRun(program(s, mode), {Column(a.data())}, rows, s);
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#include "../src/catalog.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string path(const char *name)
+{
+    return testing::TempDir() + name;
+}
+
+static Expression::Dict dict()
+{
+    auto a = std::make_shared<parameter>(PT_REAL);
+    a->setValueReal(2);
+    Expression::Dict d;
+    d["a"] = a;
+    return d;
+}
+
+TEST(Catalog, Lazy)
+{
+    std::vector<Expression> expressions;
+    for (const auto str : evalCorpus) {
+        expressions.emplace_back(str);
+    }
+    expressions[1].setMode(Expression::Mode::SHORT_CIRCUIT);
+    const std::string file = path("catalog_lazy.aexc");
+    ASSERT_TRUE(Catalog::save(file, expressions));
+
+    Catalog c;
+    EXPECT_FALSE(c);
+    ASSERT_TRUE(c.open(file)) << c.msg();
+    EXPECT_TRUE(c);
+    ASSERT_EQ(expressions.size(), c.size());
+    EXPECT_EQ(0u, c.materialized());
+    const auto r = c.eval(3, dict());
+    EXPECT_EQ(expressions[3].eval(dict()).second, r.second);
+    EXPECT_EQ(1u, c.materialized());
+    EXPECT_EQ(&c.get(3), &c.get(3));
+    EXPECT_EQ(1u, c.materialized());
+    EXPECT_EQ(Expression::Mode::SHORT_CIRCUIT, c.get(1).mode());
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        const auto x = expressions[i].eval(dict());
+        const auto y = c.eval(i, dict());
+        EXPECT_EQ(x.second, y.second) << evalCorpus[i];
+        ASSERT_EQ(static_cast<bool>(x.first), static_cast<bool>(y.first));
+        if (x.first && x.first->getType() == PT_REAL) {
+            EXPECT_EQ(x.first->getValueReal(), y.first->getValueReal());
+        }
+        EXPECT_EQ(expressions[i].msg(), c.get(i).msg());
+    }
+    EXPECT_EQ(c.size(), c.materialized());
+}
+
+TEST(Catalog, Concurrent)
+{
+    std::vector<Expression> expressions;
+    for (int i = 0; i < 64; ++i) {
+        expressions.emplace_back("a * " + std::to_string(i));
+    }
+    const std::string file = path("catalog_concurrent.aexc");
+    ASSERT_TRUE(Catalog::save(file, expressions, false));
+    Catalog c;
+    ASSERT_TRUE(c.open(file)) << c.msg();
+    std::vector<std::thread> threads;
+    std::vector<int> failed(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&c, &failed, t] {
+            for (std::size_t i = 0; i < c.size(); ++i) {
+                const auto r = c.eval(i, dict());
+                failed[t] += !r.first || r.first->getValueReal() != 2.0 * i;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(std::vector<int>(4, 0), failed);
+    EXPECT_EQ(64u, c.materialized());
+}
+
+TEST(Catalog, Invalid)
+{
+    Catalog c;
+    EXPECT_FALSE(c.open(path("catalog_missing.aexc")));
+    EXPECT_EQ(0u, c.msg().find("cannot open "));
+
+    const std::string file = path("catalog_invalid.aexc");
+    const std::vector<Expression> expressions(1, Expression("a + 1"));
+    ASSERT_TRUE(Catalog::save(file, expressions));
+    std::string data;
+    {
+        std::ifstream in(file, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>());
+    }
+    const auto write = [&file](const std::string &s) {
+        std::ofstream(file, std::ios::binary | std::ios::trunc) << s;
+    };
+    write(data.substr(0, data.size() - 1));
+    EXPECT_FALSE(c.open(file));
+    EXPECT_FALSE(c);
+    EXPECT_EQ(0u, c.size());
+    write(data.substr(0, 10));
+    EXPECT_FALSE(c.open(file));
+    std::string other = data;
+    other[4] = 2;
+    write(other);
+    EXPECT_FALSE(c.open(file));
+
+    // a damaged record gives an Expression without expression
+    other = data;
+    other[32] = 'X';
+    write(other);
+    ASSERT_TRUE(c.open(file)) << c.msg();
+    EXPECT_FALSE(c.get(0));
+    EXPECT_EQ("no expression is given", c.get(0).msg());
+
+    write(data);
+    ASSERT_TRUE(c.open(file)) << c.msg();
+    EXPECT_TRUE(c.get(0));
+
+    // an expression too deep to load is not saved, the file stays
+    std::string text = "x";
+    for (int i = 0; i < 5000; ++i) {
+        text += "+x";
+    }
+    EXPECT_FALSE(Catalog::save(file,
+        std::vector<Expression>{Expression("1"), Expression(text)}));
+    ASSERT_TRUE(c.open(file)) << c.msg();
+    EXPECT_EQ(1u, c.size());
+    EXPECT_TRUE(c.get(0));
+}
@@ -0,0 +1,128 @@
+#include "../src/compiled.h"
+#include "../src/interface.h"
+#include "corpus.h"
+
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// a malformed text is rejected by the compiler, e.g.
+// COMPILED_EXPRESSION("1 +") fails with "unexpected end" and
+// COMPILED_EXPRESSION("1 2") with "unprocessed components on the end, ..."
+
+typedef Value (*Compiled)(const Value::Dict &, std::string &);
+
+struct Entry
+{
+    const char *str;
+    Compiled strict;
+    Compiled shortCircuit;
+};
+
+#define COMPILED_ENTRY(s) {\
+        s,\
+        [](const Value::Dict &d, std::string &msg) {\
+            return COMPILED_EXPRESSION(s)(d, msg);\
+        },\
+        [](const Value::Dict &d, std::string &msg) {\
+            return COMPILED_EXPRESSION_MODE(s, EvalMode::SHORT_CIRCUIT)(\
+                d, msg\
+            );\
+        },\
+    },
+
+static const Entry corpus[] = { EVAL_CORPUS(COMPILED_ENTRY) };
+
+static std::shared_ptr<parameter> toParameter(const Value &v)
+{
+    auto p = std::make_shared<parameter>(
+        v.t() == Ast::T::STRING ? PT_STRING : PT_REAL
+    );
+    if (v.t() == Ast::T::STRING) {
+        p->setValueString(v.str());
+    } else {
+        p->setValueReal(v.num());
+    }
+    return p;
+}
+
+TEST(Compiled, SameAsEval)
+{
+    const Value values[] = {
+        Value(0.0), Value(1.0), Value(-2.5), Value(std::string("a")),
+        Value(std::string("a string too long to be kept inline")),
+    };
+    for (const auto &entry : corpus) {
+        for (const auto mode
+            : {Expression::Mode::STRICT, Expression::Mode::SHORT_CIRCUIT}
+        ) {
+            Expression e(entry.str);
+            ASSERT_TRUE(e) << entry.str;
+            e.setMode(mode);
+            const Compiled compiled = mode == Expression::Mode::STRICT
+                ? entry.strict : entry.shortCircuit;
+            for (const auto &a : values) {
+                Value::Dict dict;
+                dict["a"] = a;
+                dict["a.f()"] = Value(2.0);
+                Expression::Dict params;
+                for (const auto &d : dict) {
+                    params[d.first] = toParameter(d.second);
+                }
+                const auto want = e.eval(params);
+                std::string msg;
+                const Value got = compiled(dict, msg);
+                ASSERT_EQ(static_cast<bool>(want.first),
+                    static_cast<bool>(got)) << entry.str;
+                if (!got) {
+                    EXPECT_EQ(want.second, msg) << entry.str;
+                } else if (got.t() == Ast::T::STRING) {
+                    EXPECT_EQ(want.first->getValueString(), got.str())
+                        << entry.str;
+                } else {
+                    const double v = got.t() == Ast::T::BOOLEAN
+                        ? got.b() : got.num();
+                    const double w = want.first->getValueReal();
+                    EXPECT_TRUE(v == w || (v != v && w != w)) << entry.str;
+                }
+            }
+        }
+    }
+}
+
+TEST(Compiled, Slots)
+{
+    const auto e = COMPILED_EXPRESSION("y * 2 > x.f(1, \"b\") && y < z");
+    EXPECT_EQ(std::vector<std::string>({"x.f(1, \"b\")", "y", "z"}),
+        e.slots());
+    const Value args[] = {Value(3.0), Value(2.0), Value(5.0)};
+    std::string msg;
+    const Value v = e(args, msg);
+    ASSERT_TRUE(static_cast<bool>(v)) << msg;
+    EXPECT_TRUE(v.b());
+    const Value unbound[] = {Value(3.0), Value(2.0), Value()};
+    EXPECT_FALSE(e(unbound, msg));
+    EXPECT_EQ("unsolvable symbol z", msg);
+}
+
+TEST(Compiled, Numbers)
+{
+    std::string msg;
+    EXPECT_TRUE(COMPILED_EXPRESSION("0.1 + 0.2 == 0.30000000000000004")(
+        Value::Dict(), msg).b());
+    for (const char *s : {"1e23", "123456789012345678901", "2.5e-300"}) {
+        Expression e(s);
+        ASSERT_TRUE(e) << s;
+        EXPECT_EQ(std::strtod(s, nullptr),
+            e.eval(Expression::Dict()).first->getValueReal()) << s;
+    }
+    EXPECT_EQ(1e23, COMPILED_EXPRESSION("1e23")(Value::Dict(), msg).num());
+    EXPECT_EQ(123456789012345678901.0,
+        COMPILED_EXPRESSION("123456789012345678901")(Value::Dict(), msg)
+            .num());
+    EXPECT_EQ(2.5e-300,
+        COMPILED_EXPRESSION("2.5e-300")(Value::Dict(), msg).num());
+    EXPECT_EQ(0.0, COMPILED_EXPRESSION("0e999")(Value::Dict(), msg).num());
+}
@@ -0,0 +1,62 @@
+#ifndef HEADER_5C0AE55D02F04C49A0E4D3E0B4A7E1C2
+#define HEADER_5C0AE55D02F04C49A0E4D3E0B4A7E1C2
+
+// expressions taken from the eval tests in t/ast.cc and some with common
+// subexpressions, the symbol "a" is expected to be bound by the user of
+// the corpus
+#define EVAL_CORPUS(X) \
+    X("!true") X("!(false)") X("+2") X("-2") X("+true") X("+\"a\"") X("!2") \
+    X("!\"a\"") X("-true") X("-\"a\"") X("1+2+3") X("1+a+3") X("true+1") \
+    X("2+true") X("true+\"false\"") X("\"t\"+true") X("1-2-3") X("1--2-3") \
+    X("1-\"s\"") X("\"s\"-1") X("true-1") X("2-true") X("true-\"false\"") \
+    X("\"t\"-true") X("2*2*3") X("2*a*3") X("true*1") X("2*true") \
+    X("true*\"false\"") X("\"t\"*true") X("1/2/3") X("1/\"s\"") X("\"s\"/1") \
+    X("true/1") X("2/true") X("true/\"false\"") X("\"t\"/true") X("1/0") \
+    X("24%10%3") X("1%\"s\"") X("\"s\"%1") X("true%1") X("2%true") \
+    X("true%\"false\"") X("\"t\"%true") X("1%0") X("-2^30") X("1^\"s\"") \
+    X("\"s\"^1") X("true^1") X("2^true") X("true^\"false\"") X("\"t\"^true") \
+    X("true && true") X("false&&true") X("true&&false") X("false&&false") \
+    X("1&&\"s\"") X("\"s\"&&1") X("true&&1") X("2&&true") \
+    X("true&&\"false\"") X("\"t\"&&true") X("1&&2") X("false && false") \
+    X("false||true") X("true||false") X("true||true") X("1||\"s\"") \
+    X("\"s\"||1") X("true||1") X("2||true") X("true||\"false\"") \
+    X("\"t\"||true") X("1||2") X("5==4+1") X("true == true") \
+    X("false == false") X("\"a1\"==\"a\"+1") X("5!=4+3") X("!true != true") \
+    X("false != true") X("5!=4+1") X("true != true") X("false != false") \
+    X("\"a1\"!=\"a\"+1") X("5==4+3") X("!true == true") X("false == true") \
+    X("1 == \"1\"") X("1 == true") X("\"true\"==true") X("1 != \"1\"") \
+    X("1 != true") X("\"true\"!=true") X("4>3") X("\"b\">\"a\"") \
+    X("\"a\"*3>\"a\"") X("3<4") X("\"a\"<\"b\"") X("\"a\"<\"a\"*3") X("4>=3") \
+    X("\"b\">=\"a\"") X("\"a\"*3>=\"a\"") X("3<=4") X("\"a\"<=\"b\"") \
+    X("\"a\"<=\"a\"*3") X("4<3") X("\"b\"<\"a\"") X("\"a\"*3<\"a\"") X("3>4") \
+    X("\"a\">\"b\"") X("\"a\">\"a\"*3") X("4<=3") X("\"b\"<=\"a\"") \
+    X("\"a\"*3<=\"a\"") X("3>=4") X("\"a\">=\"b\"") X("\"a\">=\"a\"*3") \
+    X("true > false") X("true >= false") X("true < false") X("true <= false") \
+    X("1<\"2\"") X("1>\"2\"") X("1<=\"2\"") X("1>=\"2\"") X("true<\"2\"") \
+    X("false>\"2\"") X("false<=\"2\"") X("true>=\"2\"") \
+    X("0--(-2^(3+(7*(2+2))-1)+1)*2 == -2147483646") \
+    X("\"a\"+(-2^(3+(7*(2+2))-1)+1)*2") X("a.f()+2") X("unbound+1") \
+    X("(a*3-1)^2 + (a*3-1)*a") X("(a-\"s\") + (a-\"s\")") \
+    X("(false && a*2>1) || a*2>1") X("(true && a*2>1) && (a*2>1)") \
+    X("(a>1 || a*2>1) && !(a*2>1)")
+
+#define EVAL_CORPUS_STRING(s) s,
+static const char *const evalCorpus[] = {
+    EVAL_CORPUS(EVAL_CORPUS_STRING)
+};
+
+// the input of the tests in t/parser.cc, some of them do not parse
+static const char *const parserCorpus[] = {
+    "", "true", "!false", "!(false)", "+1", "-1", "3.14e-3", "x1",
+    "a-b-c", "a/b/c", "a^-b%-c^-d", "a.f()+2", "a.function()+2",
+    "a*-b", " a * -b", "a *-b", "a*- b", "a/-b", " a / -b", "a /-b",
+    "a/- b", "a+-b", " a + -b", "a +-b", "a+- b", "a--b", " a - -b",
+    "a --b", "a-- b", "a^-b", " a ^ -b", "a ^-b", "a^- b", "a^b", " a ^ b",
+    "a ^b", "a^ b", "a==-b", "a!=-b", "a<-b", "a<=-b", "a>-b", "a>=-b",
+    "a+c^(2*b.x.f(y+x))!=3||b||c", "(a&&b)||c^2^3^4*5",
+    "A.f(x,y) 3.14e-2 + (\"wu\" - 4) /r!\t ",
+    "A.f(x,y, (((\")\"))) 3.14e-2", "A.f(x,y, (((\")\")))) 3.14e-2",
+    "A.f(x,y, \") 3.14e-2", "A.f(x,y, \")\") 3.14e-2",
+};
+
+#endif
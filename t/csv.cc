@@ -0,0 +1,109 @@
+#include "../src/csv.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <fstream>
+#include <string>
+
+static std::string file(const char *name, const std::string &content)
+{
+    const std::string path = testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+    return path;
+}
+
+TEST(Csv, Columns)
+{
+    CsvFile csv;
+    ASSERT_TRUE(csv.open(file("columns.csv",
+        "x,name,\"flag\",unused,note\r\n"
+        "1.5,bob,true,1,\"a, \"\"quoted\"\"\nnote\"\r\n"
+        "\n"
+        "-2e3,\"alice\",false,2,plain\r\n"
+        "7,carol,true\n"))) << csv.msg();
+    const std::vector<std::string> header = {
+        "x", "name", "flag", "unused", "note"
+    };
+    EXPECT_EQ(header, csv.header());
+    EXPECT_EQ(3u, csv.read({"x", "name", "flag", "note", "missing"}));
+    EXPECT_EQ(3u, csv.rows());
+    const auto &columns = csv.columns();
+    EXPECT_EQ(4u, columns.size());
+    EXPECT_EQ(0u, columns.count("unused"));
+
+    const Column &x = columns.at("x");
+    ASSERT_EQ(Column::Type::REAL, x.type);
+    EXPECT_EQ(1.5, x.real[0]);
+    EXPECT_EQ(-2000, x.real[1]);
+    EXPECT_EQ(7, x.real[2]);
+    const Column &name = columns.at("name");
+    ASSERT_EQ(Column::Type::STRING, name.type);
+    EXPECT_EQ("bob", name.str[0].str());
+    EXPECT_EQ("alice", name.str[1].str());
+    const Column &flag = columns.at("flag");
+    ASSERT_EQ(Column::Type::BOOL, flag.type);
+    EXPECT_TRUE(flag.boolean[0]);
+    EXPECT_FALSE(flag.boolean[1]);
+    const Column &note = columns.at("note");
+    ASSERT_EQ(Column::Type::STRING, note.type);
+    EXPECT_EQ("a, \"quoted\"\nnote", note.str[0].str());
+    EXPECT_EQ("plain", note.str[1].str());
+    EXPECT_EQ("", note.str[2].str());
+
+    Expression e("(flag && x > 0) || name == \"alice\"");
+    ResultColumn out;
+    EXPECT_EQ(3u, csv.read(e.symbols()));
+    e.eval(csv.columns(), csv.rows(), out);
+    ASSERT_EQ(3u, out.type.size());
+    EXPECT_EQ(1, out.real[0]);
+    EXPECT_EQ(1, out.real[1]);
+    EXPECT_EQ(1, out.real[2]);
+}
+
+TEST(Csv, Types)
+{
+    // long lines so that most of the text is scanned in vectors
+    std::string text = "a,b,c\n";
+    for (int i = 0; i < 100; ++i) {
+        text += std::to_string(i) + ".25,\"" + std::string(i % 20, 'x')
+            + "\"," + (i == 50 ? "\"7\"" : std::to_string(i)) + "\n";
+    }
+    CsvFile csv;
+    ASSERT_TRUE(csv.open(file("types.csv", text)));
+    EXPECT_EQ(100u, csv.read({"a", "b", "c"}));
+    const auto &columns = csv.columns();
+    ASSERT_EQ(Column::Type::REAL, columns.at("a").type);
+    EXPECT_EQ(99.25, columns.at("a").real[99]);
+    ASSERT_EQ(Column::Type::STRING, columns.at("b").type);
+    EXPECT_EQ(std::string(19, 'x'), columns.at("b").str[99].str());
+    // a quoted field is a string, so the whole column is
+    ASSERT_EQ(Column::Type::STRING, columns.at("c").type);
+    EXPECT_EQ("7", columns.at("c").str[50].str());
+    EXPECT_EQ("99", columns.at("c").str[99].str());
+
+    // numbers as the lexer reads them, out of range ones too
+    ASSERT_TRUE(csv.open(file("numbers.csv",
+        "a,b,c\n1,1,1\ninf,2,-.5\nnan,1e400,-1e400\n")));
+    EXPECT_EQ(3u, csv.read({"a", "b", "c"}));
+    ASSERT_EQ(Column::Type::STRING, csv.columns().at("a").type);
+    EXPECT_EQ("inf", csv.columns().at("a").str[1].str());
+    ASSERT_EQ(Column::Type::REAL, csv.columns().at("b").type);
+    EXPECT_EQ(HUGE_VAL, csv.columns().at("b").real[2]);
+    ASSERT_EQ(Column::Type::REAL, csv.columns().at("c").type);
+    EXPECT_EQ(-0.5, csv.columns().at("c").real[1]);
+    EXPECT_EQ(-HUGE_VAL, csv.columns().at("c").real[2]);
+}
+
+TEST(Csv, Empty)
+{
+    CsvFile csv;
+    EXPECT_FALSE(csv.open(testing::TempDir() + "missing.csv"));
+    EXPECT_EQ(0u, csv.read({"a"}));
+    ASSERT_TRUE(csv.open(file("empty.csv", "")));
+    EXPECT_TRUE(csv.header().empty());
+    EXPECT_EQ(0u, csv.read({"a"}));
+    ASSERT_TRUE(csv.open(file("header.csv", "a,b")));
+    EXPECT_EQ(2u, csv.header().size());
+    EXPECT_EQ(0u, csv.read({"a"}));
+    EXPECT_EQ(1u, csv.columns().size());
+}
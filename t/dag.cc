@@ -0,0 +1,66 @@
+#include "../src/ast.h"
+#include "../src/dag.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+static Ast::Ptr parse(const char *str)
+{
+    std::istringstream s(str);
+    return Parser(s).parseExpr();
+}
+
+TEST(Dag, Empty)
+{
+    const auto d = share(nullptr);
+    EXPECT_TRUE(d.nodes.empty());
+    EXPECT_EQ(Dag::NONE, d.root());
+}
+
+TEST(Dag, Share)
+{
+    // 11 tree nodes, the second a.b(x)-c and its operands collapse
+    const auto d = share(parse("(a.b(x)-c)^2 + (a.b(x)-c)*k"));
+    ASSERT_EQ(8u, d.nodes.size());
+    const auto &root = d.nodes[d.root()];
+    EXPECT_EQ(Ast::T::OPERATOR, root.t);
+    EXPECT_EQ(Ast::O::PLUS, root.op);
+    EXPECT_EQ(0u, root.uses);
+    const auto &pow = d.nodes[root.left];
+    const auto &mul = d.nodes[root.right];
+    EXPECT_EQ(Ast::O::POWER, pow.op);
+    EXPECT_EQ(Ast::O::MULTIPLY, mul.op);
+    ASSERT_EQ(pow.left, mul.left);
+    const auto &sub = d.nodes[pow.left];
+    EXPECT_EQ(Ast::O::MINUS, sub.op);
+    EXPECT_EQ(2u, sub.uses);
+    EXPECT_EQ("a.b(x)", d.nodes[sub.left].str.str());
+}
+
+TEST(Dag, ChildrenFirst)
+{
+    const auto d = share(parse("(x+1)*(x+1) - -(x+1) / 2"));
+    for (std::size_t i = 0; i < d.nodes.size(); ++i) {
+        const auto &n = d.nodes[i];
+        if (n.left != Dag::NONE) {
+            EXPECT_LT(n.left, i);
+        }
+        if (n.right != Dag::NONE) {
+            EXPECT_LT(n.right, i);
+        }
+    }
+    EXPECT_EQ(8u, d.nodes.size());
+}
+
+TEST(Dag, Distinct)
+{
+    // a unary minus is not a binary one, 0 is not -0, 1 is not "1"
+    EXPECT_EQ(5u, share(parse("-x + (0-x)")).nodes.size());
+    EXPECT_EQ(6u, share(parse("(x+1) == (x+\"1\")")).nodes.size());
+    auto t = Ast::make(Ast::O::PLUS);
+    t->left = Ast::make(0.0);
+    t->right = Ast::make(-0.0);
+    EXPECT_EQ(3u, share(t).nodes.size());
+    EXPECT_EQ(2u, share(parse("true && true")).nodes.size());
+}
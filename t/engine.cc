@@ -0,0 +1,83 @@
+#include "../src/engine.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::shared_ptr<parameter> real(const std::string &name, double v)
+{
+    auto p = std::make_shared<parameter>(PT_REAL);
+    p->setName(name);
+    p->setValueReal(v);
+    return p;
+}
+
+TEST(Engine, Update)
+{
+    Engine engine;
+    const auto a = engine.add(Expression("x + 1"));
+    const auto b = engine.add(Expression("x * y"));
+    const auto c = engine.add(Expression("z > 2 || y == 0"));
+    EXPECT_EQ(3u, engine.size());
+    EXPECT_EQ("unsolvable symbol x", engine.result(a).second);
+    entity_list params;
+    params.push_back(real("x", 2));
+    params.push_back(real("y", 3));
+    params.push_back(real("unused", 3));
+    engine.set(params);
+    EXPECT_FALSE(static_cast<bool>(engine.result(a).first));
+    EXPECT_EQ(std::vector<Engine::Id>({a, b, c}), engine.update());
+    ASSERT_TRUE(static_cast<bool>(engine.result(a).first));
+    EXPECT_EQ(3, engine.result(a).first->getValueReal());
+    EXPECT_EQ(6, engine.result(b).first->getValueReal());
+    EXPECT_EQ("unsolvable symbol z", engine.result(c).second);
+    // only the expressions reading y are evaluated again
+    engine.set("y", real("y", 0));
+    EXPECT_EQ(std::vector<Engine::Id>({b, c}), engine.update());
+    EXPECT_EQ(0, engine.result(b).first->getValueReal());
+    EXPECT_EQ("unsolvable symbol z", engine.result(c).second);
+    engine.set("z", real("z", 1));
+    EXPECT_EQ(std::vector<Engine::Id>({c}), engine.update());
+    ASSERT_TRUE(static_cast<bool>(engine.result(c).first));
+    EXPECT_EQ(1, engine.result(c).first->getValueReal());
+    EXPECT_TRUE(engine.update().empty());
+    engine.set("unused", real("unused", 1));
+    EXPECT_TRUE(engine.update().empty());
+}
+
+TEST(Engine, Batch)
+{
+    Engine engine;
+    std::vector<Engine::Id> ids;
+    for (int i = 0; i < 10; ++i) {
+        const Expression e("x * " + std::to_string(i) + " + y");
+        ids.push_back(engine.add(e));
+    }
+    engine.set("x", real("x", 1));
+    engine.set("y", real("y", 1));
+    engine.set("x", real("x", 2));
+    // one pass for both symbols, every expression once, the last x wins
+    EXPECT_EQ(ids, engine.update());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(2 * i + 1, engine.result(ids[i]).first->getValueReal());
+    }
+    engine.set("y", std::shared_ptr<parameter>());
+    engine.update();
+    EXPECT_EQ("unsolvable symbol y", engine.result(ids[3]).second);
+    engine.set("y", std::make_shared<parameter>(PT_INTEGER));
+    engine.update();
+    EXPECT_EQ("unsolvable symbol y", engine.result(ids[3]).second);
+}
+
+TEST(Engine, AddAfterUpdate)
+{
+    Engine engine;
+    engine.set("x", real("x", 4));
+    engine.update();
+    const auto a = engine.add(Expression("x / 2"));
+    ASSERT_TRUE(static_cast<bool>(engine.result(a).first));
+    EXPECT_EQ(2, engine.result(a).first->getValueReal());
+    const auto b = engine.add(Expression("1 +"));
+    EXPECT_FALSE(static_cast<bool>(engine.result(b).first));
+}
@@ -0,0 +1,109 @@
+#include "../src/ast.h"
+#include "../src/batch.h"
+#include "../src/filter.h"
+#include "../src/parser.h"
+#include "../src/vm.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static Ast::Ptr tree(const char *str)
+{
+    std::istringstream s(str);
+    auto t = Parser(s).parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t)) << str;
+    return t;
+}
+
+// the rows the batch run() gives true for
+static std::vector<std::uint32_t> expected(
+    const Ast::Ptr &t,
+    EvalMode mode,
+    const std::vector<Atom> &slots,
+    const std::vector<Column> &columns,
+    std::size_t rows
+)
+{
+    auto p = compile(t, mode);
+    bindSlots(p, slots);
+    ResultColumn out;
+    run(p, columns.data(), rows, out);
+    std::vector<std::uint32_t> sel;
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (out.type[i] == ResultColumn::Type::BOOL && out.real[i]) {
+            sel.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    return sel;
+}
+
+TEST(Filter, Plan)
+{
+    const auto t = tree("a > 1 && (b < 2 || c) && !(d && e)");
+    const auto strict = plan(t, EvalMode::STRICT);
+    ASSERT_EQ(5u, strict.nodes.size());
+    EXPECT_FALSE(strict.nodes.back().leaf);
+    EXPECT_EQ(Ast::O::LOGICAL_AND, strict.nodes.back().op);
+    const auto sc = plan(t, EvalMode::SHORT_CIRCUIT);
+    EXPECT_EQ(7u, sc.nodes.size());
+    EXPECT_TRUE(plan(Ast::Ptr()).nodes.empty());
+}
+
+TEST(Filter, SameAsRun)
+{
+    const char *const predicates[] = {
+        "a > 1 && a.f() < 3",
+        "a > 1 || a.f() < 3",
+        "a > 1 && 6 / a.f() > 2",
+        "6 / a.f() > 2 && a > 1",
+        "a == 3 || 6 % a.f() == 0 && a < 4",
+        "(a > 0 || 1 / a.f() > 1) && (a.f() > 1 || a < -1)",
+        "a > 0 && unbound || a.f() == 1",
+        "a.f() == 2 || a * 2",
+        "!(a > 1 && a.f() > 1) && a != 0",
+        "a + 1",
+        "true",
+    };
+    const std::size_t n = 2500;
+    std::vector<double> a(n), f(n);
+    std::unique_ptr<bool[]> b(new bool[n]);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = static_cast<double>(i % 7) - 2.5 * (i % 3 == 0);
+        f[i] = static_cast<double>(i % 5);
+        b[i] = i % 3 == 1;
+    }
+    const std::vector<Atom> slots = {
+        Atom("a"), Atom("a.f()"), Atom("unbound")
+    };
+    const std::vector<std::vector<Column> > inputs = {
+        {Column(a.data()), Column(f.data()), Column()},
+        {Column(b.get()), Column(f.data()), Column(b.get())},
+    };
+    for (const auto str : predicates) {
+        const auto t = tree(str);
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            auto fl = plan(t, mode);
+            bindSlots(fl, slots);
+            for (const auto &columns : inputs) {
+                std::vector<std::uint32_t> sel;
+                run(fl, columns.data(), n, sel);
+                EXPECT_EQ(expected(t, mode, slots, columns, n), sel) << str;
+            }
+        }
+    }
+}
+
+TEST(Filter, Selection)
+{
+    const double x[] = {1, 0, -2, 0, 4, 9};
+    const Column c(x);
+    const std::uint32_t rows[] = {1, 2, 4, 5};
+    auto p = compile(tree("8 / x > 1"));
+    std::vector<std::uint32_t> yes, no;
+    run(p, &c, rows, 4, yes, &no);
+    EXPECT_EQ(std::vector<std::uint32_t>({4}), yes);
+    EXPECT_EQ(std::vector<std::uint32_t>({2, 5}), no);
+}
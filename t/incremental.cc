@@ -0,0 +1,111 @@
+#include "../src/ast.h"
+#include "../src/dag.h"
+#include "../src/incremental.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static Ast::Ptr tree(const char *str)
+{
+    std::istringstream s(str);
+    auto t = Parser(s).parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t)) << str;
+    return t;
+}
+
+TEST(Incremental, SameAsRun)
+{
+    const std::vector<Atom> slots = {Atom("a"), Atom("a.f()"), Atom("unbound")};
+    const Value values[] = {
+        Value(), Value(0.0), Value(1.0), Value(-2.5), Value(3.0), Value(true),
+        Value(false), Value(std::string("a")),
+        Value(std::string("a string too long to be kept inline")),
+    };
+    const std::size_t nvalues = sizeof(values) / sizeof(values[0]);
+    for (const auto str : evalCorpus) {
+        const auto t = tree(str);
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            auto p = compile(t, mode);
+            bindSlots(p, slots);
+            Incremental inc(share(t), mode);
+            std::vector<Value> args(slots.size());
+            // changes one symbol at a time through all combinations
+            for (std::size_t k = 0; k < 3 * nvalues; ++k) {
+                const std::size_t slot = k % 2;
+                args[slot] = values[(k * 7 + slot) % nvalues];
+                inc.set(slots[slot], args[slot]);
+                std::string want, got;
+                const auto v = run(p, args.data(), want);
+                const auto w = inc.eval(got);
+                ASSERT_EQ(v.t(), w.t()) << str << " step " << k;
+                if (!v) {
+                    EXPECT_EQ(want, got) << str << " step " << k;
+                } else if (v.t() == Ast::T::NUMBER && v.num() == v.num()) {
+                    EXPECT_EQ(v.num(), w.num()) << str << " step " << k;
+                } else if (v.t() == Ast::T::BOOLEAN) {
+                    EXPECT_EQ(v.b(), w.b()) << str << " step " << k;
+                } else if (v.t() == Ast::T::STRING) {
+                    EXPECT_EQ(v.str(), w.str()) << str << " step " << k;
+                }
+            }
+        }
+    }
+}
+
+TEST(Incremental, Recomputed)
+{
+    Incremental inc(share(tree("2 * 3600 + x * y + (z - 1) * (z - 1)")));
+    EXPECT_FALSE(inc.set(Atom("w"), Value(1.0)));
+    inc.set(Atom("x"), Value(2.0));
+    inc.set(Atom("y"), Value(3.0));
+    inc.set(Atom("z"), Value(4.0));
+    std::string msg;
+    auto v = inc.eval(msg);
+    ASSERT_TRUE(static_cast<bool>(v)) << msg;
+    EXPECT_EQ(7200 + 6 + 9, v.num());
+    EXPECT_EQ(inc.size(), inc.recomputed());
+    // y, x * y, and the two + above it
+    inc.set(Atom("y"), Value(5.0));
+    v = inc.eval(msg);
+    EXPECT_EQ(7200 + 10 + 9, v.num());
+    EXPECT_EQ(4u, inc.recomputed());
+    // z, z - 1 shared by both operands of *, the * and the outer +
+    inc.set(Atom("z"), Value(3.0));
+    v = inc.eval(msg);
+    EXPECT_EQ(7200 + 10 + 4, v.num());
+    EXPECT_EQ(4u, inc.recomputed());
+    v = inc.eval(msg);
+    EXPECT_EQ(0u, inc.recomputed());
+    inc.set(Atom("x"), Value());
+    EXPECT_FALSE(inc.eval(msg));
+    EXPECT_EQ("unsolvable symbol x", msg);
+}
+
+TEST(Incremental, SkippedOperand)
+{
+    Incremental inc(share(tree("x > 0 || y * 2 > 3")), EvalMode::SHORT_CIRCUIT);
+    inc.set(Atom("x"), Value(1.0));
+    std::string msg;
+    auto v = inc.eval(msg);
+    ASSERT_TRUE(static_cast<bool>(v)) << msg;
+    EXPECT_TRUE(v.b());
+    // the right operand was skipped, y is not looked at yet
+    EXPECT_EQ(4u, inc.recomputed());
+    inc.set(Atom("y"), Value(1.0));
+    v = inc.eval(msg);
+    EXPECT_TRUE(v.b());
+    EXPECT_EQ(1u, inc.recomputed());
+    inc.set(Atom("x"), Value(0.0));
+    v = inc.eval(msg);
+    EXPECT_FALSE(v.b());
+    inc.set(Atom("y"), Value(2.0));
+    v = inc.eval(msg);
+    EXPECT_TRUE(v.b());
+    EXPECT_EQ(4u, inc.recomputed());
+}
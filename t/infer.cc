@@ -0,0 +1,138 @@
+#include "../src/ast.h"
+#include "../src/dag.h"
+#include "../src/infer.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static Dag dag(const char *str)
+{
+    std::istringstream s(str);
+    auto t = Parser(s).parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t)) << str;
+    return share(t);
+}
+
+// the type of the root of str, UNKNOWN for an error
+static Ast::T root(const char *str, const Declared &declared)
+{
+    const Dag d = dag(str);
+    std::vector<Ast::T> types;
+    std::string msg;
+    if (!infer(d, declared, types, msg)) {
+        return Ast::T::UNKNOWN;
+    }
+    return types[d.root()];
+}
+
+TEST(Infer, Types)
+{
+    const Declared declared = {
+        {Atom("x"), Ast::T::NUMBER},
+        {Atom("s"), Ast::T::STRING},
+        {Atom("b"), Ast::T::BOOLEAN},
+    };
+    EXPECT_EQ(Ast::T::NUMBER, root("x + 1", declared));
+    EXPECT_EQ(Ast::T::STRING, root("s + 1", declared));
+    EXPECT_EQ(Ast::T::STRING, root("s * y", declared));
+    EXPECT_EQ(Ast::T::NUMBER, root("y - 1", declared));
+    EXPECT_EQ(Ast::T::BOOLEAN, root("x - 1 > y && b || s == y", declared));
+    const Dag d = dag("y + 1");
+    std::vector<Ast::T> types;
+    std::string msg;
+    ASSERT_TRUE(infer(d, declared, types, msg));
+    EXPECT_EQ(Ast::T::UNKNOWN, types[d.root()]);
+    const char *const wrong[][2] = {
+        {"x + b", "cannot add number and boolean"},
+        {"!x", "cannot apply ! on number"},
+        {"-(y == 1)", "cannot negate boolean"},
+        {"b && y + 1", "cannot apply && on boolean and number or string"},
+        {"s * s", "cannot multiply string and string"},
+        {"(1 < x) == s", "cannot apply == on boolean and string"},
+        {"b * y", "cannot multiply boolean and any value"},
+    };
+    for (const auto &w : wrong) {
+        const Dag e = dag(w[0]);
+        msg.clear();
+        EXPECT_FALSE(infer(e, declared, types, msg)) << w[0];
+        EXPECT_EQ(w[1], msg) << w[0];
+    }
+}
+
+TEST(Infer, TypedCodes)
+{
+    const Declared declared = {
+        {Atom("x"), Ast::T::NUMBER},
+        {Atom("y"), Ast::T::NUMBER},
+        {Atom("s"), Ast::T::STRING},
+    };
+    const Dag d = dag("-x * 2 % y > +y && s != \"a\" || !(x == 1)");
+    std::vector<Ast::T> types;
+    std::string msg;
+    ASSERT_TRUE(infer(d, declared, types, msg)) << msg;
+    const Program p = compile(d, types);
+    for (const auto &i : p.code) {
+        EXPECT_TRUE(i.code == Program::Code::CONST || i.code != untyped(i.code))
+            << static_cast<int>(i.code);
+    }
+}
+
+TEST(Infer, SameAsUntyped)
+{
+    const Value values[] = {
+        Value(0.0), Value(1.0), Value(-2.5), Value(true), Value(false),
+        Value(std::string("a")),
+        Value(std::string("a string too long to be kept inline")),
+    };
+    for (const auto str : evalCorpus) {
+        const Dag d = dag(str);
+        for (const auto t : {Ast::T::NUMBER, Ast::T::STRING, Ast::T::BOOLEAN}) {
+            const Declared declared = {{Atom("a"), t}};
+            std::vector<Ast::T> types;
+            std::string msg;
+            const bool typed = infer(d, declared, types, msg);
+            for (const auto mode
+                : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}
+            ) {
+                const Program p = compile(d, mode);
+                const Program q = typed ? compile(d, types, mode) : p;
+                for (const auto &a : values) {
+                    Value::Dict dict;
+                    dict["a"] = a;
+                    dict["a.f()"] = Value(2.0);
+                    std::string want, got;
+                    const auto v = run(p, dict, want);
+                    const auto w = run(q, dict, got);
+                    if (a.t() != t) {
+                        // a value the declaration rules out
+                        EXPECT_TRUE(!w || v.t() == w.t()) << str;
+                        continue;
+                    }
+                    if (!typed) {
+                        // rejected expressions fail for every value unless
+                        // the failing part is skipped
+                        EXPECT_TRUE(!v || mode == EvalMode::SHORT_CIRCUIT)
+                            << str;
+                        continue;
+                    }
+                    ASSERT_EQ(v.t(), w.t()) << str;
+                    if (!v) {
+                        EXPECT_EQ(want, got) << str;
+                    } else if (v.t() == Ast::T::NUMBER && v.num() == v.num()) {
+                        EXPECT_EQ(v.num(), w.num()) << str;
+                    } else if (v.t() == Ast::T::BOOLEAN) {
+                        EXPECT_EQ(v.b(), w.b()) << str;
+                    } else if (v.t() == Ast::T::STRING) {
+                        EXPECT_EQ(v.str(), w.str()) << str;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include "../src/interface.h"
 
 #include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST(Interface, MixedTest)
 {
@@ -15,9 +18,375 @@ TEST(Interface, MixedTest)
 TEST(Interface, MixedFailedTest)
 {
     for (auto str : {
-        "a 1", "b!2", "1**2", "1+2)", "1^^2", "f(", "(1+2", "\"" ""}
+        "a 1", "b!2", "1**2", "1+2)", "1^^2", "f(", "(1+2", "\"" "",
+        "-", "+", "!", "1+-", "a^-", "(-)"}
         ) {
         Expression e(str);
         EXPECT_FALSE(e) << str;
     }
 }
+
+TEST(Interface, ParseBuffer)
+{
+    const std::string str("1+2+3 trailing");
+    Expression e(str.data(), 5);
+    EXPECT_TRUE(e) << e.msg();
+    auto v = e.eval(Expression::Dict());
+    EXPECT_TRUE(static_cast<bool>(v.first));
+    EXPECT_EQ(6, v.first->getValueReal());
+    EXPECT_FALSE(e.parse(str.data(), str.size()));
+}
+
+TEST(Interface, ShortCircuitMode)
+{
+    Expression e("x > 1 || y == \"never bound\"");
+    EXPECT_TRUE(e);
+    EXPECT_EQ(Expression::Mode::STRICT, e.mode());
+    auto x = std::make_shared<parameter>(PT_REAL);
+    x->setValueReal(2);
+    Expression::Dict d;
+    d["x"] = x;
+    EXPECT_FALSE(static_cast<bool>(e.eval(d).first));
+    e.setMode(Expression::Mode::SHORT_CIRCUIT);
+    auto v = e.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    x->setValueReal(0);
+    EXPECT_FALSE(static_cast<bool>(e.eval(d).first));
+}
+
+TEST(Interface, Stats)
+{
+    Expression e("(2*3600) + x * (1/1000)");
+    EXPECT_EQ(9u, e.stats().nodes);
+    EXPECT_EQ(4u, e.stats().removed);
+    EXPECT_EQ(5u, e.stats().shared);
+    Expression f("false && x");
+    EXPECT_EQ(0u, f.stats().removed);
+    f.setMode(Expression::Mode::SHORT_CIRCUIT);
+    EXPECT_EQ(2u, f.stats().removed);
+    auto v = f.eval(Expression::Dict());
+    ASSERT_TRUE(static_cast<bool>(v.first));
+    EXPECT_EQ(0, v.first->getValueReal());
+}
+
+TEST(Interface, CommonSubexpressions)
+{
+    Expression e("(a.b(x)-c)^2 + (a.b(x)-c)*k");
+    EXPECT_EQ(11u, e.stats().nodes);
+    EXPECT_EQ(0u, e.stats().removed);
+    EXPECT_EQ(8u, e.stats().shared);
+    Expression::Dict d;
+    d["a.b(x)"] = std::make_shared<parameter>(PT_REAL);
+    d["a.b(x)"]->setValueReal(5);
+    d["c"] = std::make_shared<parameter>(PT_REAL);
+    d["c"]->setValueReal(2);
+    d["k"] = std::make_shared<parameter>(PT_REAL);
+    d["k"]->setValueReal(4);
+    auto v = e.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(9 + 3 * 4, v.first->getValueReal());
+}
+
+TEST(Interface, Slots)
+{
+    Expression e("y + x * 2 > z || x == w");
+    ASSERT_TRUE(e);
+    const std::vector<std::string> slots = {"w", "x", "y", "z"};
+    EXPECT_EQ(slots, e.slots());
+    Expression::Args args(4);
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        args[i] = std::make_shared<parameter>(PT_REAL);
+        args[i]->setValueReal(i);
+    }
+    auto v = e.eval(args);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    args[3]->setValueReal(5);
+    v = e.eval(args.data(), args.size());
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(0, v.first->getValueReal());
+    EXPECT_FALSE(static_cast<bool>(e.eval(args.data(), 3).first));
+    EXPECT_TRUE(e) << "an eval error leaves the parse state alone";
+    args[0].reset();
+    v = e.eval(args);
+    EXPECT_FALSE(static_cast<bool>(v.first));
+    EXPECT_EQ("unsolvable symbol w", v.second);
+    args[0] = std::make_shared<parameter>(PT_INTEGER);
+    EXPECT_FALSE(static_cast<bool>(e.eval(args).first));
+}
+
+TEST(Interface, SlotsSameAsDict)
+{
+    Expression e("name + \"=\" + value");
+    ASSERT_TRUE(e);
+    e.setMode(Expression::Mode::SHORT_CIRCUIT);
+    Expression::Dict d;
+    d["name"] = std::make_shared<parameter>(PT_STRING);
+    d["name"]->setValueString("a");
+    d["unused"] = std::make_shared<parameter>(PT_REAL);
+    d["value"] = std::make_shared<parameter>(PT_STRING);
+    d["value"]->setValueString("a value longer than the inline buffer");
+    const auto v = e.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    const Expression::Args args = {d["name"], d["value"]};
+    const auto w = e.eval(args);
+    ASSERT_TRUE(static_cast<bool>(w.first)) << w.second;
+    EXPECT_EQ(v.first->getValueString(), w.first->getValueString());
+    EXPECT_EQ("a=a value longer than the inline buffer",
+        w.first->getValueString());
+}
+
+TEST(Interface, ConcurrentEval)
+{
+    const Expression e("(x*3-1)^2 + (x*3-1)*y > 100 && name + x != \"\"");
+    ASSERT_TRUE(e);
+    const Expression copy(e);
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(8, 0);
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            const Expression &mine = t % 2 ? e : copy;
+            Expression::Args args(3);
+            args[0] = std::make_shared<parameter>(PT_STRING);
+            args[1] = std::make_shared<parameter>(PT_REAL);
+            args[2] = std::make_shared<parameter>(PT_REAL);
+            for (int i = 0; i < 2000; ++i) {
+                const double x = t * 2000 + i;
+                args[0]->setValueString(
+                    i % 3 ? "n" : "a name too long to be stored inline"
+                );
+                args[1]->setValueReal(x);
+                args[2]->setValueReal(i % 5 - 2);
+                const auto r = (x*3-1)*(x*3-1) + (x*3-1)*(i % 5 - 2) > 100;
+                // every fourth call fails with its own message
+                if (i % 4 == 0) {
+                    args[2].reset();
+                    const auto v = mine.eval(args);
+                    wrong[t] += v.first || v.second != "unsolvable symbol y";
+                    args[2] = std::make_shared<parameter>(PT_REAL);
+                    continue;
+                }
+                Expression::Dict d;
+                d["name"] = args[0];
+                d["x"] = args[1];
+                d["y"] = args[2];
+                const auto v = i % 2 ? mine.eval(args) : mine.eval(d);
+                wrong[t] += !v.first || v.first->getValueReal() != r;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (int t = 0; t < 8; ++t) {
+        EXPECT_EQ(0, wrong[t]) << "thread " << t;
+    }
+    EXPECT_TRUE(e);
+    EXPECT_EQ("no error", e.msg());
+}
+
+TEST(Interface, Columns)
+{
+    const Expression e("x > 2 && name == \"b\" || y");
+    ASSERT_TRUE(e);
+    const double x[] = {1, 3, 3, 5};
+    const bool y[] = {false, true, false, false};
+    const std::string names[] = {"a", "a", "b", "b"};
+    Span name[4];
+    for (int i = 0; i < 4; ++i) {
+        name[i] = Span(names[i]);
+    }
+    Expression::Columns c;
+    c["x"] = Column(x);
+    c["y"] = Column(y);
+    c["name"] = Column(name);
+    ResultColumn out;
+    e.eval(c, 4, out);
+    ASSERT_EQ(4u, out.type.size());
+    const double expected[] = {0, 1, 1, 1};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(ResultColumn::Type::BOOL, out.type[i]) << i;
+        EXPECT_EQ(expected[i], out.real[i]) << i;
+    }
+    c.erase("y");
+    e.eval(c, 4, out);
+    EXPECT_EQ(ResultColumn::Type::ERROR, out.type[0]);
+    EXPECT_EQ("unsolvable symbol y", out.str[0]);
+    Expression().eval(c, 2, out);
+    EXPECT_EQ(ResultColumn::Type::ERROR, out.type[1]);
+}
+
+TEST(Interface, Filter)
+{
+    Expression e("x != 0 && 6 / x > 2 || y");
+    ASSERT_TRUE(e);
+    const double x[] = {1, 0, 2, 4, 0};
+    const bool y[] = {false, true, true, false, false};
+    Expression::Columns c;
+    c["x"] = Column(x);
+    c["y"] = Column(y);
+    std::vector<std::uint32_t> sel;
+    e.filter(c, 5, sel);
+    EXPECT_EQ(std::vector<std::uint32_t>({0, 2}), sel);
+    e.setMode(Expression::Mode::SHORT_CIRCUIT);
+    e.filter(c, 5, sel);
+    EXPECT_EQ(std::vector<std::uint32_t>({0, 2}), sel);
+    c.erase("y");
+    e.filter(c, 5, sel);
+    EXPECT_EQ(std::vector<std::uint32_t>({0, 2}), sel);
+    e.setMode(Expression::Mode::STRICT);
+    e.filter(c, 5, sel);
+    EXPECT_TRUE(sel.empty());
+    Expression().filter(c, 5, sel);
+    EXPECT_TRUE(sel.empty());
+}
+
+TEST(Interface, Session)
+{
+    Expression e("(x*3-1)^2 + (x*3-1)*y > 100 || name == \"b\"");
+    ASSERT_TRUE(e);
+    e.setMode(Expression::Mode::SHORT_CIRCUIT);
+    Expression::Session s(e);
+    auto x = std::make_shared<parameter>(PT_REAL);
+    x->setValueReal(1);
+    auto y = std::make_shared<parameter>(PT_REAL);
+    y->setValueReal(2);
+    EXPECT_TRUE(s.set("x", x));
+    EXPECT_TRUE(s.set("y", y));
+    EXPECT_FALSE(s.set("unused", y));
+    EXPECT_FALSE(s.set("y", std::make_shared<parameter>(PT_INTEGER)));
+    auto v = s.eval();
+    EXPECT_FALSE(static_cast<bool>(v.first));
+    EXPECT_EQ("unsolvable symbol name", v.second);
+    auto name = std::make_shared<parameter>(PT_STRING);
+    name->setValueString("b");
+    s.set("name", name);
+    v = s.eval();
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    // name, the == and the ||, "b" was computed by the failed eval()
+    EXPECT_EQ(3u, s.recomputed());
+    y->setValueReal(50);
+    s.set("y", y);
+    v = s.eval();
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    // y, the * and + above it, the > and the ||
+    EXPECT_EQ(5u, s.recomputed());
+    Expression::Session none((Expression()));
+    EXPECT_FALSE(static_cast<bool>(none.eval().first));
+}
+
+TEST(Interface, Declare)
+{
+    Expression e("x * 2 > y && name != \"a\"");
+    ASSERT_TRUE(e);
+    EXPECT_TRUE(e.declare({
+        {"x", Expression::Type::REAL},
+        {"name", Expression::Type::STRING},
+    }));
+    EXPECT_TRUE(e);
+    Expression::Dict d;
+    d["x"] = std::make_shared<parameter>(PT_REAL);
+    d["x"]->setValueReal(2);
+    d["y"] = std::make_shared<parameter>(PT_REAL);
+    d["y"]->setValueReal(3);
+    d["name"] = std::make_shared<parameter>(PT_STRING);
+    d["name"]->setValueString("b");
+    auto v = e.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    d["x"] = d["name"];
+    v = e.eval(d);
+    EXPECT_FALSE(static_cast<bool>(v.first));
+    EXPECT_EQ("symbol x is not a number", v.second);
+    const Span names[] = {Span("a", 1), Span("b", 1)};
+    const double reals[] = {1, 2};
+    Expression::Columns c;
+    c["x"] = Column(names);
+    c["y"] = Column(reals);
+    c["name"] = Column(names);
+    ResultColumn out;
+    e.eval(c, 2, out);
+    EXPECT_EQ(ResultColumn::Type::ERROR, out.type[1]);
+    EXPECT_EQ("symbol x is not a number", out.str[1]);
+    c["x"] = Column(reals);
+    e.eval(c, 2, out);
+    EXPECT_EQ(ResultColumn::Type::BOOL, out.type[1]);
+    EXPECT_EQ(1, out.real[1]);
+    EXPECT_FALSE(e.declare({{"name", Expression::Type::BOOL}}));
+    EXPECT_FALSE(e);
+    EXPECT_EQ("cannot apply != on boolean and string", e.msg());
+    EXPECT_FALSE(e.parse("name + x"));
+    EXPECT_EQ("cannot add boolean and any value", e.msg());
+    EXPECT_TRUE(e.parse("name == x"));
+    EXPECT_TRUE(e.declare({}));
+    EXPECT_TRUE(e.parse("name + x"));
+    EXPECT_FALSE(Expression("1 +").declare({}));
+}
+
+TEST(Interface, Counters)
+{
+    Expression::resetCounters();
+    Expression e("x - s");
+    ASSERT_TRUE(e);
+    Expression::Dict d;
+    d["x"] = std::make_shared<parameter>(PT_REAL);
+    d["x"]->setValueReal(1);
+    d["s"] = std::make_shared<parameter>(PT_STRING);
+    d["s"]->setValueString("a");
+    EXPECT_FALSE(static_cast<bool>(e.eval(d).first));
+    ASSERT_TRUE(e.parse("x * 2 > 1 && s + 1 == \"a1\""));
+    const auto v = e.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    const auto c = Expression::counters();
+#ifdef ARIADNE_INSTRUMENT
+    // x - s and the end, then 11 tokens and the end
+    EXPECT_EQ(16u, c.tokens);
+    EXPECT_GE(c.nodes, 3u + 11u);
+    EXPECT_EQ(1u, c.typeErrors);
+    EXPECT_GT(c.parseNs, 0u);
+    EXPECT_GT(c.buildNs, 0u);
+    EXPECT_GT(c.evalNs, 0u);
+    EXPECT_EQ(15u, c.operators.size());
+    for (const char *op : {"-", "*", ">", "+", "==", "&&"}) {
+        EXPECT_EQ(1u, c.operators.at(op)) << op;
+    }
+    EXPECT_EQ(0u, c.operators.at("||"));
+    Expression::resetCounters();
+    EXPECT_EQ(0u, Expression::counters().tokens);
+#else
+    EXPECT_EQ(0u, c.tokens);
+    EXPECT_EQ(0u, c.nodes);
+    EXPECT_EQ(0u, c.evalNs);
+    EXPECT_TRUE(c.operators.empty());
+#endif
+}
+
+TEST(Interface, Profiler)
+{
+    // the text is only kept on request
+    Expression e("x * (1 + 1) > 2");
+    EXPECT_EQ("null", Expression::Profiler(e).json());
+    e.keepSource(true);
+    e.parse("x * (1 + 1) > 2");
+    Expression::Profiler p(e);
+    Expression::Dict d;
+    d["x"] = std::make_shared<parameter>(PT_REAL);
+    d["x"]->setValueReal(3);
+    const auto v = p.eval(d);
+    ASSERT_TRUE(static_cast<bool>(v.first)) << v.second;
+    EXPECT_EQ(1, v.first->getValueReal());
+    // not folded, the constant part is still a node of its own
+    EXPECT_NE(std::string::npos, p.text().find("      (1 + 1)\n"));
+    EXPECT_EQ(0u, p.json().find("{\"text\": \"x * (1 + 1) > 2\", "
+        "\"hits\": 1, \"errors\": 0"));
+    d["x"] = std::make_shared<parameter>(PT_STRING);
+    d["x"]->setValueString("a");
+    EXPECT_FALSE(static_cast<bool>(p.eval(d).first));
+    EXPECT_NE(std::string::npos, p.json().find("\"hits\": 2, \"errors\": 1"));
+    Expression::Profiler broken(Expression("1 +"));
+    EXPECT_EQ("parse failed or no given expression",
+        broken.eval(d).second);
+}
@@ -0,0 +1,85 @@
+#include "../src/intern.h"
+#include "../src/ast.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(Intern, Equal)
+{
+    const Atom a("temperature");
+    const Atom b(std::string("temperature"));
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a.id(), b.id());
+    EXPECT_NE(a, Atom("pressure"));
+    EXPECT_EQ("temperature", a.str());
+    EXPECT_EQ(0u, Atom().id());
+    EXPECT_EQ(Atom(), Atom(""));
+    EXPECT_TRUE(before(Atom("pressure"), a));
+    EXPECT_FALSE(before(a, a));
+}
+
+TEST(Intern, Find)
+{
+    Atom a;
+    EXPECT_FALSE(Atom::find(Span("never interned anywhere else"), a));
+    const std::size_t n = Atom::count();
+    EXPECT_FALSE(Atom::find(Span("never interned anywhere else"), a));
+    EXPECT_EQ(n, Atom::count());
+    const Atom b("a.f(x,y)");
+    ASSERT_TRUE(Atom::find(Span("a.f(x,y)"), a));
+    EXPECT_EQ(b, a);
+}
+
+TEST(Intern, Blocks)
+{
+    // enough strings to fill more than the first two blocks
+    std::vector<Atom> atoms;
+    for (int i = 0; i < 5000; ++i) {
+        atoms.push_back(Atom("block" + std::to_string(i)));
+    }
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ("block" + std::to_string(i), atoms[i].str());
+        EXPECT_EQ(atoms[i], Atom("block" + std::to_string(i)));
+    }
+}
+
+TEST(Intern, Concurrent)
+{
+    std::vector<std::thread> threads;
+    std::vector<std::vector<Atom> > atoms(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&atoms, t]() {
+            for (int i = 0; i < 3000; ++i) {
+                atoms[t].push_back(Atom("thread" + std::to_string(i)));
+                atoms[t].back().str();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (int i = 0; i < 3000; ++i) {
+        for (int t = 1; t < 4; ++t) {
+            EXPECT_EQ(atoms[0][i], atoms[t][i]);
+        }
+        EXPECT_EQ("thread" + std::to_string(i), atoms[0][i].str());
+    }
+}
+
+TEST(Intern, Ast)
+{
+    const auto a = Ast::makeSymbol("x.y");
+    const auto b = Ast::makeString("x.y");
+    EXPECT_EQ(a->str, b->str);
+    const auto p = Ast::Ptr(new Ast(*a));
+    EXPECT_EQ(a->str, p->str);
+    auto t = Ast::make(Ast::O::PLUS);
+    t->left = Ast::makeSymbol("b");
+    t->right = Ast::make(Ast::O::MULTIPLY);
+    t->right->left = Ast::makeSymbol("a");
+    t->right->right = Ast::makeSymbol("b");
+    const std::vector<Atom> expected = {Atom("a"), Atom("b")};
+    EXPECT_EQ(expected, atoms(t));
+}
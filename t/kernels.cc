@@ -0,0 +1,159 @@
+#include "../src/kernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <limits>
+#include <vector>
+
+namespace {
+
+const char *const tables[] = {"sse2", "avx2", "avx512"};
+
+// operands that hit NaN, the infinities, signed zeros, the edges of the
+// int conversion of % and both signs, for more lengths than any vector
+struct Operands
+{
+    Operands()
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        const double special[] = {
+            0.0, -0.0, 1, -1, 2.5, -2.5, 7, -7, 3, -3, 1e300, -1e300,
+            inf, -inf, std::nan(""), 2147483647.0, -2147483648.0,
+            2147483648.5, -2147483649.0, 0.75, -0.75, 123456789.0, 1e-300,
+        };
+        const std::size_t m = sizeof(special) / sizeof(special[0]);
+        for (std::size_t i = 0; i < m; ++i) {
+            for (std::size_t j = 0; j < m; ++j) {
+                l.push_back(special[i]);
+                r.push_back(special[j]);
+            }
+        }
+        for (int i = 0; i < 301; ++i) {
+            l.push_back(i * 7.25 - 1000);
+            r.push_back((i % 13) - 6.5 + (i % 3));
+        }
+        for (std::size_t i = 0; i < l.size(); ++i) {
+            bl.push_back(static_cast<unsigned char>(i & 1));
+            br.push_back(static_cast<unsigned char>((i >> 1) & 1));
+        }
+    }
+    std::vector<double> l, r;
+    std::vector<unsigned char> bl, br;
+};
+
+bool same(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0 || (a != a && b != b);
+}
+
+} // namespace
+
+TEST(Kernels, Find)
+{
+    const auto s = kernels::find("scalar");
+    ASSERT_TRUE(s);
+    EXPECT_STREQ("scalar", s->name);
+    EXPECT_FALSE(kernels::find("none"));
+    EXPECT_TRUE(kernels::find(kernels::active().name));
+}
+
+TEST(Kernels, Arithmetic)
+{
+    const Operands o;
+    const auto &s = *kernels::find("scalar");
+    for (const auto name : tables) {
+        const auto t = kernels::find(name);
+        if (!t) {
+            continue;
+        }
+        for (std::size_t n = 0; n <= o.l.size(); n += n < 20 ? 1 : 97) {
+            typedef std::vector<double> V;
+            V a(n), b(n), c(n), d(n);
+            std::vector<unsigned char> za(n), zb(n);
+            const double *l = o.l.data(), *r = o.r.data();
+#define CHECK(OP) \
+            s.OP(l, r, a.data(), n); t->OP(l, r, b.data(), n);\
+            for (std::size_t i = 0; i < n; ++i) {\
+                ASSERT_TRUE(same(a[i], b[i])) << name << " " #OP " "\
+                    << l[i] << " " << r[i] << " " << a[i] << " " << b[i];\
+            }
+            CHECK(add)
+            CHECK(sub)
+            CHECK(mul)
+            CHECK(pow)
+#undef CHECK
+#define CHECK(OP) \
+            s.OP(l, r, a.data(), za.data(), n);\
+            t->OP(l, r, b.data(), zb.data(), n);\
+            for (std::size_t i = 0; i < n; ++i) {\
+                ASSERT_EQ(za[i], zb[i]) << name << " " #OP " " << r[i];\
+                ASSERT_TRUE(za[i] || same(a[i], b[i])) << name << " " #OP " "\
+                    << l[i] << " " << r[i] << " " << a[i] << " " << b[i];\
+            }
+            CHECK(div)
+            CHECK(mod)
+#undef CHECK
+            s.neg(l, c.data(), n);
+            t->neg(l, d.data(), n);
+            for (std::size_t i = 0; i < n; ++i) {
+                ASSERT_TRUE(same(c[i], d[i])) << name << " neg " << l[i];
+            }
+        }
+    }
+}
+
+TEST(Kernels, Compare)
+{
+    const Operands o;
+    const auto &s = *kernels::find("scalar");
+    for (const auto name : tables) {
+        const auto t = kernels::find(name);
+        if (!t) {
+            continue;
+        }
+        for (std::size_t n = 0; n <= o.l.size(); n += n < 70 ? 1 : 97) {
+            std::vector<unsigned char> a(n), b(n);
+            const double *l = o.l.data(), *r = o.r.data();
+            const unsigned char *bl = o.bl.data(), *br = o.br.data();
+#define CHECK(OP, L, R) \
+            s.OP(L, R, a.data(), n); t->OP(L, R, b.data(), n);\
+            for (std::size_t i = 0; i < n; ++i) {\
+                ASSERT_EQ(a[i], b[i]) << name << " " #OP " " << i;\
+            }
+            CHECK(eq, l, r)
+            CHECK(ne, l, r)
+            CHECK(gt, l, r)
+            CHECK(ge, l, r)
+            CHECK(lt, l, r)
+            CHECK(le, l, r)
+            CHECK(land, bl, br)
+            CHECK(lor, bl, br)
+            CHECK(beq, bl, br)
+            CHECK(bne, bl, br)
+#undef CHECK
+            s.lnot(bl, a.data(), n);
+            t->lnot(bl, b.data(), n);
+            for (std::size_t i = 0; i < n; ++i) {
+                ASSERT_EQ(a[i], b[i]) << name << " lnot " << i;
+            }
+        }
+    }
+}
+
+TEST(Kernels, Modulo)
+{
+    const double l[] = {7, -7, 7.9, -7.9, 5, -2147483648.0, 1e10, 3};
+    const double r[] = {3, 3, -3, 2.5, -1, -1, 3, 0.5};
+    const double want[] = {1, -1, 1, -1, 0, 0, -2, 0};
+    const unsigned char zero[] = {0, 0, 0, 0, 0, 0, 0, 1};
+    double out[8];
+    unsigned char z[8];
+    kernels::mod(l, r, out, z, 8);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(zero[i], z[i]) << i;
+        if (!zero[i]) {
+            EXPECT_EQ(want[i], out[i]) << i;
+        }
+    }
+}
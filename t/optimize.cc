@@ -0,0 +1,140 @@
+#include "../src/ast.h"
+#include "../src/optimize.h"
+#include "../src/parser.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+static Ast::Ptr parse(const char *str)
+{
+    std::istringstream s(str);
+    return Parser(s).parseExpr();
+}
+
+TEST(Optimize, Count)
+{
+    EXPECT_EQ(0u, count(nullptr));
+    EXPECT_EQ(1u, count(parse("a")));
+    EXPECT_EQ(4u, count(parse("-a*2")));
+}
+
+TEST(Optimize, FoldConstants)
+{
+    auto t = parse("(2*3600) + x * (1/1000)");
+    EXPECT_EQ(4u, simplify(t));
+    EXPECT_EQ(Ast::O::PLUS, t->op);
+    EXPECT_EQ(Ast::T::NUMBER, t->left->t);
+    EXPECT_EQ(7200, t->left->num);
+    EXPECT_EQ(Ast::T::NUMBER, t->right->right->t);
+    EXPECT_EQ(0.001, t->right->right->num);
+
+    t = parse("\"a\" + 1 == \"a1\" && !false");
+    EXPECT_EQ(7u, simplify(t));
+    EXPECT_EQ(Ast::T::BOOLEAN, t->t);
+    EXPECT_TRUE(t->b);
+}
+
+TEST(Optimize, KeepFailingConstants)
+{
+    for (const auto str : {"1/0", "x + 1%0", "true + 1", "\"s\" - 1"}) {
+        auto t = parse(str);
+        const auto n = count(t);
+        EXPECT_EQ(0u, simplify(t)) << str;
+        EXPECT_EQ(n, count(t)) << str;
+    }
+}
+
+// whether an operator of p lacks its operand
+static bool missing(const Ast::Ptr &p)
+{
+    if (!p || p->t != Ast::T::OPERATOR) {
+        return false;
+    }
+    return !p->right || missing(p->left) || missing(p->right);
+}
+
+TEST(Optimize, MissingOperand)
+{
+    // trees not from the parser may lack operands, that stays so
+    for (const auto op : {Ast::O::PLUS, Ast::O::MINUS, Ast::O::LOGICAL_NOT}) {
+        auto t = Ast::make(op);
+        simplify(t);
+        EXPECT_TRUE(missing(t));
+        t = Ast::make(op);
+        t->right = Ast::make(op);
+        simplify(t);
+        EXPECT_TRUE(missing(t));
+        t = Ast::make(Ast::O::MULTIPLY);
+        t->left = Ast::make(1.0);
+        t->right = Ast::make(op);
+        simplify(t);
+        EXPECT_TRUE(missing(t));
+    }
+}
+
+TEST(Optimize, Identities)
+{
+    const char *expr[] = {
+        "(x+y)*1", "1*(x%y)", "(x-y)*1", "(x-y)/1", "(x/y)-0", "+(x-y)", "-(-(x%y))",
+        "true && x<y", "x<y && true", "false || x<y", "x<y || false",
+        "!(!(x<y))"
+    };
+    const std::size_t removed[] = {2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2};
+    for (int i = 0; i < 12; ++i) {
+        auto t = parse(expr[i]);
+        ASSERT_TRUE(t) << expr[i];
+        EXPECT_EQ(removed[i], simplify(t)) << expr[i];
+        EXPECT_NE(Ast::T::UNKNOWN, t->t) << expr[i];
+    }
+}
+
+TEST(Optimize, UnsafeIdentities)
+{
+    // a symbol may be boolean, x+0 turns -0 into 0, a string is not 0
+    for (const auto str : {
+        "x*1", "1*x", "(x+y)/1", "x+0", "x-0", "x/1", "true && x", "false || x", "!(!x)", "-(-x)",
+        "(x<y)*1", "(x+y)-0", "false && x<y", "true || x<y"
+    }) {
+        auto t = parse(str);
+        EXPECT_EQ(0u, simplify(t)) << str;
+    }
+}
+
+TEST(Optimize, ShortCircuitOnly)
+{
+    auto t = parse("(false && x) || (true || 1/0)");
+    EXPECT_EQ(0u, simplify(t));
+    EXPECT_EQ(8u, simplify(t, EvalMode::SHORT_CIRCUIT));
+    EXPECT_EQ(Ast::T::BOOLEAN, t->t);
+    EXPECT_TRUE(t->b);
+}
+
+TEST(Optimize, SameAsEval)
+{
+    Ast::Dict numbers;
+    numbers["a"] = Ast::make(2.0);
+    numbers["a.f()"] = Ast::make(1.0);
+    Ast::Dict strings;
+    strings["a"] = Ast::makeString("a");
+    for (const auto str : evalCorpus) {
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            const auto t = parse(str);
+            auto o = t->clone();
+            simplify(o, mode);
+            for (const auto d : {&numbers, &strings}) {
+                std::string emsg, omsg;
+                const auto e = eval(t, *d, emsg, mode);
+                const auto v = eval(o, *d, omsg, mode);
+                ASSERT_EQ(static_cast<bool>(e), static_cast<bool>(v)) << str;
+                EXPECT_EQ(emsg, omsg) << str;
+                if (e) {
+                    EXPECT_EQ(e->t, v->t) << str;
+                    EXPECT_EQ(e->str, v->str) << str;
+                    EXPECT_TRUE(e->t != Ast::T::NUMBER || e->num == v->num);
+                    EXPECT_TRUE(e->t != Ast::T::BOOLEAN || e->b == v->b);
+                }
+            }
+        }
+    }
+}
@@ -2,8 +2,11 @@
 #include "../src/parser.h"
 
 #include <gtest/gtest.h>
+#include <cmath>
 #include <memory>
 #include <sstream>
+#include <string>
+#include <vector>
 
 TEST(Parser, Ctor)
 {
@@ -68,7 +71,7 @@ TEST(Parser, AtomicExpr1)
     auto t = p.parseAtomicExpr();
     EXPECT_TRUE(static_cast<bool>(t));
     EXPECT_EQ(Ast::T::SYMBOL, t->t);
-    EXPECT_EQ("if(A.f(x[(2+2+a[-1])*3],(y),z).x){c;}else{b}", t->str);
+    EXPECT_EQ("if(A.f(x[(2+2+a[-1])*3],(y),z).x){c;}else{b}", t->str.str());
 }
 
 TEST(Parser, AtomicExpr1WithUnderScore)
@@ -78,7 +81,7 @@ TEST(Parser, AtomicExpr1WithUnderScore)
     auto t = p.parseAtomicExpr();
     EXPECT_TRUE(static_cast<bool>(t));
     EXPECT_EQ(Ast::T::SYMBOL, t->t);
-    EXPECT_EQ("_if(_A.f(x_[(2+2+a[-1])*3],(y),z).x){c_;}else{_b}", t->str);
+    EXPECT_EQ("_if(_A.f(x_[(2+2+a[-1])*3],(y),z).x){c_;}else{_b}", t->str.str());
 }
 
 TEST(Parser, AtomicExpr2)
@@ -98,7 +101,7 @@ TEST(Parser, AtomicExpr3)
     auto t = p.parseAtomicExpr();
     EXPECT_TRUE(static_cast<bool>(t));
     EXPECT_EQ(Ast::T::SYMBOL, t->t);
-    EXPECT_EQ("x1", t->str);
+    EXPECT_EQ("x1", t->str.str());
 }
 
 TEST(Parser, parseDeniableAtomicExpr1)
@@ -175,10 +178,10 @@ TEST(Parser, parsePotExpr1)
         EXPECT_EQ(Ast::O::POWER, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->t);
-        EXPECT_EQ("b", t->right->str);
+        EXPECT_EQ("b", t->right->str.str());
     }
 }
 
@@ -193,14 +196,14 @@ TEST(Parser, parsePotExpr2)
         EXPECT_EQ(Ast::O::POWER, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -220,14 +223,14 @@ TEST(Parser, parseMulDivModExpr1)
     EXPECT_EQ(Ast::O::POWER, l->op);
     EXPECT_TRUE(static_cast<bool>(l->left));
     EXPECT_EQ(Ast::T::SYMBOL, l->left->t);
-    EXPECT_EQ("a", l->left->str);
+    EXPECT_EQ("a", l->left->str.str());
     EXPECT_TRUE(static_cast<bool>(l->right));
     EXPECT_EQ(Ast::T::OPERATOR, l->right->t);
     EXPECT_EQ(Ast::O::MINUS, l->right->op);
     EXPECT_FALSE(static_cast<bool>(l->right->left));
     EXPECT_TRUE(static_cast<bool>(l->right->right));
     EXPECT_EQ(Ast::T::SYMBOL, l->right->right->t);
-    EXPECT_EQ("b", l->right->right->str);
+    EXPECT_EQ("b", l->right->right->str.str());
 
     const auto &r = t->right;
     EXPECT_TRUE(static_cast<bool>(r));
@@ -241,14 +244,14 @@ TEST(Parser, parseMulDivModExpr1)
     EXPECT_EQ(Ast::O::POWER, rr->op);
     EXPECT_TRUE(static_cast<bool>(rr->left));
     EXPECT_EQ(Ast::T::SYMBOL, rr->left->t);
-    EXPECT_EQ("c", rr->left->str);
+    EXPECT_EQ("c", rr->left->str.str());
     EXPECT_TRUE(static_cast<bool>(rr->right));
     EXPECT_EQ(Ast::T::OPERATOR, rr->right->t);
     EXPECT_EQ(Ast::O::MINUS, rr->right->op);
     EXPECT_FALSE(static_cast<bool>(rr->right->left));
     EXPECT_TRUE(static_cast<bool>(rr->right->right));
     EXPECT_EQ(Ast::T::SYMBOL, rr->right->right->t);
-    EXPECT_EQ("d", rr->right->right->str);
+    EXPECT_EQ("d", rr->right->right->str.str());
 }
 
 TEST(Parser, parseMulDivModExpr2)
@@ -262,14 +265,14 @@ TEST(Parser, parseMulDivModExpr2)
         EXPECT_EQ(Ast::O::MULTIPLY, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -284,14 +287,14 @@ TEST(Parser, parseMulDivModExpr3)
         EXPECT_EQ(Ast::O::DIVISION, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -309,14 +312,14 @@ TEST(Parser, parseMulDivModExpr4)
     EXPECT_EQ(Ast::O::DIVISION, t->left->op);
     EXPECT_TRUE(static_cast<bool>(t->left->left));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->left->t);
-    EXPECT_EQ("a", t->left->left->str);
+    EXPECT_EQ("a", t->left->left->str.str());
     EXPECT_TRUE(static_cast<bool>(t->left->right));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->right->t);
-    EXPECT_EQ("b", t->left->right->str);
+    EXPECT_EQ("b", t->left->right->str.str());
 
     EXPECT_TRUE(static_cast<bool>(t->right));
     EXPECT_EQ(Ast::T::SYMBOL, t->right->t);
-    EXPECT_EQ("c", t->right->str);
+    EXPECT_EQ("c", t->right->str.str());
 }
 
 TEST(Parser, parsePlusMinusExpr1)
@@ -330,14 +333,14 @@ TEST(Parser, parsePlusMinusExpr1)
         EXPECT_EQ(Ast::O::PLUS, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -352,14 +355,14 @@ TEST(Parser, parsePlusMinusExpr2)
         EXPECT_EQ(Ast::O::MINUS, t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -377,14 +380,14 @@ TEST(Parser, parsePlusMinusExpr3)
     EXPECT_EQ(Ast::O::MINUS, t->left->op);
     EXPECT_TRUE(static_cast<bool>(t->left->left));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->left->t);
-    EXPECT_EQ("a", t->left->left->str);
+    EXPECT_EQ("a", t->left->left->str.str());
     EXPECT_TRUE(static_cast<bool>(t->left->right));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->right->t);
-    EXPECT_EQ("b", t->left->right->str);
+    EXPECT_EQ("b", t->left->right->str.str());
 
     EXPECT_TRUE(static_cast<bool>(t->right));
     EXPECT_EQ(Ast::T::SYMBOL, t->right->t);
-    EXPECT_EQ("c", t->right->str);
+    EXPECT_EQ("c", t->right->str.str());
 }
 
 TEST(Parser, parseMixedSymbol1)
@@ -399,7 +402,7 @@ TEST(Parser, parseMixedSymbol1)
 
     EXPECT_TRUE(static_cast<bool>(t->left));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-    EXPECT_EQ("a.f()", t->left->str);
+    EXPECT_EQ("a.f()", t->left->str.str());
 
     EXPECT_TRUE(static_cast<bool>(t->right));
     EXPECT_EQ(Ast::T::NUMBER, t->right->t);
@@ -418,7 +421,7 @@ TEST(Parser, parseMixedSymbol2)
 
     EXPECT_TRUE(static_cast<bool>(t->left));
     EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-    EXPECT_EQ("a.function()", t->left->str);
+    EXPECT_EQ("a.function()", t->left->str.str());
 
     EXPECT_TRUE(static_cast<bool>(t->right));
     EXPECT_EQ(Ast::T::NUMBER, t->right->t);
@@ -440,14 +443,14 @@ TEST(Parser, parseCmpExpr)
         EXPECT_EQ(op[i], t->op);
         EXPECT_TRUE(static_cast<bool>(t->left));
         EXPECT_EQ(Ast::T::SYMBOL, t->left->t);
-        EXPECT_EQ("a", t->left->str);
+        EXPECT_EQ("a", t->left->str.str());
         EXPECT_TRUE(static_cast<bool>(t->right));
         EXPECT_EQ(Ast::T::OPERATOR, t->right->t);
         EXPECT_EQ(Ast::O::MINUS, t->right->op);
         EXPECT_FALSE(static_cast<bool>(t->right->left));
         EXPECT_TRUE(static_cast<bool>(t->right->right));
         EXPECT_EQ(Ast::T::SYMBOL, t->right->right->t);
-        EXPECT_EQ("b", t->right->right->str);
+        EXPECT_EQ("b", t->right->right->str.str());
     }
 }
 
@@ -462,3 +465,123 @@ TEST(Parser, parseExpr)
         EXPECT_EQ(Ast::O::LOGICAL_OR, t->op) << str;
     }
 }
+
+TEST(Parser, BufferToken)
+{
+    const std::string str("A.f(x,y) 3.14e-2 + (\"wu\" - 4) /r!\t ");
+    auto p = Parser(str.data(), str.size());
+    EXPECT_EQ(Parser::TK::SYMBOL, p.token());
+    EXPECT_EQ(Parser::TK::NUMBER, p.token());
+    EXPECT_EQ(Parser::TK::OP, p.token());
+    EXPECT_EQ(Parser::TK::BRACKET_OPEN, p.token());
+    EXPECT_EQ(Parser::TK::STRING, p.token());
+    EXPECT_EQ(Parser::TK::OP, p.token());
+    EXPECT_EQ(Parser::TK::NUMBER, p.token());
+    EXPECT_EQ(Parser::TK::BRACKET_CLOSE, p.token());
+    EXPECT_EQ(Parser::TK::OP, p.token());
+    EXPECT_EQ(Parser::TK::SYMBOL, p.token());
+    EXPECT_EQ(Parser::TK::OP, p.token());
+    EXPECT_EQ(Parser::TK::END, p.token());
+}
+
+TEST(Parser, LexerSpans)
+{
+    const std::string str("a.f(x, \")\") \"wu\" 12.5e1");
+    Lexer l(str.data(), str.size());
+    Lexer::Token tok;
+    std::string msg;
+    EXPECT_EQ(Lexer::TK::SYMBOL, l.next(tok, msg));
+    EXPECT_EQ(str.data(), tok.text.p);
+    EXPECT_EQ("a.f(x, \")\")", tok.text.str());
+    EXPECT_EQ(Lexer::TK::STRING, l.next(tok, msg));
+    EXPECT_EQ(str.data() + 13, tok.text.p);
+    EXPECT_EQ("wu", tok.text.str());
+    EXPECT_EQ(Lexer::TK::NUMBER, l.next(tok, msg));
+    EXPECT_EQ("12.5e1", tok.text.str());
+    EXPECT_DOUBLE_EQ(125, tok.num);
+    EXPECT_EQ(Lexer::TK::END, l.next(tok, msg));
+}
+
+TEST(Parser, LexerNumbers)
+{
+    // the values strtod() gives, also past the range of double
+    const std::string str("0.1 1e400 1e-400 0.000e999 00012.50 "
+        "17976931348623158e292 4.9e-324 123456789012345678901234567890");
+    Lexer l(str.data(), str.size());
+    Lexer::Token tok;
+    std::string msg;
+    for (const double want : {
+        0.1, HUGE_VAL, 0.0, 0.0, 12.5, 1.7976931348623158e308, 4.9e-324,
+        123456789012345678901234567890.0
+    }) {
+        ASSERT_EQ(Lexer::TK::NUMBER, l.next(tok, msg)) << msg;
+        EXPECT_EQ(want, tok.num) << tok.text.str();
+    }
+    EXPECT_EQ(Lexer::TK::END, l.next(tok, msg));
+}
+
+TEST(Parser, LexerNormalizedSymbol)
+{
+    const std::string str("a (x) .b");
+    Lexer l(str.data(), str.size());
+    Lexer::Token tok;
+    std::string msg;
+    EXPECT_EQ(Lexer::TK::SYMBOL, l.next(tok, msg));
+    EXPECT_EQ("a(x).b", tok.text.str());
+    EXPECT_EQ(Lexer::TK::END, l.next(tok, msg));
+}
+
+TEST(Parser, BufferNotTerminated)
+{
+    // only the first three characters belong to the expression
+    const char str[] = {'1', '+', '2', '3', '4'};
+    auto p = Parser(str, 3);
+    auto t = p.parseExpr();
+    EXPECT_TRUE(static_cast<bool>(t));
+    EXPECT_EQ(Ast::O::PLUS, t->op);
+    EXPECT_EQ(2, t->right->num);
+    EXPECT_TRUE(p.eof());
+}
+
+// the text of every node in preorder
+static void texts(const Ast::Ptr &p, const std::string &s,
+    std::vector<std::string> &out)
+{
+    if (p) {
+        out.push_back(s.substr(p->at, p->n));
+        texts(p->left, s, out);
+        texts(p->right, s, out);
+    }
+}
+
+TEST(Parser, Positions)
+{
+    const std::string s = " -a.f (x) * (2+b)^3 >= \"s t\" && !true";
+    const auto t = Parser(s.data(), s.size()).parseExpr();
+    ASSERT_TRUE(static_cast<bool>(t));
+    std::vector<std::string> out;
+    texts(t, s, out);
+    EXPECT_EQ(std::vector<std::string>({
+        "-a.f (x) * (2+b)^3 >= \"s t\" && !true",
+        "-a.f (x) * (2+b)^3 >= \"s t\"",
+        "-a.f (x) * (2+b)^3",
+        "-a.f (x)", "a.f (x)", "(2+b)^3", "(2+b)", "2", "b", "3",
+        "\"s t\"", "!true", "true",
+    }), out);
+}
+
+TEST(Parser, MissingOperand)
+{
+    // a unary operator without operand fails instead of giving a node
+    // missing it
+    for (const auto str : {"-", "+", "!", "1+-", "a^-", "(-)", "!!", "-(+)"}) {
+        const std::string s = str;
+        auto p = Parser(s.data(), s.size());
+        EXPECT_FALSE(static_cast<bool>(p.parseExpr())) << str;
+        EXPECT_FALSE(p.msg().empty()) << str;
+    }
+    const std::string s = "1+-";
+    auto p = Parser(s.data(), s.size());
+    EXPECT_FALSE(static_cast<bool>(p.parseExpr()));
+    EXPECT_EQ(0u, p.msg().find("unexpected end")) << p.msg();
+}
@@ -0,0 +1,73 @@
+#include "../src/profile.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+TEST(Profile, Records)
+{
+    Profile p("x * 2 > 1 && s == \"a\"", EvalMode::SHORT_CIRCUIT);
+    ASSERT_TRUE(static_cast<bool>(p));
+    Value::Dict dict;
+    dict["s"] = Value(std::string("a"));
+    for (int i = 0; i < 10; ++i) {
+        dict["x"] = Value(static_cast<double>(i));
+        std::string msg;
+        const Value v = p.eval(dict, msg);
+        ASSERT_TRUE(static_cast<bool>(v)) << msg;
+        EXPECT_EQ(i > 0, v.b());
+    }
+    dict["x"] = Value(std::string("x"));
+    std::string msg;
+    EXPECT_FALSE(p.eval(dict, msg));
+    EXPECT_EQ("cannot apply >on string and number", msg);
+
+    const Ast &root = *p.root();
+    EXPECT_EQ(11u, p.node(root).hits);
+    EXPECT_EQ(1u, p.node(root).errors);
+    EXPECT_EQ(10u, p.node(root).booleans);
+    // x = 0 and the error skip the right operand
+    EXPECT_EQ(9u, p.node(*root.right).hits);
+    EXPECT_EQ(1u, p.node(*root.left).errors);
+    // "x" * 2 repeats the string
+    const Ast &mul = *root.left->left;
+    EXPECT_EQ(11u, p.node(mul).hits);
+    EXPECT_EQ(10u, p.node(mul).numbers);
+    EXPECT_EQ(1u, p.node(mul).strings);
+    EXPECT_EQ(0u, p.node(mul).errors);
+    EXPECT_EQ(1u, p.node(*mul.left).strings);
+    EXPECT_GE(p.node(root).ns, p.node(mul).ns);
+
+    const std::string text = p.text();
+    EXPECT_NE(std::string::npos, text.find(
+        "        11        1"));
+    EXPECT_NE(std::string::npos, text.find("  x * 2 > 1 && s == \"a\"\n"));
+    EXPECT_NE(std::string::npos, text.find("      x * 2\n"));
+    EXPECT_NE(std::string::npos, text.find("        x\n"));
+    const std::string json = p.json();
+    EXPECT_EQ(0u, json.find("{\"text\": \"x * 2 > 1 && s == \\\"a\\\"\", "
+        "\"hits\": 11, \"errors\": 1, \"ns\": "));
+    EXPECT_NE(std::string::npos, json.find("{\"text\": \"s == \\\"a\\\"\", "
+        "\"hits\": 9, \"errors\": 0, \"ns\": "));
+    EXPECT_NE(std::string::npos, json.find("\"types\": {\"number\": 0, "
+        "\"string\": 9, \"boolean\": 0}}"));
+}
+
+TEST(Profile, Strict)
+{
+    Profile p("(a || b) || -1", EvalMode::STRICT);
+    ASSERT_TRUE(static_cast<bool>(p));
+    Value::Dict dict;
+    dict["a"] = Value(true);
+    std::string msg;
+    EXPECT_FALSE(p.eval(dict, msg));
+    EXPECT_EQ("unsolvable symbol b", msg);
+    const Ast &root = *p.root();
+    // the right operand goes first, the error of b stops at the left one
+    EXPECT_EQ(1u, p.node(*root.right).numbers);
+    EXPECT_EQ(1u, p.node(*root.left).errors);
+    EXPECT_EQ(0u, p.node(*root.left->left).hits);
+    EXPECT_NE(std::string::npos, p.text().find("  (a || b)\n"));
+    EXPECT_FALSE(Profile("1 +", EvalMode::STRICT));
+    EXPECT_FALSE(Profile("1 2", EvalMode::STRICT));
+    EXPECT_EQ("null", Profile("", EvalMode::STRICT).json());
+}
@@ -0,0 +1,153 @@
+#include "../src/rules.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::shared_ptr<parameter> real(double v)
+{
+    auto p = std::make_shared<parameter>(PT_REAL);
+    p->setValueReal(v);
+    return p;
+}
+
+static std::shared_ptr<parameter> string(const std::string &v)
+{
+    auto p = std::make_shared<parameter>(PT_STRING);
+    p->setValueString(v);
+    return p;
+}
+
+// what eval() on every rule finds, booleans come back as numbers
+static std::vector<RuleSet::Id> scan(
+    const std::vector<Expression> &rules,
+    const Expression::Dict &event
+)
+{
+    std::vector<RuleSet::Id> ids;
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+        const auto v = rules[i].eval(event);
+        if (v.first && v.first->getValueReal() == 1) {
+            ids.push_back(i);
+        }
+    }
+    return ids;
+}
+
+TEST(RuleSet, SameAsEval)
+{
+    std::vector<Expression> rules;
+    const char *ops[] = {"==", "!=", "<", "<=", ">", ">="};
+    for (int i = 0; i < 200; ++i) {
+        const std::string op = ops[i % 6];
+        const std::string c = std::to_string(i % 7);
+        std::string s = i % 2 ? "x " + op + " " + c : c + " " + op + " x";
+        switch (i % 5) {
+            case 0:
+                s += " && name == \"" + std::to_string(i % 3) + "\"";
+                break;
+            case 1:
+                s += " && (y > " + c + " || name != \"0\")";
+                break;
+            case 2:
+                s = "y - x >= -0 && " + s;
+                break;
+            case 3:
+                s = "(" + s + ") == (y < 3)";
+                break;
+        }
+        rules.emplace_back(s);
+        ASSERT_TRUE(rules.back()) << s;
+        if (i % 3 == 0) {
+            rules.back().setMode(Expression::Mode::SHORT_CIRCUIT);
+        }
+    }
+    RuleSet set;
+    for (const auto &e : rules) {
+        set.add(e);
+    }
+    ASSERT_EQ(rules.size(), set.size());
+    std::vector<RuleSet::Id> matched;
+    for (int i = 0; i < 100; ++i) {
+        Expression::Dict event;
+        event["x"] = real(i % 9 - 1);
+        if (i % 4) {
+            event["y"] = real(i % 5);
+        }
+        if (i % 3) {
+            event["name"] = string(std::to_string(i % 4));
+        }
+        if (i % 7 == 0) {
+            event["name"] = real(0);
+        }
+        const std::size_t evaluated = set.match(event, matched);
+        EXPECT_EQ(scan(rules, event), matched) << i;
+        EXPECT_GE(evaluated, matched.size());
+        EXPECT_LT(evaluated, rules.size()) << i;
+    }
+}
+
+TEST(RuleSet, Pruned)
+{
+    RuleSet set;
+    const auto a = set.add(Expression("x == 1 && name == \"a\""));
+    const auto b = set.add(Expression("2 < x && x <= 4"));
+    const auto c = set.add(Expression("x > 0 && y * 2 > 1"));
+    Expression sc("x > 0 || never");
+    sc.setMode(Expression::Mode::SHORT_CIRCUIT);
+    const auto d = set.add(sc);
+    set.add(Expression("broken &&"));
+    EXPECT_EQ(5u, set.size());
+    Expression::Dict event;
+    event["x"] = real(1);
+    event["name"] = string("a");
+    event["unused"] = real(0);
+    std::vector<RuleSet::Id> matched;
+    // c lacks y, the others need no evaluation to be rejected
+    EXPECT_EQ(2u, set.match(event, matched));
+    EXPECT_EQ(std::vector<RuleSet::Id>({a, d}), matched);
+    event["x"] = real(4);
+    event["y"] = real(1);
+    EXPECT_EQ(3u, set.match(event, matched));
+    EXPECT_EQ(std::vector<RuleSet::Id>({b, c, d}), matched);
+    event["name"] = string("a string no rule compares with");
+    EXPECT_EQ(3u, set.match(event, matched));
+    event["x"] = real(-1);
+    EXPECT_EQ(1u, set.match(event, matched));
+    EXPECT_TRUE(matched.empty());
+    event["y"] = std::make_shared<parameter>(PT_INTEGER);
+    EXPECT_EQ(0u, set.match(event, matched));
+    EXPECT_TRUE(matched.empty());
+}
+
+TEST(RuleSet, WideEvent)
+{
+    // rules on a few of many fields, and events that lack some of them
+    std::vector<Expression> rules;
+    RuleSet set;
+    for (int i = 0; i < 100; ++i) {
+        const std::string f = "f" + std::to_string(i * 3);
+        const std::string g = "f" + std::to_string(i * 3 + 1);
+        rules.emplace_back(f + " > " + std::to_string(i) + " && " + g
+            + " * 2 == " + f + " - 1");
+        set.add(rules.back());
+    }
+    std::vector<RuleSet::Id> matched;
+    for (int n = 0; n < 4; ++n) {
+        Expression::Dict event;
+        for (int i = 0; i < 300; ++i) {
+            if (n == 0 || i % (n + 1)) {
+                event["f" + std::to_string(i)] = real(i % 3 ? i / 3 : 0);
+            }
+        }
+        for (int i = 0; i < 300; i += 3) {
+            if (event.count("f" + std::to_string(i))) {
+                event["f" + std::to_string(i)] = real(i / 3 * 2 + 1);
+            }
+        }
+        set.match(event, matched);
+        EXPECT_EQ(scan(rules, event), matched) << n;
+        EXPECT_FALSE(matched.empty() && n == 0);
+    }
+}
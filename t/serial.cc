@@ -0,0 +1,186 @@
+#include "../src/interface.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// every slot bound to 2, the results compared by type, value and message
+static void expectSame(const Expression &a, const Expression &b)
+{
+    EXPECT_EQ(static_cast<bool>(a), static_cast<bool>(b));
+    EXPECT_EQ(a.msg(), b.msg());
+    EXPECT_EQ(a.mode(), b.mode());
+    EXPECT_EQ(a.slots(), b.slots());
+    EXPECT_EQ(a.stats().nodes, b.stats().nodes);
+    EXPECT_EQ(a.stats().removed, b.stats().removed);
+    EXPECT_EQ(a.stats().shared, b.stats().shared);
+    if (!a) {
+        return;
+    }
+    Expression::Args args;
+    for (std::size_t i = 0; i < a.slots().size(); ++i) {
+        args.push_back(std::make_shared<parameter>(PT_REAL));
+        args.back()->setValueReal(2);
+    }
+    const auto x = a.eval(args);
+    const auto y = b.eval(args);
+    EXPECT_EQ(x.second, y.second);
+    ASSERT_EQ(static_cast<bool>(x.first), static_cast<bool>(y.first));
+    if (x.first) {
+        ASSERT_EQ(x.first->getType(), y.first->getType());
+        if (x.first->getType() == PT_REAL) {
+            EXPECT_EQ(x.first->getValueReal(), y.first->getValueReal());
+        } else {
+            EXPECT_EQ(x.first->getValueString(), y.first->getValueString());
+        }
+    }
+}
+
+static void roundTrip(const std::vector<Expression> &expressions)
+{
+    const std::string data = Expression::save(expressions);
+    std::vector<Expression> loaded;
+    ASSERT_TRUE(Expression::load(data.data(), data.size(), loaded));
+    ASSERT_EQ(expressions.size(), loaded.size());
+    for (std::size_t i = 0; i < loaded.size(); ++i) {
+        SCOPED_TRACE(i);
+        expectSame(expressions[i], loaded[i]);
+    }
+    EXPECT_EQ(data, Expression::save(loaded));
+}
+
+TEST(Serial, ParserCorpus)
+{
+    std::vector<Expression> expressions;
+    for (const auto str : parserCorpus) {
+        expressions.emplace_back(str);
+    }
+    roundTrip(expressions);
+}
+
+TEST(Serial, EvalCorpus)
+{
+    std::vector<Expression> expressions;
+    for (const auto str : evalCorpus) {
+        expressions.emplace_back(str);
+        expressions.emplace_back(str);
+        expressions.back().setMode(Expression::Mode::SHORT_CIRCUIT);
+    }
+    roundTrip(expressions);
+}
+
+TEST(Serial, Declared)
+{
+    std::vector<Expression> expressions(2);
+    expressions[0].parse("name == \"a\" && x > 1");
+    EXPECT_TRUE(expressions[0].declare({
+        {"name", Expression::Type::STRING},
+        {"x", Expression::Type::REAL},
+    }));
+    expressions[1].parse("-name");
+    EXPECT_FALSE(expressions[1].declare({
+        {"name", Expression::Type::STRING},
+    }));
+    roundTrip(expressions);
+
+    const std::string data = Expression::save(expressions);
+    std::vector<Expression> loaded;
+    ASSERT_TRUE(Expression::load(data.data(), data.size(), loaded));
+    // the declared types still reject values of other types
+    auto name = std::make_shared<parameter>(PT_REAL);
+    name->setValueReal(1);
+    auto x = std::make_shared<parameter>(PT_REAL);
+    x->setValueReal(1);
+    const Expression::Args args = {name, x};
+    EXPECT_FALSE(static_cast<bool>(loaded[0].eval(args).first));
+}
+
+TEST(Serial, Source)
+{
+    std::vector<Expression> expressions(1);
+    expressions[0].keepSource(true);
+    expressions[0].parse("a * 2 + 1");
+    std::vector<Expression> loaded;
+    std::string data = Expression::save(expressions);
+    ASSERT_TRUE(Expression::load(data.data(), data.size(), loaded));
+    Expression::Profiler p(loaded[0]);
+    EXPECT_NE(std::string::npos, p.text().find("a * 2 + 1"));
+    // a loaded text is kept again by the next parse()
+    loaded[0].parse("a + 1");
+    EXPECT_EQ(0u, Expression::Profiler(loaded[0]).json().find(
+        "{\"text\": \"a + 1\""));
+    // an Expression that did not keep its text saves none
+    EXPECT_EQ(Expression::save(std::vector<Expression>(1,
+        Expression("a * 2 + 1")), true), Expression::save(expressions, false));
+
+    const std::string bare = Expression::save(expressions, false);
+    EXPECT_EQ(data.size(), bare.size() + 9);
+    ASSERT_TRUE(Expression::load(bare.data(), bare.size(), loaded));
+    expectSame(expressions[0], loaded[0]);
+    EXPECT_EQ("null", Expression::Profiler(loaded[0]).json());
+}
+
+TEST(Serial, Invalid)
+{
+    const std::vector<Expression> expressions(1, Expression("a+1"));
+    const std::string data = Expression::save(expressions);
+    std::vector<Expression> loaded(3);
+    for (std::size_t n = 0; n < data.size(); ++n) {
+        EXPECT_FALSE(Expression::load(data.data(), n, loaded)) << n;
+    }
+    EXPECT_FALSE(Expression::load((data + '\0').data(), data.size() + 1,
+        loaded));
+    std::string other = data;
+    other[4] = 2;
+    EXPECT_FALSE(Expression::load(other.data(), other.size(), loaded));
+    EXPECT_EQ(3u, loaded.size());
+    EXPECT_TRUE(Expression::load(data.data(), data.size(), loaded));
+    EXPECT_EQ(1u, loaded.size());
+
+    // the tree of "1" swapped for operators missing operands they need
+    const std::string one = Expression::save(
+        std::vector<Expression>(1, Expression("1")));
+    const std::string number = one.substr(one.size() - 9);
+    for (const auto &tree : {
+        std::string("\x06\x00\x00\x00", 4),
+        std::string("\x06\x01\x00\x00", 4),
+        std::string("\x06\x01", 2) + number + std::string(1, '\0'),
+        std::string("\x06\x02\x00", 3) + number,
+        std::string("\x06\x01\x00\x06\x02\x00", 6) + number,
+        std::string("\x06\x08", 2) + number + number
+    }) {
+        other = one.substr(0, one.size() - 9) + tree;
+        EXPECT_FALSE(Expression::load(other.data(), other.size(), loaded));
+    }
+    other = one.substr(0, one.size() - 9)
+        + std::string("\x06\x01\x00", 3) + number;
+    ASSERT_TRUE(Expression::load(other.data(), other.size(), loaded));
+    EXPECT_EQ(-1, loaded[0].eval(Expression::Args()).first->getValueReal());
+}
+
+TEST(Serial, Deep)
+{
+    // a chain of operators as deep as the Reader takes loads, one more
+    // term and save() refuses it
+    std::string text = "x";
+    for (int i = 1; i < 4096; ++i) {
+        text += "+x";
+    }
+    roundTrip(std::vector<Expression>(1, Expression(text)));
+    const std::vector<Expression> deeper(1, Expression(text + "+x"));
+    ASSERT_TRUE(deeper[0]);
+    EXPECT_EQ("", Expression::save(deeper));
+
+    // a record of nested operators that never ends is refused, and does
+    // not run out of stack reading or freeing it
+    std::string data = Expression::save(std::vector<Expression>());
+    data.back() = 1;
+    data += std::string("\x00\x01\x00\x00\x00\x00\x00", 7);
+    for (int i = 0; i < 2000000; ++i) {
+        data += std::string("\x06\x00", 2);
+    }
+    std::vector<Expression> loaded;
+    EXPECT_FALSE(Expression::load(data.data(), data.size(), loaded));
+    EXPECT_TRUE(loaded.empty());
+}
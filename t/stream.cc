@@ -0,0 +1,239 @@
+#include "../src/rows.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the output of the stages for the lines after the header, the way the
+// stream tool runs them on one chunk
+static std::string run(
+    bool ndjson,
+    const std::string &header,
+    const std::vector<std::string> &lines,
+    const std::vector<std::string> &exprs,
+    std::size_t *bad = nullptr
+)
+{
+    rows::Options o;
+    o.ndjson = ndjson;
+    o.expressions = exprs;
+    std::vector<Expression> expressions;
+    std::set<std::string> symbols;
+    for (const auto &str : exprs) {
+        expressions.emplace_back(str);
+        const auto s = expressions.back().symbols();
+        symbols.insert(s.begin(), s.end());
+    }
+    rows::Layout layout;
+    layout.symbols.assign(symbols.begin(), symbols.end());
+    for (std::size_t i = 0; i < layout.symbols.size(); ++i) {
+        layout.index[layout.symbols[i]] = i;
+    }
+    std::vector<std::vector<std::size_t> > slots;
+    for (const auto &e : expressions) {
+        slots.emplace_back();
+        for (const auto &s : e.slots()) {
+            slots.back().push_back(layout.index[s]);
+        }
+    }
+    if (!ndjson) {
+        std::vector<rows::Field> fields;
+        std::deque<std::string> decoded;
+        rows::csv(header, fields, decoded);
+        for (const auto &f : fields) {
+            const auto i = layout.index.find(f.text.str());
+            layout.csv.push_back(
+                i == layout.index.end() ? rows::Layout::NONE : i->second);
+        }
+    }
+    rows::Chunk c;
+    c.lines = lines;
+    rows::parse(o, layout, c);
+    rows::eval(expressions, slots, layout, c);
+    std::vector<std::size_t> errors(expressions.size());
+    std::string out;
+    rows::write(o, c, errors, out);
+    if (bad) {
+        *bad = std::count(c.bad.begin(), c.bad.end(), true);
+    }
+    return out;
+}
+
+TEST(Stream, CsvFields)
+{
+    std::vector<rows::Field> fields;
+    std::deque<std::string> decoded;
+    const std::string line = "1,\"a \"\"b\"\", c\",\"\",,plain \"x\"";
+    rows::csv(line, fields, decoded);
+    ASSERT_EQ(5u, fields.size());
+    EXPECT_EQ("1", fields[0].text.str());
+    EXPECT_FALSE(fields[0].quoted);
+    EXPECT_EQ("a \"b\", c", fields[1].text.str());
+    EXPECT_TRUE(fields[1].quoted);
+    EXPECT_EQ("", fields[2].text.str());
+    EXPECT_TRUE(fields[2].quoted);
+    EXPECT_EQ("", fields[3].text.str());
+    EXPECT_FALSE(fields[3].quoted);
+    EXPECT_EQ("plain \"x\"", fields[4].text.str());
+    EXPECT_FALSE(fields[4].quoted);
+
+    // a quoted field goes on in the next line until its " comes
+    EXPECT_FALSE(rows::openQuote(""));
+    EXPECT_FALSE(rows::openQuote("1,\"a\",plain \"x"));
+    EXPECT_FALSE(rows::openQuote("\"a \"\"b\"\"\",\"\""));
+    EXPECT_TRUE(rows::openQuote("1,\"a"));
+    EXPECT_TRUE(rows::openQuote("\"a\"\""));
+    EXPECT_TRUE(rows::openQuote("\"a\"x,\""));
+    const std::string lines = "\"a\nb\",1";
+    rows::csv(lines, fields, decoded);
+    ASSERT_EQ(2u, fields.size());
+    EXPECT_EQ("a\nb", fields[0].text.str());
+
+    // a quoted field is a string even if it reads as a number, "" in the
+    // output stands for "
+    EXPECT_EQ("\"a \"\"b\"\", c!\",\"1!\"\n",
+        run(false, "s,t", {"\"a \"\"b\"\", c\",\"1\""},
+            {"s + \"!\"", "t + \"!\""}));
+}
+
+TEST(Stream, JsonEscapes)
+{
+    const std::string line = "{\"s\": \"a\\u00e9\\n\\\"\\\\\\/\", \"x\": -2.5,"
+        " \"b\": true, \"n\": null, \"o\": {\"k\": [1, \"]\"]}}";
+    std::deque<std::string> decoded;
+    rows::Json json(line, decoded);
+    std::vector<std::pair<std::string, rows::Kind> > members;
+    std::string s;
+    double x = 0;
+    ASSERT_TRUE(json.object([&](Span k, rows::Kind kind, Span str,
+        double real) {
+        members.emplace_back(k.str(), kind);
+        if (k.str() == "s") {
+            s = str.str();
+        } else if (k.str() == "x") {
+            x = real;
+        }
+    }));
+    ASSERT_EQ(5u, members.size());
+    EXPECT_EQ(rows::STRING, members[0].second);
+    EXPECT_EQ("a\xc3\xa9\n\"\\/", s);
+    EXPECT_EQ(rows::REAL, members[1].second);
+    EXPECT_EQ(-2.5, x);
+    EXPECT_EQ(rows::BOOL, members[2].second);
+    EXPECT_EQ(rows::MISSING, members[3].second);
+    EXPECT_EQ(rows::MISSING, members[4].second);
+
+    for (const auto bad : {"{\"s\": \"\\u00e\"}", "{\"s\": 1", "[1]",
+        "{\"s\": 1} x"}) {
+        const std::string l = bad;
+        rows::Json j(l, decoded);
+        EXPECT_FALSE(j.object([](Span, rows::Kind, Span, double) {}))
+            << bad;
+    }
+
+    // control characters are escaped in the output
+    EXPECT_EQ("[\"a\\u000a\\\"\"]\n",
+        run(true, "", {"{\"s\": \"a\\n\\\"\"}"}, {"s"}));
+}
+
+TEST(Stream, MixedKinds)
+{
+    // the kinds of x differ from row to row, so the rows are evaluated in
+    // groups and put back in their order
+    const std::vector<std::string> lines = {
+        "1,a", "\"b\",c", "2.5,d", "true,e", ",f", "3,\"g\""
+    };
+    EXPECT_EQ(
+        "2,\"a1\"\n"
+        "\"bb\",\"c1\"\n"
+        "5,\"d1\"\n"
+        ",\"e1\"\n"
+        ",\"f1\"\n"
+        "6,\"g1\"\n",
+        run(false, "x,s", lines, {"x + x", "s + 1"}));
+    EXPECT_EQ("[2]\n[\"bb\"]\n[null]\n[1]\n",
+        run(true, "", {"{\"x\": 1}", "{\"x\": \"b\"}", "{\"y\": 1}",
+            "{\"x\": 0.5}"}, {"x + x"}));
+}
+
+TEST(Stream, BadRows)
+{
+    // rows that do not parse are written empty, neither evaluated nor
+    // counted as errors of the expressions
+    std::size_t bad = 0;
+    EXPECT_EQ("3,,1\n,,\n5,,1\n,,\n",
+        run(false, "a,b,s", {"1,2,x", "1,2", "2,3,y", "1,2,z,4"},
+            {"a + b", "s * 1 - 1", "1"}, &bad));
+    EXPECT_EQ(2u, bad);
+    EXPECT_EQ("[3, 1]\n[null, null]\n[null, 1]\n",
+        run(true, "", {"{\"a\": 1, \"b\": 2}", "{\"a\": 1,",
+            "{\"a\": \"x\"}"}, {"a + b", "1"}, &bad));
+    EXPECT_EQ(1u, bad);
+}
+
+TEST(Stream, Numbers)
+{
+    // numbers as the expressions write them, anything else is a string
+    const std::vector<std::pair<std::string, double> > numbers = {
+        {"1", 1}, {"-2.5", -2.5}, {"1e3", 1000}, {".5", 0.5},
+        {"1e400", HUGE_VAL}, {"-1e400", -HUGE_VAL}, {"1e-400", 0}
+    };
+    const std::vector<std::string> strings = {
+        "0x10", "nan", "inf", "-inf", " 1", "1 ", "+1", "1e", "-", "1.5x"
+    };
+    rows::Cells c;
+    c.resize(numbers.size() + strings.size());
+    std::size_t row = 0;
+    for (const auto &n : numbers) {
+        rows::set(c, row, rows::Field{Span(n.first), false});
+        EXPECT_EQ(rows::REAL, c.kind[row]) << n.first;
+        EXPECT_EQ(n.second, c.real[row]) << n.first;
+        ++row;
+    }
+    for (const auto &str : strings) {
+        rows::set(c, row, rows::Field{Span(str), false});
+        EXPECT_EQ(rows::STRING, c.kind[row]) << str;
+        EXPECT_EQ(str, c.str[row].str());
+        ++row;
+    }
+
+    std::deque<std::string> decoded;
+    for (const auto &n : numbers) {
+        const std::string line = "{\"x\": " + n.first + "}";
+        rows::Json json(line, decoded);
+        double real = 0;
+        EXPECT_TRUE(json.object([&](Span, rows::Kind kind, Span, double r) {
+            EXPECT_EQ(rows::REAL, kind);
+            real = r;
+        })) << line;
+        EXPECT_EQ(n.second, real) << line;
+    }
+    for (const auto &str : strings) {
+        if (str.front() == ' ' || str.back() == ' ') {
+            continue;  // spaces around values are JSON
+        }
+        const std::string line = "{\"x\": " + str + "}";
+        rows::Json json(line, decoded);
+        EXPECT_FALSE(json.object([](Span, rows::Kind, Span, double) {}))
+            << line;
+    }
+}
+
+TEST(Stream, NotFinite)
+{
+    // JSON has neither infinities nor NaN
+    const std::vector<std::string> exprs = {
+        "x * 10", "-x * 10", "x * 10 - x * 10", "x"
+    };
+    EXPECT_EQ("inf,-inf,nan,1e+308\n",
+        run(false, "x", {"1e308"}, exprs));
+    EXPECT_EQ("[null, null, null, 1e+308]\n",
+        run(true, "", {"{\"x\": 1e308}"}, exprs));
+    EXPECT_EQ("0.1,0.30000000000000004\n",
+        run(false, "x", {"0.1"}, {"x", "x + 0.2"}));
+}
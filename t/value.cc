@@ -0,0 +1,73 @@
+#include "../src/ast.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <utility>
+
+TEST(Value, Ctor)
+{
+    EXPECT_FALSE(Value());
+    EXPECT_EQ(Ast::T::NUMBER, Value(1.5).t());
+    EXPECT_EQ(1.5, Value(1.5).num());
+    EXPECT_EQ(Ast::T::BOOLEAN, Value(true).t());
+    EXPECT_TRUE(Value(true).b());
+    EXPECT_EQ(Ast::T::STRING, Value(std::string("wu")).t());
+    EXPECT_EQ("wu", Value(std::string("wu")).str());
+    EXPECT_EQ("", Value(std::string()).str());
+}
+
+TEST(Value, SmallAndShared)
+{
+    const std::string small(Value::SMALL, 's');
+    const std::string large(Value::SMALL + 1, 'l');
+    Value a(small);
+    Value b(large);
+    EXPECT_EQ(small, a.str());
+    EXPECT_EQ(large, b.str());
+    EXPECT_NE(small.data(), a.data());
+    Value c(b);
+    EXPECT_EQ(b.data(), c.data()); // shared, not copied
+    Value d(std::move(c));
+    EXPECT_EQ(b.data(), d.data());
+    EXPECT_FALSE(c);
+    d = a;
+    EXPECT_EQ(small, d.str());
+    d = Value(3.0);
+    EXPECT_EQ(Ast::T::NUMBER, d.t());
+    EXPECT_EQ(large, b.str());
+}
+
+TEST(Value, Compare)
+{
+    EXPECT_EQ(0, Value(std::string("ab")).compare(Value(std::string("ab"))));
+    EXPECT_GT(0, Value(std::string("a")).compare(Value(std::string("ab"))));
+    EXPECT_LT(0, Value(std::string("b")).compare(Value(std::string("ab"))));
+    EXPECT_GT(0, Value(std::string()).compare(Value(std::string("a"))));
+}
+
+TEST(Value, Ast)
+{
+    EXPECT_EQ(2.0, Value::fromAst(*Ast::make(2.0)).num());
+    EXPECT_EQ("wu", Value::fromAst(*Ast::makeString("wu")).str());
+    EXPECT_FALSE(Value::fromAst(*Ast::makeSymbol("wu")));
+    EXPECT_EQ(Ast::T::BOOLEAN, Value(false).toAst()->t);
+    EXPECT_FALSE(static_cast<bool>(Value().toAst()));
+}
+
+TEST(Value, Evaluate)
+{
+    std::istringstream s("a+\" is a rather long string literal\"");
+    auto t = Parser(s).parseExpr();
+    Value::Dict d;
+    d["a"] = Value(std::string("this"));
+    std::string msg;
+    const auto v = evaluate(t, d, msg);
+    ASSERT_TRUE(v);
+    EXPECT_EQ("this is a rather long string literal", v.str());
+    d.clear();
+    EXPECT_FALSE(evaluate(t, d, msg));
+    EXPECT_EQ("unsolvable symbol a", msg);
+}
@@ -0,0 +1,173 @@
+#include "../src/ast.h"
+#include "../src/parser.h"
+#include "../src/value.h"
+#include "../src/vm.h"
+#include "corpus.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+static void expectSame(const Ast::Ptr &e, const Ast::Ptr &v, const char *str)
+{
+    ASSERT_EQ(static_cast<bool>(e), static_cast<bool>(v)) << str;
+    if (!e) {
+        return;
+    }
+    ASSERT_EQ(e->t, v->t) << str;
+    switch (e->t) {
+        case Ast::T::NUMBER:
+            EXPECT_EQ(e->num, v->num) << str;
+            break;
+        case Ast::T::BOOLEAN:
+            EXPECT_EQ(e->b, v->b) << str;
+            break;
+        default:
+            EXPECT_EQ(e->str, v->str) << str;
+            break;
+    }
+}
+
+TEST(Vm, Compile)
+{
+    std::istringstream s("a*2+a");
+    auto t = Parser(s).parseExpr();
+    const auto p = compile(t);
+    ASSERT_EQ(5u, p.code.size());
+    EXPECT_EQ(Program::Code::LOAD, p.code[0].code);
+    EXPECT_EQ(Program::Code::CONST, p.code[1].code);
+    EXPECT_EQ(Program::Code::LOAD, p.code[2].code);
+    EXPECT_EQ(Program::Code::MUL, p.code[3].code);
+    EXPECT_EQ(Program::Code::ADD, p.code[4].code);
+    EXPECT_EQ(1u, p.symbols.size());
+    EXPECT_EQ(1u, p.consts.size());
+    EXPECT_EQ(3u, p.depth);
+}
+
+TEST(Vm, EmptyProgram)
+{
+    std::string msg;
+    EXPECT_FALSE(run(compile(nullptr), Value::Dict(), msg));
+}
+
+TEST(Vm, SameAsEval)
+{
+    Ast::Dict numbers;
+    numbers["a"] = Ast::make(2.0);
+    numbers["a.f()"] = Ast::make(1.0);
+    Ast::Dict strings;
+    strings["a"] = Ast::makeString("a");
+    for (const auto str : evalCorpus) {
+        std::istringstream s(str);
+        auto t = Parser(s).parseExpr();
+        ASSERT_TRUE(static_cast<bool>(t)) << str;
+        for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+            const auto p = compile(t, mode);
+            for (const auto d : {&numbers, &strings}) {
+                Value::Dict values;
+                for (const auto &i : *d) {
+                    values[i.first] = Value::fromAst(*i.second);
+                }
+                std::string emsg, vmsg;
+                const auto e = eval(t, *d, emsg, mode);
+                const auto v = run(p, values, vmsg);
+                expectSame(e, v.toAst(), str);
+                EXPECT_EQ(emsg, vmsg) << str;
+            }
+        }
+    }
+}
+
+TEST(Vm, ShortCircuit)
+{
+    for (const auto str : {
+        "false && x", "true || x", "x && false", "true && x", "false || x",
+        "(a > 1 && x) || (a < 1 || x)", "!(false && x) && (true || x)",
+        "a == 2 && (a > 1 || x) && (a < 1 && x || true)"
+    }) {
+        std::istringstream s(str);
+        auto t = Parser(s).parseExpr();
+        ASSERT_TRUE(static_cast<bool>(t)) << str;
+        const auto p = compile(t, EvalMode::SHORT_CIRCUIT);
+        Ast::Dict d;
+        d["a"] = Ast::make(2.0);
+        Value::Dict values;
+        values["a"] = Value(2.0);
+        std::string emsg, vmsg;
+        const auto e = eval(t, d, emsg, EvalMode::SHORT_CIRCUIT);
+        const auto v = run(p, values, vmsg);
+        expectSame(e, v.toAst(), str);
+        EXPECT_EQ(emsg, vmsg) << str;
+    }
+}
+
+static std::size_t countCode(const Program &p, Program::Code c)
+{
+    std::size_t n = 0;
+    for (const auto &i : p.code) {
+        n += i.code == c;
+    }
+    return n;
+}
+
+TEST(Vm, CommonSubexpressions)
+{
+    std::istringstream s("(a*3-1)^2 + (a*3-1)*a");
+    auto t = Parser(s).parseExpr();
+    ASSERT_TRUE(static_cast<bool>(t));
+    for (const auto mode : {EvalMode::STRICT, EvalMode::SHORT_CIRCUIT}) {
+        const auto p = compile(t, mode);
+        EXPECT_EQ(1u, countCode(p, Program::Code::SUB));
+        EXPECT_EQ(2u, countCode(p, Program::Code::MUL));
+        EXPECT_EQ(1u, countCode(p, Program::Code::STORE));
+        EXPECT_EQ(1u, countCode(p, Program::Code::FETCH));
+        EXPECT_EQ(0u, countCode(p, Program::Code::CACHED));
+        EXPECT_EQ(1u, p.slots);
+        Value::Dict values;
+        values["a"] = Value(2.0);
+        std::string msg;
+        const auto v = run(p, values, msg);
+        ASSERT_TRUE(static_cast<bool>(v)) << msg;
+        EXPECT_EQ(25.0 + 5.0 * 2, v.num());
+    }
+}
+
+TEST(Vm, CachedAfterJump)
+{
+    // the first a*2>1 is skipped for a == 0, the second one must compute
+    // it, for a == 1 the second one takes the stored value
+    std::istringstream s("(a > 0 && a*2>1) || a*2>1");
+    auto t = Parser(s).parseExpr();
+    ASSERT_TRUE(static_cast<bool>(t));
+    const auto p = compile(t, EvalMode::SHORT_CIRCUIT);
+    EXPECT_EQ(1u, countCode(p, Program::Code::CACHED));
+    EXPECT_EQ(2u, countCode(p, Program::Code::STORE));
+    EXPECT_EQ(3u, countCode(p, Program::Code::GT));
+    for (const double a : {0.0, 1.0}) {
+        Value::Dict values;
+        values["a"] = Value(a);
+        std::string msg;
+        const auto v = run(p, values, msg);
+        ASSERT_TRUE(static_cast<bool>(v)) << msg;
+        EXPECT_EQ(a > 0, v.b());
+    }
+}
+
+TEST(Vm, Bind)
+{
+    std::istringstream s("b - a");
+    auto t = Parser(s).parseExpr();
+    auto p = compile(t);
+    const std::vector<Atom> first = {Atom("a"), Atom("b")};
+    EXPECT_EQ(first, p.symbols);
+    bindSlots(p, {"c", "b", "a"});
+    const std::vector<Atom> slots = {Atom("c"), Atom("b"), Atom("a")};
+    EXPECT_EQ(slots, p.symbols);
+    const Value args[] = {Value(), Value(5.0), Value(2.0)};
+    std::string msg;
+    const auto v = run(p, args, msg);
+    ASSERT_TRUE(static_cast<bool>(v)) << msg;
+    EXPECT_EQ(3, v.num());
+    const Value unbound[] = {Value(), Value(5.0), Value()};
+    EXPECT_FALSE(run(p, unbound, msg));
+    EXPECT_EQ("unsolvable symbol a", msg);
+}